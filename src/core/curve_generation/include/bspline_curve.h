@@ -23,6 +23,11 @@
 #define SPLINE_MODE_INTERPOLATION 0
 #define SPLINE_MODE_APPROXIMATION 1
 
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <Eigen/Dense>
+
 #include "curve.h"
 
 namespace trajectory_generation
@@ -61,6 +66,23 @@ public:
    */
   bool run(const Poses2d points, Points2d& path);
 
+  /**
+   * @brief Running trajectory generation with uniform spaced parameters and interpolation. In that case the
+   *        trajectory is a fixed linear map of the data points, which is cached per (points number, order, step),
+   *        so a call is one dense matrix product into the reused output buffer.
+   * @param points data points, one row <x, y> per point
+   * @param path   generated trajectory, only reallocated if its shape changes
+   * @return true if generate successfully, else failed
+   */
+  bool runUniform(const Eigen::Ref<const Eigen::MatrixX2d>& points, Eigen::MatrixX2d& path);
+
+  /**
+   * @brief Get the cached matrix mapping n data points to the trajectory with uniform spaced parameters
+   * @param n The number of data points
+   * @return basis The (1 / step) x n basis matrix
+   */
+  const Eigen::MatrixXd& uniformBasis(int n);
+
   /**
    * @brief Calculate base function using Cox-deBoor function.
    * @param i       The index of base function
@@ -69,7 +91,7 @@ public:
    * @param knot    Knot vector
    * @return  Nik_t The value of base function Nik(t)
    */
-  double baseFunction(int i, int k, double t, std::vector<double> knot);
+  double baseFunction(int i, int k, double t, const std::vector<double>& knot);
 
   /**
    * @brief Calculate parameters using the `uniform spaced` or `chrod length` or `centripetal` method.
@@ -139,6 +161,9 @@ protected:
   int order_;        // Degree of curve
   int param_mode_;   // Parameterization mode
   int spline_mode_;  // B-Spline generation mode
+
+  std::map<std::tuple<int, int, double>, Eigen::MatrixXd> basis_cache_;  // (points number, order, step) -> basis
+  std::mutex basis_lock_;                                                 // protects basis_cache_
 };
 }  // namespace trajectory_generation
 
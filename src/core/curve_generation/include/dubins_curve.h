@@ -22,6 +22,7 @@
 #define DUBINS_S 1
 #define DUBINS_R 2
 #define DUBINS_MAX 1e10
+#define DUBINS_EPS 1e-9
 
 #include "curve.h"
 
@@ -146,6 +147,23 @@ public:
    */
   Points2d generation(Pose2d start, Pose2d goal);
 
+  /**
+   * @brief Length of the shortest curve between two poses, without interpolating it
+   * @param start Initial pose (x, y, yaw)
+   * @param goal  Target pose (x, y, yaw)
+   * @return length the length of the curve, DUBINS_MAX if no curve exists
+   */
+  double distance(Pose2d start, Pose2d goal);
+
+  /**
+   * @brief Length and motion segments of the shortest curve between two poses, without interpolating it
+   * @param start    Initial pose (x, y, yaw)
+   * @param goal     Target pose (x, y, yaw)
+   * @param segments mode (DUBINS_L, DUBINS_S or DUBINS_R) and length of each segment from the start
+   * @return length the length of the curve, DUBINS_MAX if no curve exists
+   */
+  double distance(Pose2d start, Pose2d goal, std::vector<std::pair<int, double>>& segments);
+
   /**
    * @brief Configure the maximum curvature.
    * @param max_curv  the maximum curvature
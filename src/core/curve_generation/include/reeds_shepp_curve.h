@@ -218,6 +218,24 @@ public:
    */
   Points2d generation(Pose2d start, Pose2d goal);
 
+  /**
+   * @brief Length of the shortest curve between two poses, without interpolating it
+   * @param start Initial pose (x, y, yaw)
+   * @param goal  Target pose (x, y, yaw)
+   * @return length the length of the curve, REEDS_SHEPP_MAX if no curve exists
+   */
+  double distance(Pose2d start, Pose2d goal);
+
+  /**
+   * @brief Length and motion segments of the shortest curve between two poses, without interpolating it
+   * @param start    Initial pose (x, y, yaw)
+   * @param goal     Target pose (x, y, yaw)
+   * @param segments mode (REEDS_SHEPP_L, REEDS_SHEPP_S or REEDS_SHEPP_R) and signed length of each segment from the
+   *                 start, negative when reversing
+   * @return length the length of the curve, REEDS_SHEPP_MAX if no curve exists
+   */
+  double distance(Pose2d start, Pose2d goal, std::vector<std::pair<int, double>>& segments);
+
   /**
    * @brief Configure the maximum curvature.
    * @param max_curv  the maximum curvature
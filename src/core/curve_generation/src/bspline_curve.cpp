@@ -51,7 +51,7 @@ BSpline::~BSpline()
  * @param knot    Knot vector
  * @return  Nik_t The value of base function Nik(t)
  */
-double BSpline::baseFunction(int i, int k, double t, std::vector<double> knot)
+double BSpline::baseFunction(int i, int k, double t, const std::vector<double>& knot)
 {
   double Nik_t = 0;
 
@@ -276,6 +276,24 @@ bool BSpline::run(const Points2d points, Points2d& path)
     return false;
   else
   {
+    // cached linear map
+    if ((param_mode_ == PARAM_MODE_UNIFORMSPACED) && (spline_mode_ == SPLINE_MODE_INTERPOLATION))
+    {
+      Eigen::MatrixX2d D(points.size(), 2), P;
+      for (size_t i = 0; i < points.size(); i++)
+      {
+        D(i, 0) = points[i].first;
+        D(i, 1) = points[i].second;
+      }
+      runUniform(D, P);
+
+      path.resize(P.rows());
+      for (int i = 0; i < P.rows(); i++)
+        path[i] = { P(i, 0), P(i, 1) };
+
+      return !path.empty();
+    }
+
     Points2d control_pts;
     std::vector<double> params = paramSelection(points);
     std::vector<double> knot = knotGeneration(params, points.size());
@@ -310,6 +328,63 @@ bool BSpline::run(const Poses2d points, Points2d& path)
   return run(points_pair, path);
 }
 
+/**
+ * @brief Running trajectory generation with uniform spaced parameters and interpolation. In that case the
+ *        trajectory is a fixed linear map of the data points, which is cached per (points number, order, step),
+ *        so a call is one dense matrix product into the reused output buffer.
+ * @param points data points, one row <x, y> per point
+ * @param path   generated trajectory, only reallocated if its shape changes
+ * @return true if generate successfully, else failed
+ */
+bool BSpline::runUniform(const Eigen::Ref<const Eigen::MatrixX2d>& points, Eigen::MatrixX2d& path)
+{
+  if (points.rows() < 4)
+    return false;
+
+  const Eigen::MatrixXd& basis = uniformBasis(static_cast<int>(points.rows()));
+  path.resize(basis.rows(), 2);
+  path.noalias() = basis * points;
+
+  return path.rows() > 0;
+}
+
+/**
+ * @brief Get the cached matrix mapping n data points to the trajectory with uniform spaced parameters
+ * @param n The number of data points
+ * @return basis The (1 / step) x n basis matrix
+ */
+const Eigen::MatrixXd& BSpline::uniformBasis(int n)
+{
+  std::lock_guard<std::mutex> lock(basis_lock_);
+  auto key = std::make_tuple(n, order_, step_);
+  auto it = basis_cache_.find(key);
+  if (it != basis_cache_.end())
+    return it->second;
+
+  // interpolation basis at the uniform parameters
+  std::vector<double> param(n);
+  for (int i = 0; i < n; i++)
+    param[i] = (double)(i) / (double)(n - 1);
+  std::vector<double> knot = knotGeneration(param, n);
+
+  Eigen::MatrixXd N_inter = Eigen::MatrixXd::Zero(n, n);
+  for (int i = 0; i < n; i++)
+    for (int j = 0; j < n; j++)
+      N_inter(i, j) = baseFunction(j, order_, param[i], knot);
+  N_inter(n - 1, n - 1) = 1;
+
+  // generation basis at the sampling parameters
+  int m = static_cast<int>(1.0 / step_);
+  Eigen::MatrixXd N_gen(m, n);
+  for (int i = 0; i < m; i++)
+    for (int j = 0; j < n; j++)
+      N_gen(i, j) = baseFunction(j, order_, (double)(i) / (double)(m - 1), knot);
+  N_gen(m - 1, n - 1) = 1.0;
+
+  // trajectory = N_gen * control points = N_gen * N_inter^-1 * data points
+  return basis_cache_.emplace(key, N_gen * N_inter.inverse()).first->second;
+}
+
 /**
  * @brief Configure the degree of the curve.
  * @param order  The degree of curve
@@ -15,6 +15,7 @@
  * ********************************************************
  */
 #include <Eigen/Dense>
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include "dubins_curve.h"
@@ -55,14 +56,14 @@ void Dubins::LSL(double alpha, double beta, double dist, DubinsLength& length, D
   UNPACK_DUBINS_INPUTS(alpha, beta);
   double p_lsl = 2 + std::pow(dist, 2) - 2 * cos_a_b + 2 * dist * (sin_a - sin_b);
 
-  if (p_lsl < 0)
+  if (p_lsl < -DUBINS_EPS)
   {
     length = { DUBINS_NONE, DUBINS_NONE, DUBINS_NONE };
     mode = { DUBINS_L, DUBINS_S, DUBINS_L };
   }
   else
   {
-    p_lsl = sqrt(p_lsl);
+    p_lsl = sqrt(std::max(p_lsl, 0.0));
     double t_lsl = helper::mod2pi(-alpha + atan2(cos_b - cos_a, dist + sin_a - sin_b));
     double q_lsl = helper::mod2pi(beta - atan2(cos_b - cos_a, dist + sin_a - sin_b));
     length = { t_lsl, p_lsl, q_lsl };
@@ -82,14 +83,14 @@ void Dubins::RSR(double alpha, double beta, double dist, DubinsLength& length, D
 {
   UNPACK_DUBINS_INPUTS(alpha, beta);
   double p_rsr = 2 + std::pow(dist, 2) - 2 * cos_a_b + 2 * dist * (sin_b - sin_a);
-  if (p_rsr < 0)
+  if (p_rsr < -DUBINS_EPS)
   {
     length = { DUBINS_NONE, DUBINS_NONE, DUBINS_NONE };
     mode = { DUBINS_R, DUBINS_S, DUBINS_R };
   }
   else
   {
-    p_rsr = sqrt(p_rsr);
+    p_rsr = sqrt(std::max(p_rsr, 0.0));
     double t_rsr = helper::mod2pi(alpha - atan2(cos_a - cos_b, dist - sin_a + sin_b));
     double q_rsr = helper::mod2pi(-beta + atan2(cos_a - cos_b, dist - sin_a + sin_b));
     length = { t_rsr, p_rsr, q_rsr };
@@ -110,14 +111,14 @@ void Dubins::LSR(double alpha, double beta, double dist, DubinsLength& length, D
   UNPACK_DUBINS_INPUTS(alpha, beta);
   double p_lsr = -2 + std::pow(dist, 2) + 2 * cos_a_b + 2 * dist * (sin_a + sin_b);
 
-  if (p_lsr < 0)
+  if (p_lsr < -DUBINS_EPS)
   {
     length = { DUBINS_NONE, DUBINS_NONE, DUBINS_NONE };
     mode = { DUBINS_L, DUBINS_S, DUBINS_R };
   }
   else
   {
-    p_lsr = sqrt(p_lsr);
+    p_lsr = sqrt(std::max(p_lsr, 0.0));
     double t_lsr = helper::mod2pi(-alpha + atan2(-cos_a - cos_b, dist + sin_a + sin_b) - atan2(-2.0, p_lsr));
     double q_lsr = helper::mod2pi(-beta + atan2(-cos_a - cos_b, dist + sin_a + sin_b) - atan2(-2.0, p_lsr));
     length = { t_lsr, p_lsr, q_lsr };
@@ -138,14 +139,14 @@ void Dubins::RSL(double alpha, double beta, double dist, DubinsLength& length, D
   UNPACK_DUBINS_INPUTS(alpha, beta);
   double p_rsl = -2 + std::pow(dist, 2) + 2 * cos_a_b - 2 * dist * (sin_a + sin_b);
 
-  if (p_rsl < 0)
+  if (p_rsl < -DUBINS_EPS)
   {
     length = { DUBINS_NONE, DUBINS_NONE, DUBINS_NONE };
     mode = { DUBINS_R, DUBINS_S, DUBINS_L };
   }
   else
   {
-    p_rsl = sqrt(p_rsl);
+    p_rsl = sqrt(std::max(p_rsl, 0.0));
     double t_rsl = helper::mod2pi(alpha - atan2(cos_a + cos_b, dist - sin_a - sin_b) + atan2(2.0, p_rsl));
     double q_rsl = helper::mod2pi(beta - atan2(cos_a + cos_b, dist - sin_a - sin_b) + atan2(2.0, p_rsl));
     length = { t_rsl, p_rsl, q_rsl };
@@ -192,7 +193,7 @@ void Dubins::RLR(double alpha, double beta, double dist, DubinsLength& length, D
 void Dubins::LRL(double alpha, double beta, double dist, DubinsLength& length, DubinsMode& mode)
 {
   UNPACK_DUBINS_INPUTS(alpha, beta);
-  double p_lrl = (6.0 - std::pow(dist, 2) + 2.0 * cos_a_b + 2.0 * dist * (sin_a - sin_b)) / 8.0;
+  double p_lrl = (6.0 - std::pow(dist, 2) + 2.0 * cos_a_b + 2.0 * dist * (sin_b - sin_a)) / 8.0;
 
   if (fabs(p_lrl) > 1.0)
   {
@@ -343,6 +344,63 @@ Points2d Dubins::generation(Pose2d start, Pose2d goal)
   return path;
 }
 
+/**
+ * @brief Length of the shortest curve between two poses, without interpolating it
+ * @param start Initial pose (x, y, yaw)
+ * @param goal  Target pose (x, y, yaw)
+ * @return length the length of the curve, DUBINS_MAX if no curve exists
+ */
+double Dubins::distance(Pose2d start, Pose2d goal)
+{
+  std::vector<std::pair<int, double>> segments;
+  return distance(start, goal, segments);
+}
+
+/**
+ * @brief Length and motion segments of the shortest curve between two poses, without interpolating it
+ * @param start    Initial pose (x, y, yaw)
+ * @param goal     Target pose (x, y, yaw)
+ * @param segments mode (DUBINS_L, DUBINS_S or DUBINS_R) and length of each segment from the start
+ * @return length the length of the curve, DUBINS_MAX if no curve exists
+ */
+double Dubins::distance(Pose2d start, Pose2d goal, std::vector<std::pair<int, double>>& segments)
+{
+  double sx, sy, syaw;
+  double gx, gy, gyaw;
+  std::tie(sx, sy, syaw) = start;
+  std::tie(gx, gy, gyaw) = goal;
+
+  // coordinate transformation
+  gx -= sx;
+  gy -= sy;
+  double theta = helper::mod2pi(atan2(gy, gx));
+  double dist = hypot(gx, gy) * max_curv_;
+  double alpha = helper::mod2pi(syaw - theta);
+  double beta = helper::mod2pi(gyaw - theta);
+
+  // select the best motion
+  DubinsMode best_mode, mode;
+  double best_cost = DUBINS_MAX;
+  DubinsLength length;
+  DubinsLength best_length = { DUBINS_NONE, DUBINS_NONE, DUBINS_NONE };
+
+  for (const auto solver : dubins_solvers)
+  {
+    (this->*solver)(alpha, beta, dist, length, mode);
+    _update(length, mode, best_length, best_mode, best_cost);
+  }
+
+  segments.clear();
+  if (best_cost == DUBINS_MAX)
+    return DUBINS_MAX;
+
+  // the segments are relative to the heading, so they apply to the start pose as they are
+  segments.emplace_back(std::get<0>(best_mode), std::get<0>(best_length) / max_curv_);
+  segments.emplace_back(std::get<1>(best_mode), std::get<1>(best_length) / max_curv_);
+  segments.emplace_back(std::get<2>(best_mode), std::get<2>(best_length) / max_curv_);
+  return best_cost / max_curv_;
+}
+
 /**
  * @brief Running trajectory generation
  * @param points path points <x, y>
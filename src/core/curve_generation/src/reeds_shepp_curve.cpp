@@ -964,6 +964,64 @@ Points2d ReedsShepp::generation(Pose2d start, Pose2d goal)
   return path;
 }
 
+/**
+ * @brief Length of the shortest curve between two poses, without interpolating it
+ * @param start Initial pose (x, y, yaw)
+ * @param goal  Target pose (x, y, yaw)
+ * @return length the length of the curve, REEDS_SHEPP_MAX if no curve exists
+ */
+double ReedsShepp::distance(Pose2d start, Pose2d goal)
+{
+  std::vector<std::pair<int, double>> segments;
+  return distance(start, goal, segments);
+}
+
+/**
+ * @brief Length and motion segments of the shortest curve between two poses, without interpolating it
+ * @param start    Initial pose (x, y, yaw)
+ * @param goal     Target pose (x, y, yaw)
+ * @param segments mode (REEDS_SHEPP_L, REEDS_SHEPP_S or REEDS_SHEPP_R) and signed length of each segment from the
+ *                 start, negative when reversing
+ * @return length the length of the curve, REEDS_SHEPP_MAX if no curve exists
+ */
+double ReedsShepp::distance(Pose2d start, Pose2d goal, std::vector<std::pair<int, double>>& segments)
+{
+  double sx, sy, syaw;
+  double gx, gy, gyaw;
+  std::tie(sx, sy, syaw) = start;
+  std::tie(gx, gy, gyaw) = goal;
+
+  // coordinate transformation
+  double dx = gx - sx;
+  double dy = gy - sy;
+  double dyaw = gyaw - syaw;
+  double x = (cos(syaw) * dx + sin(syaw) * dy) * max_curv_;
+  double y = (-sin(syaw) * dx + cos(syaw) * dy) * max_curv_;
+
+  // select the best motion
+  RSPath best_path({ REEDS_SHEPP_MAX }, { REEDS_SHEPP_NONE });
+
+  _update(SCS(x, y, dyaw), best_path);
+  _update(CCC(x, y, dyaw), best_path);
+  _update(CSC(x, y, dyaw), best_path);
+  _update(CCCC(x, y, dyaw), best_path);
+  _update(CCSC(x, y, dyaw), best_path);
+  _update(CCSCC(x, y, dyaw), best_path);
+
+  segments.clear();
+  if (best_path.len() == REEDS_SHEPP_MAX)
+    return REEDS_SHEPP_MAX;
+
+  for (size_t i = 0; i < best_path.size(); i++)
+  {
+    double length;
+    int ctype;
+    best_path.get(i, length, ctype);
+    segments.emplace_back(ctype, length / max_curv_);
+  }
+  return best_path.len() / max_curv_;
+}
+
 /**
  * @brief Running trajectory generation
  * @param points path points <x, y>
@@ -18,11 +18,14 @@
 #define ACO_H
 
 #include <random>
-#include <thread>
-#include <mutex>
+#include <unordered_map>
 #include <vector>
 #include "global_planner.h"
 #include "bspline_curve.h"
+#include "thread_pool.h"
+#include "population.h"
+#include "fitness_cache.h"
+#include "footprint_checker.h"
 
 #define GEN_MODE_RANDOM 1
 #define GEN_MODE_CIRCLE 2
@@ -31,21 +34,6 @@ using PositionSequence = std::vector<std::vector<std::pair<int, int>>>;
 
 namespace global_planner
 {
-struct Ant
-{
-  std::vector<std::pair<int, int>> position;  // genets position
-  double fitness;                             // genets fitness
-  std::vector<std::pair<int, int>> best_pos;  // Personal best position in iteration
-  double best_fitness;                        // Personal best fitness in iteration
-
-  Ant() = default;
-
-  Ant(const std::vector<std::pair<int, int>>& initial_position, double initial_fitness)
-    : position(initial_position), fitness(initial_fitness), best_pos(initial_position), best_fitness(initial_fitness)
-  {
-  }
-};
-
 /**
  * @brief Class for objects that plan using the GA algorithm
  */
@@ -89,21 +77,61 @@ public:
 
   /**
    * @brief Calculate the value of fitness function
-   * @param position  the control points calculated by PSO
+   * @param x  x of the control points calculated by ACO, point_num_ elements
+   * @param y  y of the control points calculated by ACO, point_num_ elements
    * @return fitness the value of fitness function
    */
-  double calFitnessValue(std::vector<std::pair<int, int>> position);
+  double calFitnessValue(const int* x, const int* y);
+
+  /**
+   * @brief Check collisions with the robot footprint along the path, besides the centre cell against the inflated
+   *        costmap
+   * @param footprint footprint vertices in the robot frame in meters, empty to check the centre cell only
+   */
+  void setFootprint(const std::vector<std::pair<double, double>>& footprint);
+
+  /**
+   * @brief Get the fitness cache of the last planning query
+   * @return fitness cache
+   */
+  const FitnessCache& getFitnessCache() const;
 
   /**
    * @brief Ant update optimization iteration
-   * @param ant       Ants to be updated for velocity
-   * @param best_ant  Global optimal ant
-   * @param gen            randomizer
-   * @param expand         containing the node been search during the process
+   * @param i         ant index
+   * @param expand    expand buffer of the calling worker
+   * @param deposit   pheromone deposit buffer of the calling worker
    */
-  void optimizeAnt(Ant& ant, Ant& best_ant, std::mt19937& gen, std::vector<Node>& expand);
+  void optimizeAnt(int i, std::vector<Node>& expand, std::vector<std::pair<int, double>>& deposit);
 
-  void updateAnts(std::vector<Ant>& ants, const Node& start, const Node& goal, Ant& best_ant);
+  /**
+   * @brief Generate the ants of a new iteration, evaluate them and update the global optimal ant
+   * @param start     start node
+   * @param goal      goal node
+   */
+  void updateAnts(const Node& start, const Node& goal);
+
+protected:
+  /**
+   * @brief Get the pheromone of a cell, evaporation since its last update is applied lazily
+   * @param idx  cell index
+   * @return pheromone of the cell
+   */
+  double _getPheromone(int idx) const;
+
+  /**
+   * @brief Deposit pheromone on a cell
+   * @param idx  cell index
+   * @param c    pheromone increment
+   */
+  void _depositPheromone(int idx, double c);
+
+  /**
+   * @brief Evaporation factor of k iterations, i.e. (1 - rho)^k
+   * @param k  number of iterations
+   * @return evaporation factor
+   */
+  double _decay(int k) const;
 
 protected:
   int point_num_;        // number of position points contained in each ant
@@ -115,12 +143,20 @@ protected:
   int max_iter_;         // maximum iterations
   int init_mode_;        // Set the generation mode for the initial position points of the genets swarm
   std::pair<double, double> start_, goal_;  // paired start and goal point for path smoothing
-  double* pheromone_mat_;                   // pheromone matrix
+  std::unordered_map<int, std::pair<double, int>> pheromone_;  // touched cell -> (pheromone, iteration of update)
+  std::vector<double> decay_;                                 // evaporation factor of k iterations
+  int pheromone_iter_;                                        // number of evaporations applied so far
 
 private:
-  std::mutex lock_;                             // thread lock
-  std::vector<Ant> inherited_ants_;             // inherited ants
-  trajectory_generation::BSpline bspline_gen_;  // Path generation
+  Population ants_;                                               // ants of the current iteration
+  std::vector<int> best_x_, best_y_;                              // position of the global optimal ant
+  double best_fitness_;                                           // fitness of the global optimal ant
+  PositionSequence inherited_ants_;                               // best positions of the inherited ants
+  FitnessCache cache_;                                            // fitness of the evaluated waypoint sequences
+  helper::FootprintChecker footprint_checker_;                    // footprint collision checker, if a footprint is set
+  trajectory_generation::BSpline bspline_gen_;                    // Path generation
+  std::vector<std::vector<Node>> expand_buf_;                     // expand buffer of each worker
+  std::vector<std::vector<std::pair<int, double>>> deposit_buf_;  // pheromone deposit buffer of each worker
 };
 
 }  // namespace global_planner
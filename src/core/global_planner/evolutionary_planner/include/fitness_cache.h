@@ -0,0 +1,115 @@
+/**
+ * *********************************************************
+ *
+ * @file: fitness_cache.h
+ * @brief: Contains the fitness cache shared by the evolutionary planners
+ * @author: Yang Haodong
+ * @date: 2024-10-02
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#ifndef FITNESS_CACHE_H
+#define FITNESS_CACHE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace global_planner
+{
+/**
+ * @brief Thread-safe map from a waypoint sequence to its fitness, valid for one planning request.
+ *        An entry is either the exact fitness or an upper bound left by an evaluation which stopped
+ *        early, the bound answers every lookup whose threshold it does not reach.
+ */
+class FitnessCache
+{
+public:
+  /**
+   * @brief Construct a new Fitness Cache object
+   */
+  FitnessCache();
+
+  /**
+   * @brief Remove all entries and reset the statistics, called whenever the start, goal or map change
+   */
+  void clear();
+
+  /**
+   * @brief Look up the fitness of a waypoint sequence
+   * @param x          x of the waypoints, dim elements
+   * @param y          y of the waypoints, dim elements
+   * @param dim        number of waypoints
+   * @param threshold  fitness the caller is interested in, an upper bound below it is a valid answer
+   * @param fitness    cached exact fitness or upper bound
+   * @return true if the cached value answers the lookup, else false
+   */
+  bool find(const int* x, const int* y, int dim, double threshold, double& fitness);
+
+  /**
+   * @brief Store the fitness of a waypoint sequence, replacing any previous entry
+   * @param x        x of the waypoints, dim elements
+   * @param y        y of the waypoints, dim elements
+   * @param dim      number of waypoints
+   * @param fitness  exact fitness or upper bound
+   * @param exact    whether the fitness is exact
+   */
+  void insert(const int* x, const int* y, int dim, double fitness, bool exact);
+
+  /**
+   * @brief Get the number of lookups and of answered lookups since the last clear()
+   */
+  std::size_t lookups() const;
+  std::size_t hits() const;
+
+protected:
+  /**
+   * @brief Hash of a waypoint sequence
+   * @param x    x of the waypoints, dim elements
+   * @param y    y of the waypoints, dim elements
+   * @param dim  number of waypoints
+   * @return hash value
+   */
+  static std::uint64_t _hash(const int* x, const int* y, int dim);
+
+  /**
+   * @brief Cached value, the waypoints are kept in the key pool of the shard to resolve hash collisions
+   */
+  struct Entry
+  {
+    std::size_t offset;  // first waypoint in the key pool
+    double fitness;      // exact fitness or upper bound
+    bool exact;          // whether the fitness is exact
+  };
+
+  /**
+   * @brief Independently locked part of the cache, selected by the hash
+   */
+  struct Shard
+  {
+    std::mutex lock;
+    std::unordered_map<std::uint64_t, Entry> table;
+    std::vector<int> keys;  // x and y of the cached waypoint sequences, back to back
+  };
+
+  /**
+   * @brief Compare a cached key with a waypoint sequence
+   */
+  static bool _equal(const Shard& shard, const Entry& entry, const int* x, const int* y, int dim);
+
+  static constexpr int kShards = 16;
+  std::array<Shard, kShards> shards_;
+  std::atomic<std::size_t> lookups_, hits_;  // statistics of the current request
+};
+}  // namespace global_planner
+
+#endif  // FITNESS_CACHE_H
@@ -18,11 +18,13 @@
 #define GA_H
 
 #include <random>
-#include <thread>
-#include <mutex>
 #include <vector>
 #include "global_planner.h"
 #include "bspline_curve.h"
+#include "thread_pool.h"
+#include "population.h"
+#include "fitness_cache.h"
+#include "footprint_checker.h"
 
 #define GEN_MODE_RANDOM 1
 #define GEN_MODE_CIRCLE 2
@@ -31,21 +33,6 @@ using PositionSequence = std::vector<std::vector<std::pair<int, int>>>;
 
 namespace global_planner
 {
-struct Genets
-{
-  std::vector<std::pair<int, int>> position;  // genets position
-  double fitness;                             // genets fitness
-  std::vector<std::pair<int, int>> best_pos;  // Personal best position in iteration
-  double best_fitness;                        // Personal best fitness in iteration
-
-  Genets() = default;
-
-  Genets(const std::vector<std::pair<int, int>>& initial_position, double initial_fitness)
-    : position(initial_position), fitness(initial_fitness), best_pos(initial_position), best_fitness(initial_fitness)
-  {
-  }
-};
-
 /**
  * @brief Class for objects that plan using the GA algorithm
  */
@@ -92,29 +79,41 @@ public:
 
   /**
    * @brief Calculate the value of fitness function
-   * @param position  the control points calculated by PSO
+   * @param x          x of the control points calculated by GA, point_num_ elements
+   * @param y          y of the control points calculated by GA, point_num_ elements
+   * @param threshold  the evaluation stops once the fitness falls below it, returning an upper bound
    * @return fitness the value of fitness function
    */
-  double calFitnessValue(std::vector<std::pair<int, int>> position);
+  double calFitnessValue(const int* x, const int* y, double threshold = 0.0);
+
+  /**
+   * @brief Check collisions with the robot footprint along the path, besides the centre cell against the inflated
+   *        costmap
+   * @param footprint footprint vertices in the robot frame in meters, empty to check the centre cell only
+   */
+  void setFootprint(const std::vector<std::pair<double, double>>& footprint);
+
+  /**
+   * @brief Get the fitness cache of the last planning query
+   * @return fitness cache
+   */
+  const FitnessCache& getFitnessCache() const;
 
   /**
    * @brief Perform selection.
    * @param population        The population of Genets.
-   * @param selected_population The selected individuals will be stored in this vector.
+   * @param selected_population The selected individuals will be stored in this population.
    */
-  void selection(const std::vector<Genets>& population, std::vector<Genets>& selected_population);
+  void selection(const Population& population, Population& selected_population);
 
   /**
-   * @brief Genets update optimization iteration
-   * @param genets_p      individuals selected for retention
-   * @param genets_c      descendants of selected individuals to be retained
-   * @param best_genets   Global optimal genets
+   * @brief Genets update optimization iteration, the i-th child is generated from the i-th parent
    * @param i             genets ID
-   * @param gen           randomizer
-   * @param expand        containing the node been search during the process
+   * @param threshold     fitness below which the evaluation of the child may stop early
+   * @param gen           randomizer of the calling worker
+   * @param expand        expand buffer of the calling worker
    */
-  void optimizeGenets(const Genets& genets_p, Genets& genets_c, Genets& best_genets, const int& i, std::mt19937& gen,
-                      std::vector<Node>& expand);
+  void optimizeGenets(int i, double threshold, std::mt19937& gen, std::vector<Node>& expand);
 
 protected:
   int max_iter_;                     // maximum iterations
@@ -127,9 +126,16 @@ protected:
   std::pair<double, double> start_, goal_;  // paired start and goal point for path smoothing
 
 private:
-  std::mutex genets_lock_;                      // thread lock
-  std::vector<Genets> inherited_genets_;        // inherited genets
+  Population swarm_;                            // genets swarm
+  Population parent_, children_;                // selected genets and their descendants
+  PositionSequence inherited_genets_;           // best positions of the inherited genets
+  AliasTable roulette_;                         // roulette wheel of the selection
   trajectory_generation::BSpline bspline_gen_;  // Path generation
+  std::mt19937 gen_;                            // randomizer of the selection
+  std::vector<std::mt19937> gens_;              // randomizer of each worker
+  FitnessCache cache_;                          // fitness of the evaluated waypoint sequences
+  helper::FootprintChecker footprint_checker_;  // footprint collision checker, if a footprint is set
+  std::vector<std::vector<Node>> expand_buf_;   // expand buffer of each worker, merged after each iteration
 };
 
 }  // namespace global_planner
@@ -0,0 +1,176 @@
+/**
+ * *********************************************************
+ *
+ * @file: population.h
+ * @brief: Contains the structure-of-arrays population shared by the evolutionary planners
+ * @author: Yang Haodong
+ * @date: 2024-09-28
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#ifndef POPULATION_H
+#define POPULATION_H
+
+#include <random>
+#include <utility>
+#include <vector>
+#include <Eigen/Dense>
+
+namespace global_planner
+{
+/**
+ * @brief Population of n individuals with dim position points each, stored as contiguous arrays.
+ *        The points of individual i are [i * dim, (i + 1) * dim) of each coordinate array, so the
+ *        update kernels run over the whole population at once.
+ */
+class Population
+{
+public:
+  /**
+   * @brief Construct a new Population object
+   * @param n    number of individuals
+   * @param dim  number of position points of each individual
+   */
+  Population(int n = 0, int dim = 0);
+
+  /**
+   * @brief Reshape the population, all positions, velocities and fitness are reset to zero
+   * @param n    number of individuals
+   * @param dim  number of position points of each individual
+   */
+  void resize(int n, int dim);
+
+  /**
+   * @brief Get the number of individuals and the number of position points of each individual
+   */
+  int size() const;
+  int dim() const;
+
+  /**
+   * @brief Position, velocity and personal best coordinates of individual i, dim() elements each
+   */
+  int* x(int i);
+  int* y(int i);
+  const int* x(int i) const;
+  const int* y(int i) const;
+  int* vx(int i);
+  int* vy(int i);
+  const int* bestX(int i) const;
+  const int* bestY(int i) const;
+
+  /**
+   * @brief Current and personal best fitness of individual i
+   */
+  double& fitness(int i);
+  double fitness(int i) const;
+  double& bestFitness(int i);
+  double bestFitness(int i) const;
+
+  /**
+   * @brief Set the position of individual i, the velocity is cleared
+   * @param i        individual index
+   * @param position position points
+   */
+  void setPosition(int i, const std::vector<std::pair<int, int>>& position);
+
+  /**
+   * @brief Get the position or the personal best position of individual i
+   * @param i        individual index
+   * @param position position points
+   */
+  void getPosition(int i, std::vector<std::pair<int, int>>& position) const;
+  void getBestPosition(int i, std::vector<std::pair<int, int>>& position) const;
+
+  /**
+   * @brief Copy individual j of another population into individual i
+   * @param i    destination individual index
+   * @param src  source population with the same dim()
+   * @param j    source individual index
+   */
+  void copy(int i, const Population& src, int j);
+
+  /**
+   * @brief Set the personal best of every individual to its current position and fitness
+   */
+  void resetBest();
+
+  /**
+   * @brief Update the personal best of all or one individual if the current fitness is better
+   * @param i  individual index
+   */
+  void updateBest();
+  void updateBest(int i);
+
+  /**
+   * @brief Velocity update of the whole population, v = w_i * v + w_s * r1 * (best - p) + w_c * r2 * (g - p)
+   *        with one pair of random numbers per point, then clamped into [-max_speed, max_speed]
+   * @param g_x         global best x, dim() elements
+   * @param g_y         global best y, dim() elements
+   * @param w_inertial  inertia weight
+   * @param w_social    social weight
+   * @param w_cognitive cognitive weight
+   * @param max_speed   maximum velocity
+   * @param gen         randomizer
+   */
+  void updateVelocity(const int* g_x, const int* g_y, double w_inertial, double w_social, double w_cognitive,
+                      int max_speed, std::mt19937& gen);
+
+  /**
+   * @brief Position update of the whole population, p = p + v clamped into [1, x_max - 1] x [1, y_max - 1]
+   * @param x_max  map size along x
+   * @param y_max  map size along y
+   */
+  void updatePosition(int x_max, int y_max);
+
+  /**
+   * @brief Select the k fittest individuals in descending order, O(n + k log k)
+   * @param k             number of individuals
+   * @param indices       selected individual indices
+   * @param personal_best rank by the personal best instead of the current fitness
+   */
+  void elite(int k, std::vector<int>& indices, bool personal_best = false) const;
+
+protected:
+  int n_, dim_;                     // number of individuals and points of each individual
+  Eigen::ArrayXi x_, y_;            // positions
+  Eigen::ArrayXi vx_, vy_;          // velocities
+  Eigen::ArrayXi best_x_, best_y_;  // personal best positions
+  Eigen::ArrayXd fitness_;          // current fitness
+  Eigen::ArrayXd best_fitness_;     // personal best fitness
+  Eigen::ArrayXd r1_, r2_;          // random numbers of the velocity update
+  mutable std::vector<int> order_;  // index buffer of the elite selection
+};
+
+/**
+ * @brief Walker's alias table, O(n) construction and O(1) sampling of a discrete distribution
+ */
+class AliasTable
+{
+public:
+  /**
+   * @brief Build the table
+   * @param weights non-negative weights, at least one of them positive
+   */
+  void build(const Eigen::Ref<const Eigen::ArrayXd>& weights);
+
+  /**
+   * @brief Draw an index with probability proportional to its weight
+   * @param gen randomizer
+   * @return sampled index
+   */
+  int sample(std::mt19937& gen) const;
+
+protected:
+  std::vector<double> prob_;        // probability of keeping the drawn column
+  std::vector<int> alias_;          // alias of each column
+  std::vector<int> small_, large_;  // construction buffers
+};
+}  // namespace global_planner
+
+#endif  // POPULATION_H
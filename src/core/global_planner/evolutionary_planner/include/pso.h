@@ -18,11 +18,13 @@
 #define PSO_H
 
 #include <random>
-#include <thread>
-#include <mutex>
 #include <vector>
 #include "global_planner.h"
 #include "bspline_curve.h"
+#include "thread_pool.h"
+#include "population.h"
+#include "fitness_cache.h"
+#include "footprint_checker.h"
 
 #define GEN_MODE_RANDOM 1
 #define GEN_MODE_CIRCLE 2
@@ -31,27 +33,6 @@ using PositionSequence = std::vector<std::vector<std::pair<int, int>>>;
 
 namespace global_planner
 {
-struct Particle
-{
-  std::vector<std::pair<int, int>> position;  // Particle position
-  std::vector<std::pair<int, int>> velocity;  // Particle velocity
-  double fitness;                             // Particle fitness
-  std::vector<std::pair<int, int>> best_pos;  // Personal best position in iteration
-  double best_fitness;                        // Personal best fitness in iteration
-
-  Particle() = default;
-
-  Particle(const std::vector<std::pair<int, int>>& initial_position,
-           const std::vector<std::pair<int, int>>& initial_velocity, double initial_fitness)
-    : position(initial_position)
-    , velocity(initial_velocity)
-    , fitness(initial_fitness)
-    , best_pos(initial_position)
-    , best_fitness(initial_fitness)
-  {
-  }
-};
-
 /**
  * @brief Class for objects that plan using the PSO algorithm
  */
@@ -98,33 +79,32 @@ public:
 
   /**
    * @brief Calculate the value of fitness function
-   * @param position  the control points calculated by PSO
+   * @param x          x of the control points calculated by PSO, point_num_ elements
+   * @param y          y of the control points calculated by PSO, point_num_ elements
+   * @param threshold  the evaluation stops once the fitness falls below it, returning an upper bound
    * @return fitness the value of fitness function
    */
-  double calFitnessValue(std::vector<std::pair<int, int>> position);
+  double calFitnessValue(const int* x, const int* y, double threshold = 0.0);
 
   /**
-   * @brief A function to update the particle velocity
-   * @param particle     Particles to be updated for velocity
-   * @param global_best  Global optimal particle
-   * @param gen          randomizer
+   * @brief Check collisions with the robot footprint along the path, besides the centre cell against the inflated
+   *        costmap
+   * @param footprint footprint vertices in the robot frame in meters, empty to check the centre cell only
    */
-  void updateParticleVelocity(Particle& particle, const Particle& global_best, std::mt19937& gen);
+  void setFootprint(const std::vector<std::pair<double, double>>& footprint);
 
   /**
-   * @brief A function to update the particle position
-   * @param particle     Particles to be updated for velocity
+   * @brief Get the fitness cache of the last planning query
+   * @return fitness cache
    */
-  void updateParticlePosition(Particle& particle);
+  const FitnessCache& getFitnessCache() const;
 
   /**
-   * @brief Particle update optimization iteration
-   * @param particle       Particles to be updated for velocity
-   * @param best_particle  Global optimal particle
-   * @param gen            randomizer
-   * @param expand         containing the node been search during the process
+   * @brief Particle update optimization iteration, velocity and position are updated for the whole swarm before
+   * @param i       particle index
+   * @param expand  expand buffer of the calling worker
    */
-  void optimizeParticle(Particle& particle, Particle& best_particle, std::mt19937& gen, std::vector<Node>& expand);
+  void optimizeParticle(int i, std::vector<Node>& expand);
 
 protected:
   int max_iter_;     // maximum iterations
@@ -138,9 +118,13 @@ protected:
   std::pair<double, double> start_, goal_;  // paired start and goal point for path smoothing
 
 private:
-  std::mutex particles_lock_;                   // thread lock
-  std::vector<Particle> inherited_particles_;   // inherited particles
+  Population swarm_;                            // particle swarm
+  PositionSequence inherited_particles_;        // best positions of the inherited particles
   trajectory_generation::BSpline bspline_gen_;  // Path generation
+  std::mt19937 gen_;                            // randomizer of the swarm update
+  FitnessCache cache_;                          // fitness of the evaluated waypoint sequences
+  helper::FootprintChecker footprint_checker_;  // footprint collision checker, if a footprint is set
+  std::vector<std::vector<Node>> expand_buf_;   // expand buffer of each worker, merged after each iteration
 };
 
 }  // namespace global_planner
@@ -41,14 +41,21 @@ ACO::ACO(costmap_2d::Costmap2D* costmap, int n_ants, int n_inherited, int point_
   , Q_(Q)
   , init_mode_(init_mode)
   , max_iter_(max_iter)
+  , pheromone_iter_(0)
+  , best_fitness_(-1)
 {
-  inherited_ants_.emplace_back(std::vector<std::pair<int, int>>(point_num, std::make_pair(1, 1)), 0.0);
-  pheromone_mat_ = new double[map_size_];
+  // uniform spaced parameters, so the fitness evaluation can reuse the cached B-spline basis
+  bspline_gen_.setParamMode(PARAM_MODE_UNIFORMSPACED);
+  inherited_ants_.emplace_back(point_num, std::make_pair(1, 1));
+
+  decay_.resize(std::max(max_iter, 0) + 1);
+  decay_[0] = 1.0;
+  for (size_t k = 1; k < decay_.size(); k++)
+    decay_[k] = decay_[k - 1] * (1 - rho_);
 }
 
 ACO::~ACO()
 {
-  delete[] pheromone_mat_;
 }
 
 /**
@@ -64,43 +71,60 @@ bool ACO::plan(const Node& start, const Node& goal, std::vector<Node>& path, std
   start_ = std::pair<double, double>(static_cast<double>(start.x()), static_cast<double>(start.y()));
   goal_ = std::pair<double, double>(static_cast<double>(goal.x()), static_cast<double>(goal.y()));
   expand.clear();
-  for (size_t i = 0; i < map_size_; i++)
-    pheromone_mat_[i] = 1.0;
+  cache_.clear();
+
+  footprint_checker_.update(costmap_->getCharMap(), costmap_->getSizeInCellsX(), costmap_->getSizeInCellsY(),
+                            costmap_2d::LETHAL_OBSTACLE);
+
+  // every cell starts with pheromone 1.0, only the touched ones are stored
+  pheromone_.clear();
+  pheromone_iter_ = 0;
 
   // variable initialization
-  Ant best_ant;
-  best_ant.fitness = -1;
-  std::vector<Ant> ants(n_ants_);
+  best_fitness_ = -1;
+  best_x_.assign(point_num_, 0);
+  best_y_.assign(point_num_, 0);
+  ants_.resize(n_ants_, point_num_);
 
-  updateAnts(ants, start, goal, best_ant);
+  // expand and pheromone deposit buffer of each worker
+  helper::ThreadPool& pool = helper::ThreadPool::instance();
+  expand_buf_.resize(pool.size());
+  deposit_buf_.resize(pool.size());
 
-  // random data
-  std::random_device rd;
-  std::mt19937 gen(rd());
+  updateAnts(start, goal);
 
   // Iterative optimization
   for (size_t iter = 0; iter < max_iter_; iter++)
   {
-    updateAnts(ants, start, goal, best_ant);
-    std::vector<std::thread> ants_list = std::vector<std::thread>(n_ants_);
-    for (size_t i = 0; i < n_ants_; ++i)
-      ants_list[i] =
-          std::thread(&ACO::optimizeAnt, this, std::ref(ants[i]), std::ref(best_ant), std::ref(gen), std::ref(expand));
-    for (size_t i = 0; i < n_ants_; ++i)
-      ants_list[i].join();
+    updateAnts(start, goal);
+    pool.parallelFor(n_ants_, [&](int i, int worker) { optimizeAnt(i, expand_buf_[worker], deposit_buf_[worker]); });
+
+    // reward here, increased pheromone
+    for (auto& buf : deposit_buf_)
+    {
+      for (const auto& d : buf)
+        _depositPheromone(d.first, d.second);
+      buf.clear();
+    }
+
+    // Merge expand points
+    for (auto& buf : expand_buf_)
+    {
+      expand.insert(expand.end(), buf.begin(), buf.end());
+      buf.clear();
+    }
 
     // best_ant.position = ants[best_ant_idx_].best_pos;
 
-    // pheromone deterioration
-    for (size_t i = 0; i < map_size_; i++)
-      pheromone_mat_[i] *= (1 - rho_);
+    // pheromone deterioration, applied lazily on access
+    pheromone_iter_++;
   }
 
   // Generating Paths from Optimal Particles
   std::vector<std::pair<double, double>> points, b_path;
   points.emplace_back(static_cast<double>(start.x()), static_cast<double>(start.y()));
-  for (const auto& pos : best_ant.position)
-    points.emplace_back(static_cast<double>(pos.first), static_cast<double>(pos.second));
+  for (int j = 0; j < point_num_; ++j)
+    points.emplace_back(static_cast<double>(best_x_[j]), static_cast<double>(best_y_[j]));
   points.emplace_back(static_cast<double>(goal.x()), static_cast<double>(goal.y()));
   points.erase(std::unique(std::begin(points), std::end(points)), std::end(points));
 
@@ -128,11 +152,12 @@ bool ACO::plan(const Node& start, const Node& goal, std::vector<Node>& path, std
   }
 
   // Update inheritance ants based on optimal fitness
-  std::sort(ants.begin(), ants.end(), [](const Ant& a, const Ant& b) { return a.best_fitness > b.best_fitness; });
-  inherited_ants_.clear();
+  std::vector<int> elite;
+  ants_.elite(n_inherited_, elite, true);
+  inherited_ants_.resize(elite.size());
 
-  for (size_t inherit = 0; inherit < n_inherited_; ++inherit)
-    inherited_ants_.emplace_back(ants[inherit]);
+  for (size_t inherit = 0; inherit < elite.size(); ++inherit)
+    ants_.getBestPosition(elite[inherit], inherited_ants_[inherit]);
 
   return !path.empty();
 }
@@ -209,7 +234,7 @@ void ACO::initializePositions(PositionSequence& initial_positions, const Node& s
       {
         point_id++;
         visited.insert(pos_id);
-        double prob_new = std::pow(pheromone_mat_[pos_id], alpha_) *
+        double prob_new = std::pow(_getPheromone(pos_id), alpha_) *
                           std::pow(1.0 / hypot(temp_x[point_id] - goal.x(), temp_y[point_id] - goal.y()), beta_);
         probabilities.push_back(prob_new);
         prob_sum += prob_new;
@@ -248,76 +273,85 @@ void ACO::initializePositions(PositionSequence& initial_positions, const Node& s
 
 /**
  * @brief Calculate the value of fitness function
- * @param position  the control points calculated by PSO
+ * @param x  x of the control points calculated by ACO, point_num_ elements
+ * @param y  y of the control points calculated by ACO, point_num_ elements
  * @return fitness the value of fitness function
  */
-double ACO::calFitnessValue(std::vector<std::pair<int, int>> position)
+double ACO::calFitnessValue(const int* x, const int* y)
 {
-  std::vector<std::pair<double, double>> points, b_path;
-  points.push_back(start_);
-  for (const auto& pos : position)
-    points.emplace_back(static_cast<double>(pos.first), static_cast<double>(pos.second));
-  points.push_back(goal_);
-  points.erase(std::unique(std::begin(points), std::end(points)), std::end(points));
+  double fitness;
+  if (cache_.find(x, y, point_num_, 0.0, fitness))
+    return fitness;
+
+  // buffers of the calling thread, reused between evaluations
+  thread_local Eigen::MatrixX2d points, b_path;
+  points.resize(point_num_ + 2, 2);
+
+  // path points without consecutive duplicates
+  int n = 0;
+  auto add_point = [&](double x, double y) {
+    if ((n == 0) || (points(n - 1, 0) != x) || (points(n - 1, 1) != y))
+    {
+      points(n, 0) = x;
+      points(n, 1) = y;
+      n++;
+    }
+  };
+  add_point(start_.first, start_.second);
+  for (int j = 0; j < point_num_; ++j)
+    add_point(static_cast<double>(x[j]), static_cast<double>(y[j]));
+  add_point(goal_.first, goal_.second);
 
-  bspline_gen_.run(points, b_path);
+  if (!bspline_gen_.runUniform(points.topRows(n), b_path))
+    b_path.resize(0, 2);
 
-  // collision detection
+  // collision detection and path length
   int point_index;
-  double obs_cost = 1;
-  for (size_t i = 1; i < b_path.size(); ++i)
+  double obs_cost = 1, length = 0.0, offset = 0.0;
+  for (int i = 1; i < b_path.rows(); ++i)
   {
-    point_index = grid2Index(static_cast<int>(b_path[i].first), static_cast<int>(b_path[i].second));
+    point_index = grid2Index(static_cast<int>(b_path(i, 0)), static_cast<int>(b_path(i, 1)));
+    length += std::hypot(b_path(i, 0) - b_path(i - 1, 0), b_path(i, 1) - b_path(i - 1, 1));
+    // the footprint facing along the path, swept on every segment to keep the offset of the next one
+    const bool swept = footprint_checker_.sweep(b_path(i - 1, 0), b_path(i - 1, 1), b_path(i, 0), b_path(i, 1), offset);
     // next node hit the boundary or obstacle
-    if ((point_index < 0) || (point_index >= map_size_) ||
-        (costmap_->getCharMap()[point_index] >= costmap_2d::LETHAL_OBSTACLE * factor_))
+    bool collision = swept || (point_index < 0) || (point_index >= map_size_) ||
+                     (costmap_->getCharMap()[point_index] >= costmap_2d::LETHAL_OBSTACLE * factor_);
+    if (collision)
       obs_cost++;
   }
   // Calculate particle fitness
-  double b_path_length = bspline_gen_.len(b_path);
-  if (b_path_length > 0)
-    return 100000.0 / (b_path_length + 1000 * obs_cost);
-  else
-    return 0;
+  fitness = length > 0 ? 100000.0 / (length + 1000 * obs_cost) : 0.0;
+  cache_.insert(x, y, point_num_, fitness, true);
+  return fitness;
 }
 
 /**
  * @brief Ant update optimization iteration
- * @param ant       Ants to be updated for velocity
- * @param best_ant  Global optimal ant
- * @param gen            randomizer
- * @param expand         containing the node been search during the process
+ * @param i         ant index
+ * @param expand    expand buffer of the calling worker
+ * @param deposit   pheromone deposit buffer of the calling worker
  */
-void ACO::optimizeAnt(Ant& ant, Ant& best_ant, std::mt19937& gen, std::vector<Node>& expand)
+void ACO::optimizeAnt(int i, std::vector<Node>& expand, std::vector<std::pair<int, double>>& deposit)
 {
-  // Calculate fitness
-  ant.fitness = calFitnessValue(ant.position);
-
-  // reward here, increased pheromone
-  double c = Q_ / static_cast<double>(ant.fitness);
-
-  // Update global optimal ant
-  lock_.lock();
+  // reward here, increased pheromone, the fitness was evaluated when the ant was generated
+  double c = Q_ / static_cast<double>(ants_.fitness(i));
 
   // Update expand points
-  for (const auto& pos : ant.position)
+  for (int j = 0; j < point_num_; ++j)
   {
-    pheromone_mat_[grid2Index(pos.first, pos.second)] += c;
-    expand.emplace_back(Node(pos.first, pos.second));
+    deposit.emplace_back(grid2Index(ants_.x(i)[j], ants_.y(i)[j]), c);
+    expand.emplace_back(Node(ants_.x(i)[j], ants_.y(i)[j]));
   }
-
-  if (ant.best_fitness > best_ant.fitness)
-  {
-    best_ant.fitness = ant.best_fitness;
-    best_ant.position = ant.position;
-  }
-
-  lock_.unlock();
 }
 
-void ACO::updateAnts(std::vector<Ant>& ants, const Node& start, const Node& goal, Ant& best_ant)
+/**
+ * @brief Generate the ants of a new iteration, evaluate them and update the global optimal ant
+ * @param start     start node
+ * @param goal      goal node
+ */
+void ACO::updateAnts(const Node& start, const Node& goal)
 {
-  double init_fitness;
   PositionSequence init_positions;
 
   // Generate initial position of particle swarm
@@ -326,23 +360,79 @@ void ACO::updateAnts(std::vector<Ant>& ants, const Node& start, const Node& goal
   // Ant initialization
   for (int i = 0; i < n_ants_; ++i)
   {
-    std::vector<std::pair<int, int>> init_position;
     if ((i < n_inherited_) && (inherited_ants_.size() == n_inherited_))
-      init_position = inherited_ants_[i].best_pos;
+      ants_.setPosition(i, inherited_ants_[i]);
     else
-      init_position = init_positions[i];
+      ants_.setPosition(i, init_positions[i]);
+  }
+
+  // Calculate fitness
+  helper::ThreadPool::instance().parallelFor(
+      n_ants_, [&](int i, int worker) { ants_.fitness(i) = calFitnessValue(ants_.x(i), ants_.y(i)); });
+  ants_.resetBest();
 
-    // Calculate fitness
-    init_fitness = calFitnessValue(init_position);
-    if (init_fitness > best_ant.fitness)
+  for (int i = 0; i < n_ants_; ++i)
+  {
+    if (ants_.fitness(i) > best_fitness_)
     {
-      best_ant.position = init_position;
-      best_ant.fitness = init_fitness;
+      best_fitness_ = ants_.fitness(i);
+      std::copy(ants_.x(i), ants_.x(i) + point_num_, best_x_.begin());
+      std::copy(ants_.y(i), ants_.y(i) + point_num_, best_y_.begin());
     }
-
-    // Create and add particle objects to containers
-    ants[i] = { init_position, init_fitness };
   }
 }
 
-}  // namespace global_planner
\ No newline at end of file
+/**
+ * @brief Get the pheromone of a cell, evaporation since its last update is applied lazily
+ * @param idx  cell index
+ * @return pheromone of the cell
+ */
+double ACO::_getPheromone(int idx) const
+{
+  auto it = pheromone_.find(idx);
+  if (it == pheromone_.end())
+    return _decay(pheromone_iter_);
+  return it->second.first * _decay(pheromone_iter_ - it->second.second);
+}
+
+/**
+ * @brief Deposit pheromone on a cell
+ * @param idx  cell index
+ * @param c    pheromone increment
+ */
+void ACO::_depositPheromone(int idx, double c)
+{
+  double value = _getPheromone(idx) + c;
+  pheromone_[idx] = std::make_pair(value, pheromone_iter_);
+}
+
+/**
+ * @brief Evaporation factor of k iterations, i.e. (1 - rho)^k
+ * @param k  number of iterations
+ * @return evaporation factor
+ */
+double ACO::_decay(int k) const
+{
+  return k < static_cast<int>(decay_.size()) ? decay_[k] : std::pow(1 - rho_, k);
+}
+
+/**
+ * @brief Check collisions with the robot footprint along the path, besides the centre cell against the inflated
+ *        costmap
+ * @param footprint footprint vertices in the robot frame in meters, empty to check the centre cell only
+ */
+void ACO::setFootprint(const std::vector<std::pair<double, double>>& footprint)
+{
+  footprint_checker_.setFootprint(footprint, costmap_->getResolution());
+}
+
+/**
+ * @brief Get the fitness cache of the last planning query
+ * @return fitness cache
+ */
+const FitnessCache& ACO::getFitnessCache() const
+{
+  return cache_;
+}
+
+}  // namespace global_planner
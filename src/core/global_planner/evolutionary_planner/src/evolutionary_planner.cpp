@@ -50,7 +50,30 @@ EvolutionaryPlanner::EvolutionaryPlanner(std::string name, costmap_2d::Costmap2D
  */
 void EvolutionaryPlanner::initialize(std::string name, costmap_2d::Costmap2DROS* costmapRos)
 {
+  if (initialized_)
+  {
+    ROS_WARN("This planner has already been initialized, you can't call it twice, doing nothing");
+    return;
+  }
   initialize(name, costmapRos->getCostmap(), costmapRos->getGlobalFrameID());
+
+  // whether to check the robot footprint along the path besides the inflated centre cell, only the ROS wrapper
+  // knows the footprint
+  bool use_footprint;
+  ros::NodeHandle private_nh("~/" + name);
+  private_nh.param("use_footprint", use_footprint, false);
+  if (use_footprint)
+  {
+    std::vector<std::pair<double, double>> footprint;
+    for (const auto& p : costmapRos->getRobotFootprint())
+      footprint.emplace_back(p.x, p.y);
+    if (auto pso = std::dynamic_pointer_cast<global_planner::PSO>(g_planner_))
+      pso->setFootprint(footprint);
+    else if (auto ga = std::dynamic_pointer_cast<global_planner::GA>(g_planner_))
+      ga->setFootprint(footprint);
+    else if (auto aco = std::dynamic_pointer_cast<global_planner::ACO>(g_planner_))
+      aco->setFootprint(footprint);
+  }
 }
 
 /**
@@ -240,6 +263,17 @@ bool EvolutionaryPlanner::makePlan(const geometry_msgs::PoseStamped& start, cons
   std::vector<Node> expand;
   bool path_found = g_planner_->plan(start_node, goal_node, path, expand);
 
+  const global_planner::FitnessCache* cache = nullptr;
+  if (auto pso = std::dynamic_pointer_cast<global_planner::PSO>(g_planner_))
+    cache = &pso->getFitnessCache();
+  else if (auto ga = std::dynamic_pointer_cast<global_planner::GA>(g_planner_))
+    cache = &ga->getFitnessCache();
+  else if (auto aco = std::dynamic_pointer_cast<global_planner::ACO>(g_planner_))
+    cache = &aco->getFitnessCache();
+  if (cache)
+    ROS_DEBUG("Fitness lookups: %zu, hits: %.1f%%", cache->lookups(),
+              cache->lookups() ? 100.0 * cache->hits() / cache->lookups() : 0.0);
+
   if (path_found)
   {
     if (_getPlanFromPath(path, plan))
@@ -0,0 +1,150 @@
+/**
+ * *********************************************************
+ *
+ * @file: fitness_cache.cpp
+ * @brief: Contains the fitness cache shared by the evolutionary planners
+ * @author: Yang Haodong
+ * @date: 2024-10-02
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#include <algorithm>
+
+#include "fitness_cache.h"
+
+namespace global_planner
+{
+constexpr int FitnessCache::kShards;
+
+/**
+ * @brief Construct a new Fitness Cache object
+ */
+FitnessCache::FitnessCache() : lookups_(0), hits_(0)
+{
+}
+
+/**
+ * @brief Remove all entries and reset the statistics, called whenever the start, goal or map change
+ */
+void FitnessCache::clear()
+{
+  for (auto& shard : shards_)
+  {
+    std::lock_guard<std::mutex> lock(shard.lock);
+    shard.table.clear();
+    shard.keys.clear();
+  }
+  lookups_ = 0;
+  hits_ = 0;
+}
+
+/**
+ * @brief Look up the fitness of a waypoint sequence
+ * @param x          x of the waypoints, dim elements
+ * @param y          y of the waypoints, dim elements
+ * @param dim        number of waypoints
+ * @param threshold  fitness the caller is interested in, an upper bound below it is a valid answer
+ * @param fitness    cached exact fitness or upper bound
+ * @return true if the cached value answers the lookup, else false
+ */
+bool FitnessCache::find(const int* x, const int* y, int dim, double threshold, double& fitness)
+{
+  lookups_.fetch_add(1, std::memory_order_relaxed);
+
+  const std::uint64_t h = _hash(x, y, dim);
+  Shard& shard = shards_[h % kShards];
+  std::lock_guard<std::mutex> lock(shard.lock);
+
+  auto it = shard.table.find(h);
+  if ((it == shard.table.end()) || !_equal(shard, it->second, x, y, dim))
+    return false;
+  if (!it->second.exact && (it->second.fitness >= threshold))
+    return false;
+
+  fitness = it->second.fitness;
+  hits_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+/**
+ * @brief Store the fitness of a waypoint sequence, replacing any previous entry
+ * @param x        x of the waypoints, dim elements
+ * @param y        y of the waypoints, dim elements
+ * @param dim      number of waypoints
+ * @param fitness  exact fitness or upper bound
+ * @param exact    whether the fitness is exact
+ */
+void FitnessCache::insert(const int* x, const int* y, int dim, double fitness, bool exact)
+{
+  const std::uint64_t h = _hash(x, y, dim);
+  Shard& shard = shards_[h % kShards];
+  std::lock_guard<std::mutex> lock(shard.lock);
+
+  auto it = shard.table.find(h);
+  if (it != shard.table.end())
+  {
+    // the same sequence is only refined to the exact value or a tighter bound, a colliding one keeps the slot
+    Entry& cached = it->second;
+    if (_equal(shard, cached, x, y, dim) && !cached.exact && (exact || (fitness < cached.fitness)))
+    {
+      cached.fitness = fitness;
+      cached.exact = exact;
+    }
+    return;
+  }
+
+  Entry entry{ shard.keys.size(), fitness, exact };
+  shard.keys.insert(shard.keys.end(), x, x + dim);
+  shard.keys.insert(shard.keys.end(), y, y + dim);
+  shard.table.emplace(h, entry);
+}
+
+/**
+ * @brief Get the number of lookups and of answered lookups since the last clear()
+ */
+std::size_t FitnessCache::lookups() const
+{
+  return lookups_.load();
+}
+
+std::size_t FitnessCache::hits() const
+{
+  return hits_.load();
+}
+
+/**
+ * @brief Hash of a waypoint sequence
+ * @param x    x of the waypoints, dim elements
+ * @param y    y of the waypoints, dim elements
+ * @param dim  number of waypoints
+ * @return hash value
+ */
+std::uint64_t FitnessCache::_hash(const int* x, const int* y, int dim)
+{
+  std::uint64_t h = 0x9e3779b97f4a7c15ULL;
+  for (int j = 0; j < dim; j++)
+  {
+    // splitmix64 finalizer over the packed coordinates
+    h ^= (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x[j])) << 32) | static_cast<std::uint32_t>(y[j]);
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+  }
+  return h;
+}
+
+/**
+ * @brief Compare a cached key with a waypoint sequence
+ */
+bool FitnessCache::_equal(const Shard& shard, const Entry& entry, const int* x, const int* y, int dim)
+{
+  const int* key = shard.keys.data() + entry.offset;
+  return std::equal(x, x + dim, key) && std::equal(y, y + dim, key + dim);
+}
+}  // namespace global_planner
@@ -47,7 +47,9 @@ GA::GA(costmap_2d::Costmap2D* costmap, int n_genets, int n_inherited, int point_
   , init_mode_(init_mode)
   , max_iter_(max_iter)
 {
-  inherited_genets_.emplace_back(std::vector<std::pair<int, int>>(point_num, std::make_pair(1, 1)), 0.0);
+  // uniform spaced parameters, so the fitness evaluation can reuse the cached B-spline basis
+  bspline_gen_.setParamMode(PARAM_MODE_UNIFORMSPACED);
+  inherited_genets_.emplace_back(point_num, std::make_pair(1, 1));
 }
 
 GA::~GA()
@@ -67,6 +69,10 @@ bool GA::plan(const Node& start, const Node& goal, std::vector<Node>& path, std:
   start_ = std::pair<double, double>(static_cast<double>(start.x()), static_cast<double>(start.y()));
   goal_ = std::pair<double, double>(static_cast<double>(goal.x()), static_cast<double>(goal.y()));
   expand.clear();
+  cache_.clear();
+
+  footprint_checker_.update(costmap_->getCharMap(), costmap_->getSizeInCellsX(), costmap_->getSizeInCellsY(),
+                            costmap_2d::LETHAL_OBSTACLE);
 
   if ((n_genets_ <= 0) || (n_genets_ % 2 != 0))
   {
@@ -76,67 +82,101 @@ bool GA::plan(const Node& start, const Node& goal, std::vector<Node>& path, std:
   }
 
   // variable initialization
-  double init_fitness;
-  Genets best_genet;
   PositionSequence init_positions;
-  std::vector<Genets> genets_swarm;
-  std::vector<Genets> genets_parent;
-  std::vector<Genets> genets_children;
+  std::vector<int> best_x(point_num_), best_y(point_num_);
+  double best_fitness = 0.0;
 
   // Generate initial position of genets swarm
   initializePositions(init_positions, start, goal, init_mode_);
 
   // genets initialization
+  swarm_.resize(n_genets_, point_num_);
   for (int i = 0; i < n_genets_; ++i)
   {
-    std::vector<std::pair<int, int>> init_position;
-
     if ((i < n_inherited_) && (inherited_genets_.size() == n_inherited_))
-      init_position = inherited_genets_[i].best_pos;
+      swarm_.setPosition(i, inherited_genets_[i]);
     else
-      init_position = init_positions[i];
+      swarm_.setPosition(i, init_positions[i]);
+  }
 
-    // Calculate fitness
-    init_fitness = calFitnessValue(init_position);
+  // random data and expand buffer of each worker
+  helper::ThreadPool& pool = helper::ThreadPool::instance();
+  std::random_device rd;
+  gen_.seed(rd());
+  gens_.resize(pool.size());
+  for (auto& gen : gens_)
+    gen.seed(rd());
+  expand_buf_.resize(pool.size());
 
-    if ((i == 0) || (init_fitness > best_genet.fitness))
+  // Calculate fitness
+  pool.parallelFor(n_genets_,
+                   [&](int i, int worker) { swarm_.fitness(i) = calFitnessValue(swarm_.x(i), swarm_.y(i)); });
+  swarm_.resetBest();
+
+  for (int i = 0; i < n_genets_; ++i)
+  {
+    if ((i == 0) || (swarm_.fitness(i) > best_fitness))
     {
-      best_genet.fitness = init_fitness;
-      best_genet.position = init_position;
+      best_fitness = swarm_.fitness(i);
+      std::copy(swarm_.x(i), swarm_.x(i) + point_num_, best_x.begin());
+      std::copy(swarm_.y(i), swarm_.y(i) + point_num_, best_y.begin());
     }
-    // Create and add genets objects to containers
-    genets_swarm.emplace_back(init_position, init_fitness);
   }
 
-  // random data
-  std::random_device rd;
-  std::mt19937 gen(rd());
-
   // Iterative optimization
   for (size_t iter = 0; iter < max_iter_; iter++)
   {
-    selection(genets_swarm, genets_parent);
+    selection(swarm_, parent_);
+
+    // the i-th child starts from the next parent
+    const int n_selected = parent_.size();
+    children_.resize(n_selected, point_num_);
+    for (int i = 0; i < n_selected; ++i)
+      children_.copy(i, parent_, (i + 1) % n_selected);
+
+    // With elite selection and every parent kept in the swarm, a child below the worst parent can never be
+    // selected, so its evaluation may stop early. The roulette needs the exact fitness of everyone.
+    double threshold = 0.0;
+    if ((static_cast<int>(100 * p_select_) % 2 == 0) && (2 * n_selected <= n_genets_) && (n_selected > 0))
+    {
+      threshold = parent_.fitness(0);
+      for (int i = 1; i < n_selected; ++i)
+        threshold = std::min(threshold, parent_.fitness(i));
+    }
+
+    pool.parallelFor(n_selected,
+                     [&](int i, int worker) { optimizeGenets(i, threshold, gens_[worker], expand_buf_[worker]); });
 
-    genets_children = genets_parent;
-    std::rotate(genets_children.begin(), genets_children.begin() + 1, genets_children.end());
+    // Update global optimal genets in genets order
+    for (int i = 0; i < n_selected; ++i)
+    {
+      if (children_.bestFitness(i) > best_fitness)
+      {
+        best_fitness = children_.bestFitness(i);
+        std::copy(children_.bestX(i), children_.bestX(i) + point_num_, best_x.begin());
+        std::copy(children_.bestY(i), children_.bestY(i) + point_num_, best_y.begin());
+      }
+    }
 
-    std::vector<std::thread> genets_list = std::vector<std::thread>(genets_parent.size());
-    for (size_t i = 0; i < genets_parent.size(); ++i)
-      genets_list[i] = std::thread(&GA::optimizeGenets, this, std::cref(genets_parent[i]), std::ref(genets_children[i]),
-                                   std::ref(best_genet), i, std::ref(gen), std::ref(expand));
-    for (size_t i = 0; i < genets_parent.size(); ++i)
-      genets_list[i].join();
+    // Merge expand points
+    for (auto& buf : expand_buf_)
+    {
+      expand.insert(expand.end(), buf.begin(), buf.end());
+      buf.clear();
+    }
 
     // Copy the elements from genets_parent and genets_children to genets_swarm
-    std::copy(genets_children.begin(), genets_children.end(), genets_swarm.begin());
-    std::copy(genets_parent.begin(), genets_parent.end(), genets_swarm.begin() + genets_children.size());
+    for (int i = 0; i < n_selected && i < n_genets_; ++i)
+      swarm_.copy(i, children_, i);
+    for (int i = 0; i < n_selected && n_selected + i < n_genets_; ++i)
+      swarm_.copy(n_selected + i, parent_, i);
   }
 
   // Generating Paths from Optimal Genets
   std::vector<std::pair<double, double>> points, b_path;
   points.emplace_back(static_cast<double>(start.x()), static_cast<double>(start.y()));
-  for (const auto& pos : best_genet.position)
-    points.emplace_back(static_cast<double>(pos.first), static_cast<double>(pos.second));
+  for (int j = 0; j < point_num_; ++j)
+    points.emplace_back(static_cast<double>(best_x[j]), static_cast<double>(best_y[j]));
   points.emplace_back(static_cast<double>(goal.x()), static_cast<double>(goal.y()));
   points.erase(std::unique(std::begin(points), std::end(points)), std::end(points));
 
@@ -165,12 +205,12 @@ bool GA::plan(const Node& start, const Node& goal, std::vector<Node>& path, std:
   }
 
   // Update inheritance genets based on optimal fitness
-  std::sort(genets_swarm.begin(), genets_swarm.end(),
-            [](const Genets& a, const Genets& b) { return a.best_fitness > b.best_fitness; });
-  inherited_genets_.clear();
+  std::vector<int> elite;
+  swarm_.elite(n_inherited_, elite, true);
+  inherited_genets_.resize(elite.size());
 
-  for (size_t inherit = 0; inherit < n_inherited_; ++inherit)
-    inherited_genets_.emplace_back(genets_swarm[inherit]);
+  for (size_t inherit = 0; inherit < elite.size(); ++inherit)
+    swarm_.getBestPosition(elite[inherit], inherited_genets_[inherit]);
 
   return !path.empty();
 }
@@ -266,128 +306,121 @@ void GA::initializePositions(PositionSequence& initial_positions, const Node& st
 
 /**
  * @brief Calculate the value of fitness function
- * @param position  the control points calculated by PSO
+ * @param x          x of the control points calculated by GA, point_num_ elements
+ * @param y          y of the control points calculated by GA, point_num_ elements
+ * @param threshold  the evaluation stops once the fitness falls below it, returning an upper bound
  * @return fitness the value of fitness function
  */
-double GA::calFitnessValue(std::vector<std::pair<int, int>> position)
+double GA::calFitnessValue(const int* x, const int* y, double threshold)
 {
-  std::vector<std::pair<double, double>> points, b_path;
-  points.push_back(start_);
-  for (const auto& pos : position)
-    points.emplace_back(static_cast<double>(pos.first), static_cast<double>(pos.second));
-  points.push_back(goal_);
-  points.erase(std::unique(std::begin(points), std::end(points)), std::end(points));
+  double fitness;
+  if (cache_.find(x, y, point_num_, threshold, fitness))
+    return fitness;
+
+  // buffers of the calling thread, reused between evaluations
+  thread_local Eigen::MatrixX2d points, b_path;
+  points.resize(point_num_ + 2, 2);
+
+  // path points without consecutive duplicates
+  int n = 0;
+  auto add_point = [&](double x, double y) {
+    if ((n == 0) || (points(n - 1, 0) != x) || (points(n - 1, 1) != y))
+    {
+      points(n, 0) = x;
+      points(n, 1) = y;
+      n++;
+    }
+  };
+  add_point(start_.first, start_.second);
+  for (int j = 0; j < point_num_; ++j)
+    add_point(static_cast<double>(x[j]), static_cast<double>(y[j]));
+  add_point(goal_.first, goal_.second);
 
-  bspline_gen_.run(points, b_path);
+  if (!bspline_gen_.runUniform(points.topRows(n), b_path))
+    b_path.resize(0, 2);
 
-  // collision detection
+  // collision detection and path length
   int point_index;
-  double obs_cost = 1;
-  for (size_t i = 1; i < b_path.size(); ++i)
+  double obs_cost = 1, length = 0.0, offset = 0.0;
+  for (int i = 1; i < b_path.rows(); ++i)
   {
-    point_index = grid2Index(static_cast<int>(b_path[i].first), static_cast<int>(b_path[i].second));
+    point_index = grid2Index(static_cast<int>(b_path(i, 0)), static_cast<int>(b_path(i, 1)));
+    length += std::hypot(b_path(i, 0) - b_path(i - 1, 0), b_path(i, 1) - b_path(i - 1, 1));
+    // the footprint facing along the path, swept on every segment to keep the offset of the next one
+    const bool swept = footprint_checker_.sweep(b_path(i - 1, 0), b_path(i - 1, 1), b_path(i, 0), b_path(i, 1), offset);
     // next node hit the boundary or obstacle
-    if ((point_index < 0) || (point_index >= map_size_) ||
-        (costmap_->getCharMap()[point_index] >= costmap_2d::LETHAL_OBSTACLE * factor_))
+    bool collision = swept || (point_index < 0) || (point_index >= map_size_) ||
+                     (costmap_->getCharMap()[point_index] >= costmap_2d::LETHAL_OBSTACLE * factor_);
+    if (collision)
+    {
       obs_cost++;
+      // the fitness only decreases along the sweep, stop once it can no longer reach the threshold
+      fitness = 100000.0 / (length + 1000 * obs_cost);
+      if (fitness < threshold)
+      {
+        cache_.insert(x, y, point_num_, fitness, false);
+        return fitness;
+      }
+    }
   }
   // Calculate particle fitness
-  return 100000.0 / (bspline_gen_.len(b_path) + 1000 * obs_cost);
+  fitness = 100000.0 / (length + 1000 * obs_cost);
+  cache_.insert(x, y, point_num_, fitness, true);
+  return fitness;
 }
 
 /**
  * @brief Perform selection.
  * @param population        The population of Genets.
- * @param selected_population The selected individuals will be stored in this vector.
+ * @param selected_population The selected individuals will be stored in this population.
  */
-void GA::selection(const std::vector<Genets>& population, std::vector<Genets>& selected_population)
+void GA::selection(const Population& population, Population& selected_population)
 {
   // Calculate selection mode
   int select_mode = (static_cast<int>(100 * p_select_) % 2 == 0) ? 0 : 1;
   // Calculate the number of individuals to be selected
-  size_t select_num = static_cast<size_t>(population.size() * p_select_);
+  int select_num = static_cast<int>(population.size() * p_select_);
 
   // Perform selection using roulette wheel method.
   if (select_mode)
   {
-    // Calculate the inverse fitness values
-    std::vector<double> fitness_values;
-    fitness_values.reserve(population.size());
-    for (const auto& genet : population)
-      fitness_values.push_back(genet.fitness);
-
-    // Calculate the total fitness
-    double total_fit = std::accumulate(fitness_values.begin(), fitness_values.end(), 0.0);
-
-    // Calculate cumulative probability
-    std::vector<double> acc_p;
-    acc_p.reserve(population.size());
-    double sum = 0.0;
-    for (const auto& v : fitness_values)
-    {
-      sum += v / total_fit;
-      acc_p.push_back(sum);
-    }
-
     // Initialize the selected individuals with the first individual from the population
-    selected_population.clear();
-    selected_population.push_back(population.front());
-
-    std::vector<size_t> selected_indices;
-    selected_indices.reserve(select_num);
-
-    // Set up random number generation
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<double> dis(0.0, 1.0);
-
-    // Execute the selection process
-    for (size_t i = 1; i < select_num; ++i)
-    {
-      // Generate a random number
-      double rand_num = dis(gen);
-      // Find the cumulative probability greater than the random number
-      auto it = std::find_if(acc_p.begin(), acc_p.end(), [rand_num](double val) { return val > rand_num; });
+    selected_population.resize(std::max(select_num, 1), population.dim());
+    selected_population.copy(0, population, 0);
 
-      if (it != acc_p.end())
-      {
-        // Get the index of the first cumulative probability greater than the random number
-        size_t idx = std::distance(acc_p.begin(), it);
+    // Build the wheel once, each spin is O(1), duplicate selection is allowed
+    Eigen::ArrayXd fitness_values(population.size());
+    for (int i = 0; i < population.size(); ++i)
+      fitness_values[i] = population.fitness(i);
+    roulette_.build(fitness_values);
 
-        // Allow duplicate selection
-        selected_population.push_back(population[idx]);
-        selected_indices.push_back(idx);
-      }
-      else
-        --i;  // Retry if not found, i.e., random number is too close to 1.0
-    }
+    for (int i = 1; i < select_num; ++i)
+      selected_population.copy(i, population, roulette_.sample(gen_));
   }
   // Select individuals to be retained based on their fitness level
   else
   {
-    auto population_c = population;
-
-    std::sort(population_c.begin(), population_c.end(),
-              [](const Genets& a, const Genets& b) { return a.fitness > b.fitness; });
-    selected_population.clear();
+    std::vector<int> elite;
+    population.elite(select_num, elite);
 
-    for (size_t i = 0; i < select_num; ++i)
-      selected_population.emplace_back(population_c[i]);
+    selected_population.resize(static_cast<int>(elite.size()), population.dim());
+    for (size_t i = 0; i < elite.size(); ++i)
+      selected_population.copy(i, population, elite[i]);
   }
 }
 
 /**
- * @brief Genets update optimization iteration
- * @param genets_p      individuals selected for retention
- * @param genets_c      descendants of selected individuals to be retained
- * @param best_genets   Global optimal genets
+ * @brief Genets update optimization iteration, the i-th child is generated from the i-th parent
  * @param i             genets ID
- * @param gen           randomizer
- * @param expand        containing the node been search during the process
+ * @param threshold     fitness below which the evaluation of the child may stop early
+ * @param gen           randomizer of the calling worker
+ * @param expand        expand buffer of the calling worker
  */
-void GA::optimizeGenets(const Genets& genets_p, Genets& genets_c, Genets& best_genet, const int& i, std::mt19937& gen,
-                        std::vector<Node>& expand)
+void GA::optimizeGenets(int i, double threshold, std::mt19937& gen, std::vector<Node>& expand)
 {
+  int* x = children_.x(i);
+  int* y = children_.y(i);
+
   std::uniform_real_distribution<double> dist_d(0.0, 1.0);
   std::uniform_int_distribution<int> dist_i(0, point_num_ - 1);
   double random1 = dist_d(gen);
@@ -397,7 +430,8 @@ void GA::optimizeGenets(const Genets& genets_p, Genets& genets_c, Genets& best_g
   if (random1 < p_crs_)
   {
     int random_id = dist_i(gen);
-    std::copy(genets_p.position.begin() + random_id, genets_p.position.end(), genets_c.position.begin() + random_id);
+    std::copy(parent_.x(i) + random_id, parent_.x(i) + point_num_, x + random_id);
+    std::copy(parent_.y(i) + random_id, parent_.y(i) + point_num_, y + random_id);
   }
 
   // Perform mutation operation
@@ -406,52 +440,56 @@ void GA::optimizeGenets(const Genets& genets_p, Genets& genets_c, Genets& best_g
     int random_id = dist_i(gen);
 
     // If it exceeds a certain number of times, it is considered that the mutation has failed
-    for (size_t i = 0; i < 10; i++)
+    for (size_t k = 0; k < 10; k++)
     {
       std::uniform_real_distribution<double> dist_m(-1.0, 1.0);
       double random3 = dist_m(gen);
       double random4 = dist_m(gen);
-      int x = genets_c.position[random_id].first + static_cast<int>(random3 * max_speed_);
-      int y = genets_c.position[random_id].second + static_cast<int>(random4 * max_speed_);
+      int mx = x[random_id] + static_cast<int>(random3 * max_speed_);
+      int my = y[random_id] + static_cast<int>(random4 * max_speed_);
 
-      int point_index = grid2Index(x, y);
+      int point_index = grid2Index(mx, my);
       if ((point_index >= 0) && (point_index < map_size_) &&
           (costmap_->getCharMap()[point_index] < costmap_2d::LETHAL_OBSTACLE * factor_))
       {
-        genets_c.position[random_id].first = x;
-        genets_c.position[random_id].second = y;
+        x[random_id] = mx;
+        y[random_id] = my;
         break;
       }
     }
   }
 
   // Calculate fitness
-  genets_c.fitness = calFitnessValue(genets_c.position);
+  children_.fitness(i) = calFitnessValue(x, y, threshold);
 
   // Update individual optima
-  if (genets_c.fitness > genets_c.best_fitness)
-  {
-    genets_c.best_fitness = genets_c.fitness;
-    genets_c.best_pos = genets_c.position;
-  }
-
-  // Update global optimal genets
-  genets_lock_.lock();
+  children_.updateBest(i);
 
   // Update expand points
-  for (auto pos : genets_c.position)
-    expand.emplace_back(Node(pos.first, pos.second));
+  for (int j = 0; j < point_num_; ++j)
+    expand.emplace_back(Node(x[j], y[j]));
 
-  for (auto pos : genets_p.position)
-    expand.emplace_back(Node(pos.first, pos.second));
+  for (int j = 0; j < point_num_; ++j)
+    expand.emplace_back(Node(parent_.x(i)[j], parent_.y(i)[j]));
+}
 
-  if (genets_c.best_fitness > best_genet.fitness)
-  {
-    best_genet.fitness = genets_c.best_fitness;
-    best_genet.position = genets_c.best_pos;
-  }
+/**
+ * @brief Check collisions with the robot footprint along the path, besides the centre cell against the inflated
+ *        costmap
+ * @param footprint footprint vertices in the robot frame in meters, empty to check the centre cell only
+ */
+void GA::setFootprint(const std::vector<std::pair<double, double>>& footprint)
+{
+  footprint_checker_.setFootprint(footprint, costmap_->getResolution());
+}
 
-  genets_lock_.unlock();
+/**
+ * @brief Get the fitness cache of the last planning query
+ * @return fitness cache
+ */
+const FitnessCache& GA::getFitnessCache() const
+{
+  return cache_;
 }
 
 }  // namespace global_planner
@@ -0,0 +1,340 @@
+/**
+ * *********************************************************
+ *
+ * @file: population.cpp
+ * @brief: Contains the structure-of-arrays population shared by the evolutionary planners
+ * @author: Yang Haodong
+ * @date: 2024-09-28
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#include <algorithm>
+#include <numeric>
+
+#include "population.h"
+
+namespace global_planner
+{
+/**
+ * @brief Construct a new Population object
+ * @param n    number of individuals
+ * @param dim  number of position points of each individual
+ */
+Population::Population(int n, int dim) : n_(0), dim_(0)
+{
+  resize(n, dim);
+}
+
+/**
+ * @brief Reshape the population, all positions, velocities and fitness are reset to zero
+ * @param n    number of individuals
+ * @param dim  number of position points of each individual
+ */
+void Population::resize(int n, int dim)
+{
+  n_ = std::max(n, 0);
+  dim_ = std::max(dim, 0);
+  const int m = n_ * dim_;
+
+  x_.setZero(m);
+  y_.setZero(m);
+  vx_.setZero(m);
+  vy_.setZero(m);
+  best_x_.setZero(m);
+  best_y_.setZero(m);
+  fitness_.setZero(n_);
+  best_fitness_.setZero(n_);
+}
+
+/**
+ * @brief Get the number of individuals and the number of position points of each individual
+ */
+int Population::size() const
+{
+  return n_;
+}
+
+int Population::dim() const
+{
+  return dim_;
+}
+
+/**
+ * @brief Position, velocity and personal best coordinates of individual i, dim() elements each
+ */
+int* Population::x(int i)
+{
+  return x_.data() + i * dim_;
+}
+
+int* Population::y(int i)
+{
+  return y_.data() + i * dim_;
+}
+
+const int* Population::x(int i) const
+{
+  return x_.data() + i * dim_;
+}
+
+const int* Population::y(int i) const
+{
+  return y_.data() + i * dim_;
+}
+
+int* Population::vx(int i)
+{
+  return vx_.data() + i * dim_;
+}
+
+int* Population::vy(int i)
+{
+  return vy_.data() + i * dim_;
+}
+
+const int* Population::bestX(int i) const
+{
+  return best_x_.data() + i * dim_;
+}
+
+const int* Population::bestY(int i) const
+{
+  return best_y_.data() + i * dim_;
+}
+
+/**
+ * @brief Current and personal best fitness of individual i
+ */
+double& Population::fitness(int i)
+{
+  return fitness_[i];
+}
+
+double Population::fitness(int i) const
+{
+  return fitness_[i];
+}
+
+double& Population::bestFitness(int i)
+{
+  return best_fitness_[i];
+}
+
+double Population::bestFitness(int i) const
+{
+  return best_fitness_[i];
+}
+
+/**
+ * @brief Set the position of individual i, the velocity is cleared
+ * @param i        individual index
+ * @param position position points
+ */
+void Population::setPosition(int i, const std::vector<std::pair<int, int>>& position)
+{
+  for (int j = 0; j < dim_; j++)
+  {
+    x_[i * dim_ + j] = position[j].first;
+    y_[i * dim_ + j] = position[j].second;
+  }
+  vx_.segment(i * dim_, dim_).setZero();
+  vy_.segment(i * dim_, dim_).setZero();
+}
+
+/**
+ * @brief Get the position or the personal best position of individual i
+ * @param i        individual index
+ * @param position position points
+ */
+void Population::getPosition(int i, std::vector<std::pair<int, int>>& position) const
+{
+  position.resize(dim_);
+  for (int j = 0; j < dim_; j++)
+    position[j] = { x_[i * dim_ + j], y_[i * dim_ + j] };
+}
+
+void Population::getBestPosition(int i, std::vector<std::pair<int, int>>& position) const
+{
+  position.resize(dim_);
+  for (int j = 0; j < dim_; j++)
+    position[j] = { best_x_[i * dim_ + j], best_y_[i * dim_ + j] };
+}
+
+/**
+ * @brief Copy individual j of another population into individual i
+ * @param i    destination individual index
+ * @param src  source population with the same dim()
+ * @param j    source individual index
+ */
+void Population::copy(int i, const Population& src, int j)
+{
+  x_.segment(i * dim_, dim_) = src.x_.segment(j * dim_, dim_);
+  y_.segment(i * dim_, dim_) = src.y_.segment(j * dim_, dim_);
+  vx_.segment(i * dim_, dim_) = src.vx_.segment(j * dim_, dim_);
+  vy_.segment(i * dim_, dim_) = src.vy_.segment(j * dim_, dim_);
+  best_x_.segment(i * dim_, dim_) = src.best_x_.segment(j * dim_, dim_);
+  best_y_.segment(i * dim_, dim_) = src.best_y_.segment(j * dim_, dim_);
+  fitness_[i] = src.fitness_[j];
+  best_fitness_[i] = src.best_fitness_[j];
+}
+
+/**
+ * @brief Set the personal best of every individual to its current position and fitness
+ */
+void Population::resetBest()
+{
+  best_x_ = x_;
+  best_y_ = y_;
+  best_fitness_ = fitness_;
+}
+
+/**
+ * @brief Update the personal best of all or one individual if the current fitness is better
+ * @param i  individual index
+ */
+void Population::updateBest()
+{
+  for (int i = 0; i < n_; i++)
+    updateBest(i);
+}
+
+void Population::updateBest(int i)
+{
+  if (fitness_[i] > best_fitness_[i])
+  {
+    best_fitness_[i] = fitness_[i];
+    best_x_.segment(i * dim_, dim_) = x_.segment(i * dim_, dim_);
+    best_y_.segment(i * dim_, dim_) = y_.segment(i * dim_, dim_);
+  }
+}
+
+/**
+ * @brief Velocity update of the whole population, v = w_i * v + w_s * r1 * (best - p) + w_c * r2 * (g - p)
+ *        with one pair of random numbers per point, then clamped into [-max_speed, max_speed]
+ * @param g_x         global best x, dim() elements
+ * @param g_y         global best y, dim() elements
+ * @param w_inertial  inertia weight
+ * @param w_social    social weight
+ * @param w_cognitive cognitive weight
+ * @param max_speed   maximum velocity
+ * @param gen         randomizer
+ */
+void Population::updateVelocity(const int* g_x, const int* g_y, double w_inertial, double w_social,
+                                double w_cognitive, int max_speed, std::mt19937& gen)
+{
+  // The random numbers are distributed between [0, 1).
+  std::uniform_real_distribution<double> dist(0.0, 1.0);
+  r1_.resize(x_.size());
+  r2_.resize(x_.size());
+  for (int k = 0; k < x_.size(); k++)
+  {
+    r1_[k] = dist(gen);
+    r2_[k] = dist(gen);
+  }
+
+  // global best repeated for every individual
+  const auto gx = Eigen::Map<const Eigen::ArrayXi>(g_x, dim_).replicate(n_, 1);
+  const auto gy = Eigen::Map<const Eigen::ArrayXi>(g_y, dim_).replicate(n_, 1);
+
+  vx_ = (w_inertial * vx_.cast<double>() + w_social * r1_ * (best_x_ - x_).cast<double>() +
+         w_cognitive * r2_ * (gx - x_).cast<double>())
+            .cast<int>()
+            .max(-max_speed)
+            .min(max_speed);
+  vy_ = (w_inertial * vy_.cast<double>() + w_social * r1_ * (best_y_ - y_).cast<double>() +
+         w_cognitive * r2_ * (gy - y_).cast<double>())
+            .cast<int>()
+            .max(-max_speed)
+            .min(max_speed);
+}
+
+/**
+ * @brief Position update of the whole population, p = p + v clamped into [1, x_max - 1] x [1, y_max - 1]
+ * @param x_max  map size along x
+ * @param y_max  map size along y
+ */
+void Population::updatePosition(int x_max, int y_max)
+{
+  x_ = (x_ + vx_).max(1).min(x_max - 1);
+  y_ = (y_ + vy_).max(1).min(y_max - 1);
+}
+
+/**
+ * @brief Select the k fittest individuals in descending order, O(n + k log k)
+ * @param k             number of individuals
+ * @param indices       selected individual indices
+ * @param personal_best rank by the personal best instead of the current fitness
+ */
+void Population::elite(int k, std::vector<int>& indices, bool personal_best) const
+{
+  const Eigen::ArrayXd& key = personal_best ? best_fitness_ : fitness_;
+  auto fitter = [&](int a, int b) { return key[a] > key[b] || (key[a] == key[b] && a < b); };
+
+  k = std::min(std::max(k, 0), n_);
+  order_.resize(n_);
+  std::iota(order_.begin(), order_.end(), 0);
+  if (k < n_)
+    std::nth_element(order_.begin(), order_.begin() + k, order_.end(), fitter);
+  std::sort(order_.begin(), order_.begin() + k, fitter);
+
+  indices.assign(order_.begin(), order_.begin() + k);
+}
+
+/**
+ * @brief Build the table
+ * @param weights non-negative weights, at least one of them positive
+ */
+void AliasTable::build(const Eigen::Ref<const Eigen::ArrayXd>& weights)
+{
+  const int n = static_cast<int>(weights.size());
+  const double scale = n / weights.sum();
+
+  prob_.resize(n);
+  alias_.resize(n);
+  small_.clear();
+  large_.clear();
+  for (int i = 0; i < n; i++)
+  {
+    prob_[i] = weights[i] * scale;
+    alias_[i] = i;
+    (prob_[i] < 1.0 ? small_ : large_).push_back(i);
+  }
+
+  // pair every under-full column with an over-full one
+  while (!small_.empty() && !large_.empty())
+  {
+    int s = small_.back(), l = large_.back();
+    small_.pop_back();
+    alias_[s] = l;
+    prob_[l] -= 1.0 - prob_[s];
+    if (prob_[l] < 1.0)
+    {
+      large_.pop_back();
+      small_.push_back(l);
+    }
+  }
+
+  // remaining columns are full up to rounding
+  for (int i : small_)
+    prob_[i] = 1.0;
+  for (int i : large_)
+    prob_[i] = 1.0;
+}
+
+/**
+ * @brief Draw an index with probability proportional to its weight
+ * @param gen randomizer
+ * @return sampled index
+ */
+int AliasTable::sample(std::mt19937& gen) const
+{
+  const int i = std::uniform_int_distribution<int>(0, static_cast<int>(prob_.size()) - 1)(gen);
+  return std::uniform_real_distribution<double>(0.0, 1.0)(gen) < prob_[i] ? i : alias_[i];
+}
+}  // namespace global_planner
@@ -46,8 +46,9 @@ PSO::PSO(costmap_2d::Costmap2D* costmap, int n_particles, int n_inherited, int p
   , init_mode_(init_mode)
   , max_iter_(max_iter)
 {
-  inherited_particles_.emplace_back(std::vector<std::pair<int, int>>(point_num, std::make_pair(1, 1)),
-                                    std::vector<std::pair<int, int>>(point_num, std::make_pair(0, 0)), 0.0);
+  // uniform spaced parameters, so the fitness evaluation can reuse the cached B-spline basis
+  bspline_gen_.setParamMode(PARAM_MODE_UNIFORMSPACED);
+  inherited_particles_.emplace_back(point_num, std::make_pair(1, 1));
 }
 
 PSO::~PSO()
@@ -67,59 +68,86 @@ bool PSO::plan(const Node& start, const Node& goal, std::vector<Node>& path, std
   start_ = std::pair<double, double>(static_cast<double>(start.x()), static_cast<double>(start.y()));
   goal_ = std::pair<double, double>(static_cast<double>(goal.x()), static_cast<double>(goal.y()));
   expand.clear();
+  cache_.clear();
+
+  footprint_checker_.update(costmap_->getCharMap(), costmap_->getSizeInCellsX(), costmap_->getSizeInCellsY(),
+                            costmap_2d::LETHAL_OBSTACLE);
 
   // variable initialization
-  double init_fitness;
-  Particle best_particle;
   PositionSequence init_positions;
-  std::vector<Particle> particles;
+  std::vector<int> best_x(point_num_), best_y(point_num_);
+  double best_fitness = 0.0;
 
   // Generate initial position of particle swarm
   initializePositions(init_positions, start, goal, init_mode_);
 
   // Particle initialization
+  swarm_.resize(n_particles_, point_num_);
   for (int i = 0; i < n_particles_; ++i)
   {
-    std::vector<std::pair<int, int>> init_position;
     if ((i < n_inherited_) && (inherited_particles_.size() == n_inherited_))
-      init_position = inherited_particles_[i].best_pos;
+      swarm_.setPosition(i, inherited_particles_[i]);
     else
-      init_position = init_positions[i];
+      swarm_.setPosition(i, init_positions[i]);
+  }
 
-    std::vector<std::pair<int, int>> init_velocity(point_num_, std::make_pair(0, 0));
+  // random data and expand buffer of each worker
+  helper::ThreadPool& pool = helper::ThreadPool::instance();
+  std::random_device rd;
+  gen_.seed(rd());
+  expand_buf_.resize(pool.size());
 
-    // Calculate fitness
-    init_fitness = calFitnessValue(init_position);
+  // Calculate fitness
+  pool.parallelFor(n_particles_,
+                   [&](int i, int worker) { swarm_.fitness(i) = calFitnessValue(swarm_.x(i), swarm_.y(i)); });
+  swarm_.resetBest();
 
-    if ((i == 0) || (init_fitness > best_particle.fitness))
+  for (int i = 0; i < n_particles_; ++i)
+  {
+    if ((i == 0) || (swarm_.fitness(i) > best_fitness))
     {
-      best_particle.fitness = init_fitness;
-      best_particle.position = init_position;
+      best_fitness = swarm_.fitness(i);
+      std::copy(swarm_.x(i), swarm_.x(i) + point_num_, best_x.begin());
+      std::copy(swarm_.y(i), swarm_.y(i) + point_num_, best_y.begin());
     }
-    // Create and add particle objects to containers
-    particles.emplace_back(init_position, init_velocity, init_fitness);
   }
 
-  // random data
-  std::random_device rd;
-  std::mt19937 gen(rd());
-
   // Iterative optimization
   for (size_t iter = 0; iter < max_iter_; iter++)
   {
-    std::vector<std::thread> particle_list = std::vector<std::thread>(n_particles_);
-    for (size_t i = 0; i < n_particles_; ++i)
-      particle_list[i] = std::thread(&PSO::optimizeParticle, this, std::ref(particles[i]), std::ref(best_particle),
-                                     std::ref(gen), std::ref(expand));
-    for (size_t i = 0; i < n_particles_; ++i)
-      particle_list[i].join();
+    // update speed and position of the whole swarm
+    swarm_.updateVelocity(best_x.data(), best_y.data(), w_inertial_, w_social_, w_cognitive_, max_speed_, gen_);
+    swarm_.updatePosition(static_cast<int>(costmap_->getSizeInCellsX()), static_cast<int>(costmap_->getSizeInCellsY()));
+
+    pool.parallelFor(n_particles_, [&](int i, int worker) { optimizeParticle(i, expand_buf_[worker]); });
+
+    // Update individual optima
+    swarm_.updateBest();
+
+    // Update global optimal particles in particle order
+    for (int i = 0; i < n_particles_; ++i)
+    {
+      if (swarm_.bestFitness(i) > best_fitness)
+      {
+        best_fitness = swarm_.bestFitness(i);
+        std::copy(swarm_.x(i), swarm_.x(i) + point_num_, best_x.begin());
+        std::copy(swarm_.y(i), swarm_.y(i) + point_num_, best_y.begin());
+      }
+    }
+
+    // Merge expand points
+    for (auto& buf : expand_buf_)
+    {
+      expand.insert(expand.end(), buf.begin(), buf.end());
+      buf.clear();
+    }
   }
 
   // Generating Paths from Optimal Particles
   std::vector<std::pair<double, double>> points, b_path;
   points.emplace_back(static_cast<double>(start.x()), static_cast<double>(start.y()));
-  for (const auto& pos : best_particle.position)
-    points.emplace_back(static_cast<double>(pos.first), static_cast<double>(pos.second));
+  for (int j = 0; j < point_num_; ++j)
+    points.emplace_back(static_cast<double>(best_x[j]), static_cast<double>(best_y[j]));
   points.emplace_back(static_cast<double>(goal.x()), static_cast<double>(goal.y()));
   points.erase(std::unique(std::begin(points), std::end(points)), std::end(points));
 
@@ -147,12 +175,12 @@ bool PSO::plan(const Node& start, const Node& goal, std::vector<Node>& path, std
   }
 
   // Update inheritance particles based on optimal fitness
-  std::sort(particles.begin(), particles.end(),
-            [](const Particle& a, const Particle& b) { return a.best_fitness > b.best_fitness; });
-  inherited_particles_.clear();
+  std::vector<int> elite;
+  swarm_.elite(n_inherited_, elite, true);
+  inherited_particles_.resize(elite.size());
 
-  for (size_t inherit = 0; inherit < n_inherited_; ++inherit)
-    inherited_particles_.emplace_back(particles[inherit]);
+  for (size_t inherit = 0; inherit < elite.size(); ++inherit)
+    swarm_.getBestPosition(elite[inherit], inherited_particles_[inherit]);
 
   return !path.empty();
 }
@@ -248,126 +276,101 @@ void PSO::initializePositions(PositionSequence& initial_positions, const Node& s
 
 /**
  * @brief Calculate the value of fitness function
- * @param position  the control points calculated by PSO
+ * @param x          x of the control points calculated by PSO, point_num_ elements
+ * @param y          y of the control points calculated by PSO, point_num_ elements
+ * @param threshold  the evaluation stops once the fitness falls below it, returning an upper bound
  * @return fitness the value of fitness function
  */
-double PSO::calFitnessValue(std::vector<std::pair<int, int>> position)
+double PSO::calFitnessValue(const int* x, const int* y, double threshold)
 {
-  std::vector<std::pair<double, double>> points, b_path;
-  points.push_back(start_);
-  for (const auto& pos : position)
-    points.emplace_back(static_cast<double>(pos.first), static_cast<double>(pos.second));
-  points.push_back(goal_);
-  points.erase(std::unique(std::begin(points), std::end(points)), std::end(points));
+  double fitness;
+  if (cache_.find(x, y, point_num_, threshold, fitness))
+    return fitness;
+
+  // buffers of the calling thread, reused between evaluations
+  thread_local Eigen::MatrixX2d points, b_path;
+  points.resize(point_num_ + 2, 2);
+
+  // path points without consecutive duplicates
+  int n = 0;
+  auto add_point = [&](double x, double y) {
+    if ((n == 0) || (points(n - 1, 0) != x) || (points(n - 1, 1) != y))
+    {
+      points(n, 0) = x;
+      points(n, 1) = y;
+      n++;
+    }
+  };
+  add_point(start_.first, start_.second);
+  for (int j = 0; j < point_num_; ++j)
+    add_point(static_cast<double>(x[j]), static_cast<double>(y[j]));
+  add_point(goal_.first, goal_.second);
 
-  bspline_gen_.run(points, b_path);
+  if (!bspline_gen_.runUniform(points.topRows(n), b_path))
+    b_path.resize(0, 2);
 
-  // collision detection
+  // collision detection and path length
   int point_index;
-  double obs_cost = 1;
-  for (size_t i = 1; i < b_path.size(); ++i)
+  double obs_cost = 1, length = 0.0, offset = 0.0;
+  for (int i = 1; i < b_path.rows(); ++i)
   {
-    point_index = grid2Index(static_cast<int>(b_path[i].first), static_cast<int>(b_path[i].second));
+    point_index = grid2Index(static_cast<int>(b_path(i, 0)), static_cast<int>(b_path(i, 1)));
+    length += std::hypot(b_path(i, 0) - b_path(i - 1, 0), b_path(i, 1) - b_path(i - 1, 1));
+    // the footprint facing along the path, swept on every segment to keep the offset of the next one
+    const bool swept = footprint_checker_.sweep(b_path(i - 1, 0), b_path(i - 1, 1), b_path(i, 0), b_path(i, 1), offset);
     // next node hit the boundary or obstacle
-    if ((point_index < 0) || (point_index >= map_size_) ||
-        (costmap_->getCharMap()[point_index] >= costmap_2d::LETHAL_OBSTACLE * factor_))
+    bool collision = swept || (point_index < 0) || (point_index >= map_size_) ||
+                     (costmap_->getCharMap()[point_index] >= costmap_2d::LETHAL_OBSTACLE * factor_);
+    if (collision)
+    {
       obs_cost++;
+      // the fitness only decreases along the sweep, stop once it can no longer reach the threshold
+      fitness = 100000.0 / (length + 1000 * obs_cost);
+      if (fitness < threshold)
+      {
+        cache_.insert(x, y, point_num_, fitness, false);
+        return fitness;
+      }
+    }
   }
   // Calculate particle fitness
-  return 100000.0 / (bspline_gen_.len(b_path) + 1000 * obs_cost);
+  fitness = 100000.0 / (length + 1000 * obs_cost);
+  cache_.insert(x, y, point_num_, fitness, true);
+  return fitness;
 }
 
 /**
- * @brief A function to update the particle velocity
- * @param particle     Particles to be updated for velocity
- * @param global_best  Global optimal particle
- * @param gen          randomizer
+ * @brief Particle update optimization iteration, velocity and position are updated for the whole swarm before
+ * @param i       particle index
+ * @param expand  expand buffer of the calling worker
  */
-void PSO::updateParticleVelocity(Particle& particle, const Particle& global_best, std::mt19937& gen)
+void PSO::optimizeParticle(int i, std::vector<Node>& expand)
 {
-  // The random numbers are distributed between [0, 1).
-  std::uniform_real_distribution<double> dist(0.0, 1.0);
+  // Calculate fitness, only a value above the personal best has any effect
+  swarm_.fitness(i) = calFitnessValue(swarm_.x(i), swarm_.y(i), swarm_.bestFitness(i));
 
-  // update Velocity
-  for (size_t i = 0; i < point_num_; ++i)
-  {
-    double rand1 = dist(gen);
-    double rand2 = dist(gen);
-
-    particle.velocity[i].first =
-        static_cast<int>(w_inertial_ * particle.velocity[i].first +
-                         w_social_ * rand1 * (particle.best_pos[i].first - particle.position[i].first) +
-                         w_cognitive_ * rand2 * (global_best.position[i].first - particle.position[i].first));
-
-    particle.velocity[i].second =
-        static_cast<int>(w_inertial_ * particle.velocity[i].second +
-                         w_social_ * rand1 * (particle.best_pos[i].second - particle.position[i].second) +
-                         w_cognitive_ * rand2 * (global_best.position[i].second - particle.position[i].second));
-
-    // Velocity limit
-    particle.velocity[i].first = helper::clamp(particle.velocity[i].first, -1 * max_speed_, max_speed_);
-    particle.velocity[i].second = helper::clamp(particle.velocity[i].second, -1 * max_speed_, max_speed_);
-  }
+  // Update expand points
+  for (int j = 0; j < point_num_; ++j)
+    expand.emplace_back(Node(swarm_.x(i)[j], swarm_.y(i)[j]));
 }
 
 /**
- * @brief A function to update the particle position
- * @param particle     Particles to be updated for velocity
+ * @brief Check collisions with the robot footprint along the path, besides the centre cell against the inflated
+ *        costmap
+ * @param footprint footprint vertices in the robot frame in meters, empty to check the centre cell only
  */
-void PSO::updateParticlePosition(Particle& particle)
+void PSO::setFootprint(const std::vector<std::pair<double, double>>& footprint)
 {
-  // update Position
-  for (size_t i = 0; i < point_num_; ++i)
-  {
-    particle.position[i].first += particle.velocity[i].first;
-    particle.position[i].second += particle.velocity[i].second;
-
-    // Position limit
-    particle.position[i].first =
-        helper::clamp(particle.position[i].first, 1, static_cast<int>(costmap_->getSizeInCellsX()) - 1);
-    particle.position[i].second =
-        helper::clamp(particle.position[i].second, 1, static_cast<int>(costmap_->getSizeInCellsY()) - 1);
-  }
+  footprint_checker_.setFootprint(footprint, costmap_->getResolution());
 }
 
 /**
- * @brief Particle update optimization iteration
- * @param particle       Particles to be updated for velocity
- * @param best_particle  Global optimal particle
- * @param gen            randomizer
- * @param expand         containing the node been search during the process
+ * @brief Get the fitness cache of the last planning query
+ * @return fitness cache
  */
-void PSO::optimizeParticle(Particle& particle, Particle& best_particle, std::mt19937& gen, std::vector<Node>& expand)
+const FitnessCache& PSO::getFitnessCache() const
 {
-  // update speed
-  updateParticleVelocity(particle, best_particle, gen);
-  // update position
-  updateParticlePosition(particle);
-
-  // Calculate fitness
-  particle.fitness = calFitnessValue(particle.position);
-
-  // Update individual optima
-  if (particle.fitness > particle.best_fitness)
-  {
-    particle.best_fitness = particle.fitness;
-    particle.best_pos = particle.position;
-  }
-
-  // Update global optimal particles
-  particles_lock_.lock();
-
-  // Update expand points
-  for (auto pos : particle.position)
-    expand.emplace_back(Node(pos.first, pos.second));
-
-  if (particle.best_fitness > best_particle.fitness)
-  {
-    best_particle.fitness = particle.best_fitness;
-    best_particle.position = particle.position;
-  }
-
-  particles_lock_.unlock();
+  return cache_;
 }
 
 }  // namespace global_planner
\ No newline at end of file
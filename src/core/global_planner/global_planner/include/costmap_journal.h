@@ -0,0 +1,121 @@
+/**
+ * *********************************************************
+ *
+ * @file: costmap_journal.h
+ * @brief: Contains the versioned change journal of a costmap
+ * @author: Yang Haodong
+ * @date: 2024-10-11
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#ifndef COSTMAP_JOURNAL_H
+#define COSTMAP_JOURNAL_H
+
+#include <costmap_2d/costmap_2d.h>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#define JOURNAL_CAPACITY 1048576  // changed cells kept in the journal before the oldest versions are dropped
+
+namespace global_planner
+{
+/**
+ * @brief Versioned journal of the cells changed in a costmap. It keeps one snapshot of the char map, update() diffs
+ *        the costmap against it and records the changed cells as a new version. The diff compares 64-byte blocks
+ *        as eight 64-bit words and only walks the bytes of blocks which differ, so a quiet map costs one streaming
+ *        read of both arrays. Planners sharing a costmap share one journal, each keeps the version it last saw and
+ *        asks for the cells changed since then. The snapshot is copy-on-write: a subscriber holding it keeps reading
+ *        an unchanged map, update() writes a new one while the old one is still held.
+ */
+class CostmapJournal
+{
+public:
+  using Snapshot = std::shared_ptr<const std::vector<unsigned char>>;
+
+  /**
+   * @brief Construct a new Costmap Journal object
+   * @param costmap  the costmap to follow
+   * @param capacity changed cells kept before the oldest versions are dropped
+   */
+  CostmapJournal(costmap_2d::Costmap2D* costmap, int capacity = JOURNAL_CAPACITY);
+
+  /**
+   * @brief Journal shared by all subscribers of a costmap, created on first use
+   * @param costmap the costmap to follow
+   * @return the shared journal
+   */
+  static std::shared_ptr<CostmapJournal> instance(costmap_2d::Costmap2D* costmap);
+
+  /**
+   * @brief Diff the costmap against the snapshot and record the changed cells as a new version
+   * @return the current version
+   */
+  std::uint64_t update();
+
+  /**
+   * @brief Get the current version
+   * @return version, increased by every update() which found changes or a new map size
+   */
+  std::uint64_t version() const;
+
+  /**
+   * @brief Get the cells changed after a version, each cell listed once
+   * @param since version last seen by the caller
+   * @param cells indices of the changed cells
+   * @return false if the journal no longer covers the version or the map was resized, the caller has to treat
+   *         every cell as changed
+   */
+  bool changes(std::uint64_t since, std::vector<int>& cells) const;
+
+  /**
+   * @brief Get the snapshot of the char map as of the current version
+   * @return the snapshot, never changed by later updates while it is held
+   */
+  Snapshot map() const;
+
+protected:
+  /**
+   * @brief Changed cells of one version
+   */
+  struct Entry
+  {
+    std::uint64_t version;   // version which recorded the cells
+    std::vector<int> cells;  // indices of the changed cells
+  };
+
+  /**
+   * @brief Diff the costmap against the snapshot, copying and recording the changed cells
+   * @param map   char map of the costmap
+   * @param cells indices of the changed cells
+   */
+  void _diff(const unsigned char* map, std::vector<int>& cells);
+
+  /**
+   * @brief Get the snapshot for writing, copying it first if a subscriber still holds it
+   * @return the writable snapshot
+   */
+  unsigned char* _writable();
+
+protected:
+  costmap_2d::Costmap2D* costmap_;                   // costmap followed
+  int capacity_;                                     // changed cells kept in the journal
+  int size_;                                         // number of cells of the snapshot
+  std::uint64_t version_;                            // current version
+  std::uint64_t oldest_;                             // oldest version whose following changes are all kept
+  std::shared_ptr<std::vector<unsigned char>> map_;  // snapshot of the char map, shared with the subscribers
+  std::deque<Entry> entries_;                        // changed cells of the kept versions, ascending version
+  int journaled_;                                    // number of cells in entries_
+  mutable std::mutex mutex_;                         // guards the journal between planners
+};
+}  // namespace global_planner
+
+#endif  // COSTMAP_JOURNAL_H
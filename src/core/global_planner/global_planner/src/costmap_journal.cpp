@@ -0,0 +1,209 @@
+/**
+ * *********************************************************
+ *
+ * @file: costmap_journal.cpp
+ * @brief: Contains the versioned change journal of a costmap
+ * @author: Yang Haodong
+ * @date: 2024-10-11
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+#include "costmap_journal.h"
+
+#define DIFF_BLOCK 64  // bytes compared at once by the diff
+
+namespace global_planner
+{
+/**
+ * @brief Construct a new Costmap Journal object
+ * @param costmap  the costmap to follow
+ * @param capacity changed cells kept before the oldest versions are dropped
+ */
+CostmapJournal::CostmapJournal(costmap_2d::Costmap2D* costmap, int capacity)
+  : costmap_(costmap), capacity_(capacity), size_(0), version_(0), oldest_(0), journaled_(0)
+{
+  size_ = static_cast<int>(costmap_->getSizeInCellsX() * costmap_->getSizeInCellsY());
+  map_ = std::make_shared<std::vector<unsigned char>>(costmap_->getCharMap(), costmap_->getCharMap() + size_);
+}
+
+/**
+ * @brief Journal shared by all subscribers of a costmap, created on first use
+ * @param costmap the costmap to follow
+ * @return the shared journal
+ */
+std::shared_ptr<CostmapJournal> CostmapJournal::instance(costmap_2d::Costmap2D* costmap)
+{
+  static std::mutex registry_mutex;
+  static std::map<costmap_2d::Costmap2D*, std::weak_ptr<CostmapJournal>> registry;
+
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  std::shared_ptr<CostmapJournal> journal = registry[costmap].lock();
+  if (!journal)
+  {
+    journal = std::make_shared<CostmapJournal>(costmap);
+    registry[costmap] = journal;
+  }
+  return journal;
+}
+
+/**
+ * @brief Diff the costmap against the snapshot and record the changed cells as a new version
+ * @return the current version
+ */
+std::uint64_t CostmapJournal::update()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // a resized map invalidates every version seen so far
+  const int size = static_cast<int>(costmap_->getSizeInCellsX() * costmap_->getSizeInCellsY());
+  if (size != size_)
+  {
+    size_ = size;
+    map_ = std::make_shared<std::vector<unsigned char>>(costmap_->getCharMap(), costmap_->getCharMap() + size_);
+    entries_.clear();
+    journaled_ = 0;
+    oldest_ = ++version_;
+    return version_;
+  }
+
+  std::vector<int> cells;
+  _diff(costmap_->getCharMap(), cells);
+  if (cells.empty())
+    return version_;
+
+  journaled_ += static_cast<int>(cells.size());
+  entries_.push_back({ ++version_, std::move(cells) });
+
+  // drop the oldest versions beyond the capacity, the latest one is always kept
+  while (journaled_ > capacity_ && entries_.size() > 1)
+  {
+    journaled_ -= static_cast<int>(entries_.front().cells.size());
+    oldest_ = entries_.front().version;
+    entries_.pop_front();
+  }
+
+  return version_;
+}
+
+/**
+ * @brief Get the current version
+ * @return version, increased by every update() which found changes or a new map size
+ */
+std::uint64_t CostmapJournal::version() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return version_;
+}
+
+/**
+ * @brief Get the cells changed after a version, each cell listed once
+ * @param since version last seen by the caller
+ * @param cells indices of the changed cells
+ * @return false if the journal no longer covers the version or the map was resized, the caller has to treat
+ *         every cell as changed
+ */
+bool CostmapJournal::changes(std::uint64_t since, std::vector<int>& cells) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  cells.clear();
+  if (since < oldest_)
+    return false;
+
+  // versions are ascending, only the tail after since is read
+  auto it = std::upper_bound(entries_.begin(), entries_.end(), since,
+                             [](std::uint64_t v, const Entry& e) { return v < e.version; });
+  const bool merged = std::distance(it, entries_.end()) > 1;
+  for (; it != entries_.end(); ++it)
+    cells.insert(cells.end(), it->cells.begin(), it->cells.end());
+
+  // a cell changed in several versions is reported once
+  if (merged)
+  {
+    std::sort(cells.begin(), cells.end());
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+  }
+
+  return true;
+}
+
+/**
+ * @brief Get the snapshot of the char map as of the current version
+ * @return the snapshot, never changed by later updates while it is held
+ */
+CostmapJournal::Snapshot CostmapJournal::map() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return map_;
+}
+
+/**
+ * @brief Diff the costmap against the snapshot, copying and recording the changed cells
+ * @param map   char map of the costmap
+ * @param cells indices of the changed cells
+ */
+void CostmapJournal::_diff(const unsigned char* map, std::vector<int>& cells)
+{
+  // the snapshot is only copied once the first difference shows up
+  const unsigned char* snapshot = map_->data();
+  unsigned char* writable = nullptr;
+  auto record = [&](int j) {
+    if (!writable)
+      snapshot = writable = _writable();
+    writable[j] = map[j];
+    cells.push_back(j);
+  };
+  const int end = size_;
+  int i = 0;
+
+  // whole blocks, xor-ed as eight words and or-ed together, the loop has no branch and is vectorised
+  for (; i + DIFF_BLOCK <= end; i += DIFF_BLOCK)
+  {
+    std::uint64_t diff = 0;
+    for (int w = 0; w < DIFF_BLOCK; w += 8)
+    {
+      std::uint64_t a, b;
+      std::memcpy(&a, map + i + w, 8);
+      std::memcpy(&b, snapshot + i + w, 8);
+      diff |= a ^ b;
+    }
+    if (diff == 0)
+      continue;
+
+    for (int j = i; j < i + DIFF_BLOCK; j++)
+    {
+      if (map[j] != snapshot[j])
+        record(j);
+    }
+  }
+
+  // remaining bytes
+  for (; i < end; i++)
+  {
+    if (map[i] != snapshot[i])
+      record(i);
+  }
+}
+
+/**
+ * @brief Get the snapshot for writing, copying it first if a subscriber still holds it
+ * @return the writable snapshot
+ */
+unsigned char* CostmapJournal::_writable()
+{
+  // subscribers only gain references through map(), which waits for the lock held by the caller
+  if (map_.use_count() > 1)
+    map_ = std::make_shared<std::vector<unsigned char>>(*map_);
+  return map_->data();
+}
+}  // namespace global_planner
@@ -17,23 +17,27 @@
 #ifndef A_STAR_H
 #define A_STAR_H
 
+#include <memory>
+
 #include "global_planner.h"
+#include "landmark_heuristic.h"
 
 namespace global_planner
 {
 /**
- * @brief Class for objects that plan using the A* algorithm
+ * @brief Class for objects that plan using the A* algorithm, optionally guided by the ALT heuristics of landmarks
  */
 class AStar : public GlobalPlanner
 {
 public:
   /**
    * @brief Construct a new AStar object
-   * @param costmap  the environment for path planning
-   * @param dijkstra using diksktra implementation
-   * @param gbfs     using gbfs implementation
+   * @param costmap   the environment for path planning
+   * @param dijkstra  using diksktra implementation
+   * @param gbfs      using gbfs implementation
+   * @param landmarks number of landmarks of the ALT heuristics, 0 for the Euclidean distance only
    */
-  AStar(costmap_2d::Costmap2D* costmap, bool dijkstra = false, bool gbfs = false);
+  AStar(costmap_2d::Costmap2D* costmap, bool dijkstra = false, bool gbfs = false, int landmarks = 0);
 
   /**
    * @brief A* implementation
@@ -46,8 +50,9 @@ public:
   bool plan(const Node& start, const Node& goal, std::vector<Node>& path, std::vector<Node>& expand);
 
 private:
-  bool is_dijkstra_;  // using diksktra
-  bool is_gbfs_;      // using greedy best first search(GBFS)
+  bool is_dijkstra_;                              // using diksktra
+  bool is_gbfs_;                                  // using greedy best first search(GBFS)
+  std::unique_ptr<LandmarkHeuristic> landmarks_;  // ALT heuristics, nullptr for the Euclidean distance only
 };
 }  // namespace global_planner
 #endif
@@ -18,10 +18,11 @@
 #define D_STAR_H
 
 #include "global_planner.h"
+#include "costmap_journal.h"
+#include "indexed_heap.h"
 
 namespace global_planner
 {
-typedef DNode* DNodePtr;
 
 /**
  * @brief Class for objects that plan using the D* algorithm
@@ -46,34 +47,34 @@ public:
   void reset();
 
   /**
-   * @brief Insert nodePtr into the open_list with h_new
-   * @param node_ptr DNode pointer of the DNode to be inserted
-   * @param h_new    new h value
+   * @brief Insert a cell into the open_list with h_new
+   * @param s     index of the cell to be inserted
+   * @param h_new new h value
    */
-  void insert(DNodePtr node_ptr, double h_new);
+  void insert(int s, double h_new);
 
   /**
    * @brief Check if there is collision between n1 and n2
-   * @param n1 DNode pointer of one DNode
-   * @param n2 DNode pointer of the other DNode
+   * @param n1 index of one cell
+   * @param n2 index of the other cell
    * @return true if collision, else false
    */
-  bool isCollision(DNodePtr n1, DNodePtr n2);
+  bool isCollision(int n1, int n2);
 
   /**
-   * @brief Get neighbour DNodePtrs of nodePtr
-   * @param node_ptr   DNode to expand
-   * @param neighbours neigbour DNodePtrs in vector
+   * @brief Get neighbour cells of a cell
+   * @param s          index of the cell to expand
+   * @param neighbours neigbour cell indices in vector
    */
-  void getNeighbours(DNodePtr node_ptr, std::vector<DNodePtr>& neighbours);
+  void getNeighbours(int s, std::vector<int>& neighbours);
 
   /**
    * @brief Get the cost between n1 and n2, return INF if collision
-   * @param n1 DNode pointer of one DNode
-   * @param n2 DNode pointer of the other DNode
+   * @param n1 index of one cell
+   * @param n2 index of the other cell
    * @return cost between n1 and n2
    */
-  double getCost(DNodePtr n1, DNodePtr n2);
+  double getCost(int n1, int n2);
 
   /**
    * @brief Main process of D*
@@ -103,9 +104,9 @@ public:
 
   /**
    * @brief Modify the map when collision occur between x and y in path, and then do processState()
-   * @param x DNode pointer of one DNode
+   * @param x index of the cell
    */
-  void modify(DNodePtr x);
+  void modify(int x);
 
   /**
    * @brief D* implementation
@@ -116,14 +117,24 @@ public:
    */
   bool plan(const Node& start, const Node& goal, std::vector<Node>& path, std::vector<Node>& expand);
 
+protected:
+  /**
+   * @brief Convert a cell and its search state to Node
+   * @param s index of the cell
+   * @return node of the cell
+   */
+  Node _getNode(int s);
+
 public:
-  unsigned char* curr_global_costmap_;         // current global costmap
-  unsigned char* last_global_costmap_;         // last global costmap
-  DNodePtr** map_;                             // grid pointer map
-  std::multimap<double, DNodePtr> open_list_;  // open list, ascending order
-  std::vector<Node> path_;                     // path
-  std::vector<Node> expand_;                   // expand
-  Node goal_;                                  // last goal
+  std::shared_ptr<CostmapJournal> journal_;   // change journal of the costmap
+  std::uint64_t version_;                     // journal version of the last plan
+  const unsigned char* curr_global_costmap_;  // costmap snapshot of the journal
+  CostmapJournal::Snapshot snapshot_;         // held snapshot, not rewritten by other planners
+  GridStateTable states_;                     // search state of every cell
+  IndexedHeap open_list_;                     // open list of cell indices keyed on k and then g
+  std::vector<Node> path_;                    // path
+  std::vector<Node> expand_;                  // expand
+  Node goal_;                                 // last goal
 };
 }  // namespace global_planner
 
@@ -18,10 +18,11 @@
 #define D_STAR_LITE_H
 
 #include "global_planner.h"
+#include "costmap_journal.h"
+#include "indexed_heap.h"
 
 namespace global_planner
 {
-typedef LNode* LNodePtr;
 
 /**
  * @brief Class for objects that plan using the LPA* algorithm
@@ -47,47 +48,47 @@ public:
 
   /**
    * @brief Get heuristics between n1 and n2
-   * @param n1 LNode pointer of on LNode
-   * @param n2 LNode pointer of the other LNode
+   * @param n1 index of one cell
+   * @param n2 index of the other cell
    * @return heuristics between n1 and n2
    */
-  double getH(LNodePtr n1, LNodePtr n2);
+  double getH(int n1, int n2);
 
   /**
    * @brief Calculate the key of s
-   * @param s LNode pointer
+   * @param s index of the cell
    * @return the key value
    */
-  double calculateKey(LNodePtr s);
+  IndexedHeap::Key calculateKey(int s);
 
   /**
    * @brief Check if there is collision between n1 and n2
-   * @param n1 LNode pointer of one LNode
-   * @param n2 LNode pointer of the other LNode
+   * @param n1 index of one cell
+   * @param n2 index of the other cell
    * @return true if collision, else false
    */
-  bool isCollision(LNodePtr n1, LNodePtr n2);
+  bool isCollision(int n1, int n2);
 
   /**
-   * @brief Get neighbour LNodePtrs of nodePtr
-   * @param node_ptr   LNode to expand
-   * @param neighbours neigbour LNodePtrs in vector
+   * @brief Get neighbour cells of a cell, except those in collision
+   * @param s          index of the cell to expand
+   * @param neighbours neigbour cell indices in vector
    */
-  void getNeighbours(LNodePtr u, std::vector<LNodePtr>& neighbours);
+  void getNeighbours(int s, std::vector<int>& neighbours);
 
   /**
    * @brief Get the cost between n1 and n2, return INF if collision
-   * @param n1 LNode pointer of one LNode
-   * @param n2 LNode pointer of the other LNode
+   * @param n1 index of one cell
+   * @param n2 index of the other cell
    * @return cost between n1 and n2
    */
-  double getCost(LNodePtr n1, LNodePtr n2);
+  double getCost(int n1, int n2);
 
   /**
    * @brief Update vertex u
-   * @param u LNode pointer to update
+   * @param u index of the cell to update
    */
-  void updateVertex(LNodePtr u);
+  void updateVertex(int u);
 
   /**
    * @brief Main process of D* lite
@@ -111,16 +112,26 @@ public:
    */
   bool plan(const Node& start, const Node& goal, std::vector<Node>& path, std::vector<Node>& expand);
 
+protected:
+  /**
+   * @brief Convert a cell and its search state to Node
+   * @param s index of the cell
+   * @return node of the cell
+   */
+  Node _getNode(int s);
+
 public:
-  unsigned char* curr_global_costmap_;         // current global costmap
-  unsigned char* last_global_costmap_;         // last global costmap
-  LNodePtr** map_;                             // grid pointer map
-  std::multimap<double, LNodePtr> open_list_;  // open list, ascending order
-  std::vector<Node> path_;                     // path
-  std::vector<Node> expand_;                   // expand
-  Node start_, goal_;                          // start and goal
-  LNodePtr start_ptr_, goal_ptr_, last_ptr_;   // start and goal ptr
-  double km_;                                  // correction
+  std::shared_ptr<CostmapJournal> journal_;   // change journal of the costmap
+  std::uint64_t version_;                     // journal version of the last plan
+  const unsigned char* curr_global_costmap_;  // costmap snapshot of the journal
+  CostmapJournal::Snapshot snapshot_;         // held snapshot, not rewritten by other planners
+  GridStateTable states_;                     // search state of every cell
+  IndexedHeap open_list_;                     // open list of cell indices keyed on [min(g, rhs) + h, min(g, rhs)]
+  std::vector<Node> path_;                    // path
+  std::vector<Node> expand_;                  // expand
+  Node start_, goal_;                         // start and goal
+  int start_idx_, goal_idx_, last_idx_;       // start and goal cell indices
+  double km_;                                 // correction
 };
 
 }  // namespace global_planner
@@ -23,7 +23,6 @@
 #include <nav_msgs/GetPlan.h>
 
 #include "global_planner.h"
-#include "dynamicvoronoi.h"
 
 namespace graph_planner
 {
@@ -108,7 +107,6 @@ private:
   bool is_voronoi_map_;                                   // whether to store Voronoi map or not
   double tolerance_;                                      // tolerance
   double factor_;                                         // obstacle inflation factor
-  DynamicVoronoi voronoi_;                                // dynamic voronoi map
   std::vector<geometry_msgs::PoseStamped> history_plan_;  // history plan
 };
 }  // namespace graph_planner
@@ -0,0 +1,100 @@
+/**
+ * *********************************************************
+ *
+ * @file: grid_state_table.h
+ * @brief: Contains the per-cell state table of the incremental planners
+ * @author: Yang Haodong
+ * @date: 2024-10-09
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#ifndef GRID_STATE_TABLE_H
+#define GRID_STATE_TABLE_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace global_planner
+{
+/**
+ * @brief Search state of every map cell for D*, LPA* and D* Lite, stored as one contiguous array per field and
+ *        addressed by the cell index. Every cell carries the epoch which wrote it, a cell of an older epoch reads
+ *        as untouched and is initialised on its first access, so resetting the table is a counter increment. The
+ *        value arrays are left uninitialised, the memory of cells a search never reaches is not even committed.
+ */
+class GridStateTable
+{
+public:
+  enum Tag
+  {
+    NEW = 0,
+    OPEN = 1,
+    CLOSED = 2
+  };
+
+  /**
+   * @brief Construct a new Grid State Table object
+   */
+  GridStateTable();
+
+  /**
+   * @brief Make every cell untouched. O(1) unless the map size changed.
+   * @param nx map size in cells along x
+   * @param ny map size in cells along y
+   */
+  void reset(unsigned int nx, unsigned int ny);
+
+  /**
+   * @brief Access the fields of a cell, an untouched cell reads g = rhs = key = INF, no parent, tag NEW and
+   *        no position in the open heap
+   * @param i cell index
+   * @return reference to the field
+   */
+  double& g(int i);
+  double& rhs(int i);
+  double& key(int i);
+  int& parent(int i);
+  unsigned char& tag(int i);
+  int& position(int i);
+
+  /**
+   * @brief Whether a cell has been touched since the last reset
+   * @param i cell index
+   * @return true if touched, else false
+   */
+  bool touched(int i) const;
+
+  /**
+   * @brief Get the number of cells
+   * @return cells number
+   */
+  int size() const;
+
+protected:
+  /**
+   * @brief Initialise a cell of an older epoch
+   * @param i cell index
+   */
+  void _touch(int i);
+
+protected:
+  int size_;                              // number of cells
+  std::uint32_t epoch_;                   // epoch of the current search
+  std::vector<std::uint32_t> stamp_;      // epoch which last wrote each cell
+  std::unique_ptr<double[]> g_;           // cost to come of each cell
+  std::unique_ptr<double[]> rhs_;         // one-step lookahead cost of each cell
+  std::unique_ptr<double[]> key_;         // priority of each cell in the open list
+  std::unique_ptr<int[]> parent_;         // parent cell index, -1 if none
+  std::unique_ptr<int[]> position_;       // position in the open heap, -1 if not queued
+  std::unique_ptr<unsigned char[]> tag_;  // tag of each cell among enum Tag
+};
+}  // namespace global_planner
+
+#endif  // GRID_STATE_TABLE_H
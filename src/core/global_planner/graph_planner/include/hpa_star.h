@@ -0,0 +1,178 @@
+/**
+ * *********************************************************
+ *
+ * @file: hpa_star.h
+ * @brief: Contains the hierarchical path-finding A* (HPA*) planner class
+ * @author: Yang Haodong
+ * @date: 2024-05-20
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#ifndef HPA_STAR_H
+#define HPA_STAR_H
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "global_planner.h"
+#include "costmap_journal.h"
+#include "a_star.h"
+
+#define ENTRANCE_WIDTH 6  // free runs along a border at least this wide get an entrance at each end instead of one
+
+namespace global_planner
+{
+/**
+ * @brief Class for objects that plan using hierarchical path-finding A* (HPA*). The map is cut into square clusters,
+ *        entrances are placed along the free runs of every border shared by two clusters and connected within their
+ *        cluster by the cost of the shortest path between them. A plan links start and goal into this abstract
+ *        graph, searches it and refines every abstract edge by a search bounded to one cluster. The abstraction is
+ *        kept across plans, costmap changes only rebuild the clusters whose passability changed.
+ */
+class HPAStar : public GlobalPlanner
+{
+public:
+  /**
+   * @brief Construct a new HPAStar object
+   * @param costmap      the environment for path planning
+   * @param cluster_size side of the square clusters in cells
+   */
+  HPAStar(costmap_2d::Costmap2D* costmap, int cluster_size = 32);
+
+  /**
+   * @brief HPA* implementation
+   * @param start  start node
+   * @param goal   goal node
+   * @param path   path consists of Node
+   * @param expand containing the node been search during the process
+   * @return true if path found, else false
+   */
+  bool plan(const Node& start, const Node& goal, std::vector<Node>& path, std::vector<Node>& expand);
+
+protected:
+  /**
+   * @brief Entrance cell of a cluster, a vertex of the abstract graph
+   */
+  struct Entrance
+  {
+    int cell;                                  // index of the cell
+    int cluster;                               // cluster of the cell
+    int partner;                               // entrance across the border, -1 for a removed entrance
+    std::vector<std::pair<int, double>> arcs;  // entrances of the same cluster reachable within it and their costs
+  };
+
+  /**
+   * @brief Bring the abstraction up to date with the costmap, rebuilding it or repairing the changed clusters
+   */
+  void _update();
+
+  /**
+   * @brief Build the abstraction of the whole map
+   */
+  void _build();
+
+  /**
+   * @brief Remove and place again the entrances of the straight and diagonal passages across a border
+   * @param border border index, cluster * 2 for its east border and cluster * 2 + 1 for its north border
+   */
+  void _buildBorder(int border);
+
+  /**
+   * @brief Add a pair of entrances facing each other across a border
+   * @param border border index
+   * @param c1     cell on the side of the cluster owning the border
+   * @param c2     cell on the other side
+   */
+  void _addEntrances(int border, int c1, int c2);
+
+  /**
+   * @brief Compute the costs between the entrances of a cluster
+   * @param cluster cluster index
+   */
+  void _connectCluster(int cluster);
+
+  /**
+   * @brief Search within a cluster from a cell until all targets are expanded, A* towards a single target and
+   *        Dijkstra towards several
+   * @param cluster cluster index
+   * @param from    index of the start cell
+   * @param targets indices of the target cells within the cluster
+   * @param expand  cells expanded are appended unless nullptr
+   */
+  void _searchCluster(int cluster, int from, const std::vector<int>& targets, std::vector<Node>* expand);
+
+  /**
+   * @brief Get the cost found by the last cluster search to a cell of that cluster
+   * @param cell index of the cell
+   * @return cost, infinity if not reached
+   */
+  double _clusterCost(int cell) const;
+
+  /**
+   * @brief Get the cluster of a cell
+   * @param cell index of the cell
+   * @return cluster index
+   */
+  int _cluster(int cell) const;
+
+  /**
+   * @brief Whether a cell can be entered
+   * @param cell index of the cell
+   * @return true if the cell is not an obstacle
+   */
+  bool _passable(int cell) const;
+
+  /**
+   * @brief Octile distance between two cells, a consistent heuristics of the 8-connected grid
+   * @param c1 index of one cell
+   * @param c2 index of the other cell
+   * @return distance in cells
+   */
+  double _octile(int c1, int c2) const;
+
+protected:
+  int cluster_size_;                                 // side of the clusters in cells
+  int nx_, ny_;                                      // map size in cells
+  int ncx_, ncy_;                                    // map size in clusters
+  float built_factor_;                               // obstacle factor the abstraction was built with
+  bool built_;                                       // whether the abstraction is built
+  std::shared_ptr<CostmapJournal> journal_;          // change journal of the costmap
+  std::uint64_t version_;                            // journal version the abstraction was built or repaired for
+  const unsigned char* map_;                         // costmap snapshot of the journal
+  CostmapJournal::Snapshot snapshot_;                // held snapshot, not rewritten by other planners
+  std::vector<unsigned char> passable_;              // passability the abstraction was built for
+  std::vector<Entrance> entrances_;                  // vertices of the abstract graph
+  std::vector<int> free_entrances_;                  // removed entries of entrances_ to be reused
+  std::vector<std::vector<int>> cluster_entrances_;  // entrances of each cluster
+  std::vector<std::vector<int>> border_entrances_;   // entrances placed along each border, on both sides
+
+  // search within one cluster, indexed by the cell relative to the cluster corner and stamped per search
+  int local_x0_, local_y0_;                         // corner of the cluster searched last
+  std::uint32_t local_stamp_;                       // stamp of the last search
+  std::vector<std::uint32_t> local_seen_;           // stamp of the search which reached the cell
+  std::vector<double> local_g_;                     // cost from the start cell
+  std::vector<int> local_parent_;                   // parent cell, -1 for the start cell
+  std::vector<std::uint32_t> local_closed_;         // stamp of the search which expanded the cell
+  std::vector<std::uint32_t> local_target_;         // stamp of the search which targets the cell
+  std::vector<std::pair<double, int>> local_open_;  // open list of the search, a binary heap on the priority
+
+  // search over the abstract graph, indexed by entrance with start and goal appended and stamped per plan
+  std::uint32_t abstract_stamp_;                   // stamp of the last plan
+  std::vector<std::uint32_t> abstract_seen_;       // stamp of the plan which reached the vertex
+  std::vector<double> abstract_g_;                 // cost from the start
+  std::vector<int> abstract_parent_;               // parent vertex, -1 for the start
+  std::vector<std::uint32_t> abstract_closed_;     // stamp of the plan which expanded the vertex
+  std::vector<std::pair<int, double>> goal_arcs_;  // entrances of the goal cluster and their costs to the goal
+
+  AStar fallback_;  // search over cells when start or goal is blocked
+};
+}  // namespace global_planner
+#endif
@@ -20,12 +20,25 @@
 #include "global_planner.h"
 #include "a_star.h"
 #include "dubins_curve.h"
+#include "reeds_shepp_curve.h"
+#include "hybrid_state_table.h"
+#include "footprint_checker.h"
 
 #define PENALTY_TURNING 1.05
 #define PENALTY_COD 1.5
 #define PENALTY_REVERSING 1.5
 #define HEADINGS 72
 #define DELTA_HEADING (2 * M_PI / HEADINGS)
+#define MOTIONS 6
+#define MOTION_RADIUS 1.3
+#define MOTION_HEADINGS 3
+#define HEURISTIC_RANGE 6
+#define HEURISTIC_STEP 0.25
+#define SHOT_RANGE 50.0
+#define SHOT_SPACING 2.0
+#define SHOT_SLACK 1.1
+#define SHOT_CACHE 4096
+#define SHOT_RETRY 2.0
 
 namespace global_planner
 {
@@ -73,10 +86,10 @@ public:
     bool operator!=(const HybridNode& n) const;
 
     /**
-     * @brief Get permissible motion
+     * @brief Get permissible motion, built once
      * @return  Node vector of permissible motions
      */
-    static std::vector<HybridNode> getMotion();
+    static const std::vector<HybridNode>& getMotion();
 
   public:
     double x_, y_, t_;
@@ -108,13 +121,19 @@ public:
   bool plan(HybridNode& start, HybridNode& goal, std::vector<Node>& path, std::vector<Node>& expand);
 
   /**
-   * @brief Try using Dubins curves to connect the start and goal
+   * @brief Check collisions with the robot footprint instead of the centre cell against the inflated costmap
+   * @param footprint footprint vertices in the robot frame in meters, empty to check the centre cell only
+   */
+  void setFootprint(const std::vector<std::pair<double, double>>& footprint);
+
+  /**
+   * @brief Try using a Dubins curve (Reeds-Shepp if reversing) to connect the start and goal
    * @param start          start node
    * @param goal           goal node
-   * @param path           dubins path between start and goal
+   * @param path           curve between start and goal in cells, without the start
    * @return true if shot successfully, else false
    */
-  bool dubinsShot(const HybridNode& start, const HybridNode& goal, std::vector<Node>& path);
+  bool analyticShot(const HybridNode& start, const HybridNode& goal, std::vector<Node>& path);
 
   /**
    * @brief update index of hybrid node
@@ -123,13 +142,14 @@ public:
   void updateIndex(HybridNode& node);
 
   /**
-   * @brief update the h-value of hybrid node
+   * @brief update the h-value of hybrid node, the larger of the 2D search cost and the non-holonomic cost
    * @param node hybrid node to update
    */
   void updateHeuristic(HybridNode& node);
 
   /**
-   * @brief generate heurisitic map using A* algorithm, each matric of map is the distance between it and start.
+   * @brief generate heurisitic map using Dijkstra algorithm, each matric of map is the obstacle-aware distance
+   *        between it and start, infinite if it cannot reach the start.
    * @param start start node
    */
   void genHeurisiticMap(const Node& start);
@@ -139,27 +159,102 @@ protected:
    * @brief Tranform from world map(x, y) to grid index(i)
    * @param wx world map x
    * @param wy world map y
-   * @return index
+   * @return index, -1 if outside the map
    */
   int _worldToIndex(double wx, double wy);
 
   /**
-   * @brief Convert closed list to path
-   * @param closed_list closed list
-   * @param start       start node
-   * @param goal        goal node
-   * @return vector containing path nodes
+   * @brief Convert the parent chain of a searched state to path
+   * @param slot  slot of the last state in the state table
+   * @return vector containing path nodes, from the last state back to the start
+   */
+  std::vector<Node> _convertStatesToPath(int slot);
+
+  /**
+   * @brief Tabulate every motion primitive from every discrete heading, with the points it sweeps sampled in cells
+   *        at half the costmap resolution
+   */
+  void _buildPrimitives();
+
+  /**
+   * @brief Tabulate the obstacle-free Dubins (Reeds-Shepp if reversing) length to every goal pose relative to
+   *        the vehicle, in turning radii
+   */
+  void _buildHeuristicTable();
+
+  /**
+   * @brief Fingerprint of the costmap content, the heuristic map is rebuilt when it changes
+   * @return hash of the map size and costs
+   */
+  std::uint64_t _hashCostmap() const;
+
+  /**
+   * @brief Cost from which a cell blocks the robot centre, with a footprint only the cells inflated by the
+   *        inscribed radius do
+   * @return obstacle cost
+   */
+  double _obstacleCost() const;
+
+  /**
+   * @brief Motion primitive starting from a discrete heading
    */
-  std::vector<Node> _convertClosedListToPath(std::unordered_map<int, HybridNode>& closed_list, const HybridNode& start,
-                                             const HybridNode& goal);
+  struct Primitive
+  {
+    double dx, dy;               // successor offset in world frame
+    int heading;                 // successor heading
+    int sweep_begin, sweep_end;  // offsets sampled along the arc in sweep_, the last one is the successor
+  };
+
+  /**
+   * @brief Open list entry, the node itself stays in the state table
+   */
+  struct OpenEntry
+  {
+    double f, h;  // total and heuristic cost when pushed
+    int slot;     // slot in the state table
+  };
+
+  /**
+   * @brief Heap order of the open list, lowest f first and lowest h on ties
+   */
+  struct compare_open
+  {
+    bool operator()(const OpenEntry& e1, const OpenEntry& e2) const;
+  };
+
+  /**
+   * @brief Failed analytic shot, keyed by a neighbourhood of cells and headings around its start. It only
+   *        stands for the poses of the neighbourhood which are not closer to the goal than its start.
+   */
+  struct ShotFailure
+  {
+    std::uint64_t key;   // neighbourhood of the start pose
+    std::uint32_t plan;  // plan in which the shot failed
+    float h;             // heuristic cost of the start pose
+  };
 
 protected:
-  HybridNode goal_;                           // the history goal point
-  std::unordered_map<int, Node> h_map_;       // heurisitic map
-  bool is_reverse_;                           // whether reverse operation is allowed
-  double max_curv_;                           // maximum curvature of model
-  trajectory_generation::Dubins dubins_gen_;  // dubins curve generator
-  std::shared_ptr<AStar> a_star_planner_;     // A* planner
+  HybridNode goal_;                                    // the history goal point
+  std::vector<float> h_map_;                           // heurisitic map, cost to the goal of each cell in meters
+  std::uint64_t h_map_hash_;                           // fingerprint of the costmap the heuristic map was built on
+  std::vector<float> h_table_;                         // non-holonomic cost of relative goal poses, in turning radii
+  bool is_reverse_;                                    // whether reverse operation is allowed
+  double max_curv_;                                    // maximum curvature of model
+  trajectory_generation::Dubins dubins_gen_;           // dubins curve generator
+  trajectory_generation::ReedsShepp rs_gen_;           // reeds-shepp curve generator, used if reversing
+  std::vector<std::pair<int, double>> shot_segments_;  // motion segments of the last analytic shot
+  std::vector<ShotFailure> shot_failures_;             // recent failed shots, direct-mapped on their key
+  std::uint32_t shot_plan_;                            // number of plans, failures of earlier plans are stale
+  std::shared_ptr<AStar> a_star_planner_;              // A* planner
+  HybridStateTable states_;                            // searched states, reused between plans
+  std::vector<Primitive> primitives_;                  // primitives, indexed heading * MOTIONS + motion
+  std::vector<std::pair<double, double>> sweep_;       // offsets in cells sampled along the primitives
+  double motion_cost_[MOTIONS][MOTIONS];               // cost of a primitive given the previous one
+  double sweep_res_;                                   // costmap resolution the sweeps were sampled for
+  std::vector<OpenEntry> open_list_;                   // binary heap of open states, reused between plans
+  std::vector<std::pair<double, double>> footprint_;   // robot footprint in meters, empty to check the centre only
+  helper::FootprintChecker footprint_checker_;         // footprint masks and obstacle bitmap of the costmap
+  std::uint64_t footprint_hash_;                       // fingerprint of the costmap the obstacle bitmap was built on
 };
 }  // namespace global_planner
 #endif
\ No newline at end of file
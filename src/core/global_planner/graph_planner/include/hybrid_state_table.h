@@ -0,0 +1,129 @@
+/**
+ * *********************************************************
+ *
+ * @file: hybrid_state_table.h
+ * @brief: Contains the heading-aware state table of the Hybrid A* planner
+ * @author: Yang Haodong
+ * @date: 2024-10-05
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#ifndef HYBRID_STATE_TABLE_H
+#define HYBRID_STATE_TABLE_H
+
+#include <cstdint>
+#include <vector>
+
+namespace global_planner
+{
+/**
+ * @brief Lookup table from a discrete state (lattice x, lattice y, heading) to the search node reached in it.
+ *        A lattice cell is a square of map cells about as long as a motion primitive, a finer lattice lets
+ *        nearly every expansion open a new state and the search never prunes. The x * y * headings states
+ *        are stored densely in square tiles which are allocated on first touch, so a large map only pays
+ *        for the region the search visits. Every slot carries the generation which wrote it, starting a
+ *        new search is a counter increment and the tiles and the node pool are reused between searches.
+ */
+class HybridStateTable
+{
+public:
+  /**
+   * @brief Search node of a discrete state, the continuous pose is the one which reached it first with
+   *        the lowest cost
+   */
+  struct State
+  {
+    double x, y, t;  // continuous pose in world frame
+    double g, h;     // cost to get to this state and heuristic cost
+    int parent;      // slot of the parent state, -1 for the start
+    int prim;        // motion primitive which reached this state
+    int heading;     // discrete heading
+    bool closed;     // whether the state has been expanded
+  };
+
+  /**
+   * @brief Construct a new Hybrid State Table object
+   * @param headings number of discrete headings
+   */
+  explicit HybridStateTable(int headings);
+
+  /**
+   * @brief Start a new search, all states become unvisited. O(1) unless the map or lattice size changed.
+   * @param nx      map size in cells along x
+   * @param ny      map size in cells along y
+   * @param lattice lattice cell side in map cells
+   */
+  void reset(unsigned int nx, unsigned int ny, unsigned int lattice = 1);
+
+  /**
+   * @brief Discrete heading of an angle
+   * @param t angle in radians
+   * @return heading index in [0, headings)
+   */
+  int heading(double t) const;
+
+  /**
+   * @brief Get the slot of a discrete state in the node pool
+   * @param mx      map cell x, inside the map
+   * @param my      map cell y, inside the map
+   * @param heading heading index
+   * @return reference to the slot, -1 if the state has not been visited in this search
+   */
+  int& slot(unsigned int mx, unsigned int my, int heading);
+
+  /**
+   * @brief Append a node to the pool
+   * @param state node to append
+   * @return slot of the node
+   */
+  int push(const State& state);
+
+  /**
+   * @brief Access a node of the pool
+   * @param slot slot of the node
+   * @return node
+   */
+  State& operator[](int slot);
+  const State& operator[](int slot) const;
+
+  /**
+   * @brief Get the number of nodes created in this search
+   * @return nodes number
+   */
+  int size() const;
+
+  /**
+   * @brief Get the memory held by the tiles and the node pool
+   * @return memory in bytes
+   */
+  std::size_t memory() const;
+
+protected:
+  /**
+   * @brief Slot of a discrete state, valid only if it was written by the current generation
+   */
+  struct Entry
+  {
+    std::uint32_t stamp;  // generation which wrote the slot
+    int slot;             // slot in the node pool
+  };
+
+  static constexpr int kTile = 16;  // tile side in lattice cells
+
+  int headings_;                           // number of discrete headings
+  unsigned int nx_, ny_;                   // map size in cells
+  unsigned int lattice_;                   // lattice cell side in map cells
+  unsigned int tiles_x_;                   // number of tiles along x
+  std::uint32_t generation_;               // generation of the current search
+  std::vector<std::vector<Entry>> tiles_;  // kTile * kTile * headings entries of each touched tile
+  std::vector<State> pool_;                // nodes of the current search
+};
+}  // namespace global_planner
+
+#endif  // HYBRID_STATE_TABLE_H
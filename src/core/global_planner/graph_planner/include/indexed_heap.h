@@ -0,0 +1,129 @@
+/**
+ * *********************************************************
+ *
+ * @file: indexed_heap.h
+ * @brief: Contains the indexed open heap of the incremental planners
+ * @author: Yang Haodong
+ * @date: 2024-10-10
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#ifndef INDEXED_HEAP_H
+#define INDEXED_HEAP_H
+
+#include <vector>
+
+#include "grid_state_table.h"
+
+namespace global_planner
+{
+/**
+ * @brief Open list of D*, LPA* and D* Lite, a 4-ary min-heap of cells. The heap position of every queued cell is
+ *        kept in the state table next to its other fields, so a cell is queued at most once and its key can be
+ *        decreased, increased or removed in place without searching for it.
+ */
+class IndexedHeap
+{
+public:
+  /**
+   * @brief Two-component priority, compared lexicographically
+   */
+  struct Key
+  {
+    double k1, k2;
+
+    bool operator<(const Key& other) const;
+    bool operator<=(const Key& other) const;
+  };
+
+  /**
+   * @brief Construct a new Indexed Heap object
+   * @param states state table which holds the heap position of each cell
+   */
+  explicit IndexedHeap(GridStateTable& states);
+
+  /**
+   * @brief Remove every cell from the heap
+   */
+  void clear();
+
+  /**
+   * @brief Whether the heap is empty
+   */
+  bool empty() const;
+
+  /**
+   * @brief Get the number of queued cells
+   * @return cells number
+   */
+  int size() const;
+
+  /**
+   * @brief Get the cell with the lowest key and its key, the heap must not be empty
+   */
+  int top() const;
+  const Key& topKey() const;
+
+  /**
+   * @brief Remove the cell with the lowest key, the heap must not be empty
+   * @return the removed cell
+   */
+  int pop();
+
+  /**
+   * @brief Whether a cell is queued
+   * @param s index of the cell
+   * @return true if queued, else false
+   */
+  bool contains(int s) const;
+
+  /**
+   * @brief Get the key of a queued cell
+   * @param s index of the cell
+   * @return key of the cell
+   */
+  const Key& key(int s) const;
+
+  /**
+   * @brief Queue a cell with a key, or move it to the key if it is queued already
+   * @param s index of the cell
+   * @param k key of the cell
+   */
+  void push(int s, const Key& k);
+
+  /**
+   * @brief Remove a cell from the heap, nothing happens if it is not queued
+   * @param s index of the cell
+   */
+  void remove(int s);
+
+protected:
+  /**
+   * @brief Heap entry, the key is stored with the cell so that sifting never looks up the state table
+   */
+  struct Entry
+  {
+    Key key;  // priority of the cell
+    int s;    // index of the cell
+  };
+
+  /**
+   * @brief Move the entry at a heap position towards the root or the leaves until the heap order holds
+   * @param i heap position
+   */
+  void _siftUp(int i);
+  void _siftDown(int i);
+
+protected:
+  GridStateTable& states_;      // state table holding the heap positions
+  std::vector<Entry> entries_;  // heap entries, the children of i are 4i + 1 to 4i + 4
+};
+}  // namespace global_planner
+
+#endif  // INDEXED_HEAP_H
@@ -0,0 +1,120 @@
+/**
+ * *********************************************************
+ *
+ * @file: landmark_heuristic.h
+ * @brief: Contains the ALT (A*, landmarks and triangle inequality) heuristics of a costmap
+ * @author: Yang Haodong
+ * @date: 2024-06-03
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#ifndef LANDMARK_HEURISTIC_H
+#define LANDMARK_HEURISTIC_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "costmap_journal.h"
+
+#define LANDMARK_BLOCK 4  // side of the blocks of cells the landmarks are selected over
+
+namespace global_planner
+{
+/**
+ * @brief ALT heuristics of a costmap. Exact distances from a few landmarks over the passability map bound the
+ *        distance between any two cells by the triangle inequality, d(n, goal) >= |d(l, goal) - d(l, n)|. The
+ *        landmarks are spread by farthest-point selection over blocks of cells, their distance tables are computed
+ *        in parallel and kept as 16-bit fixed point. Tables are built in the background: a plan uses the last ones
+ *        built as long as no cell blocked for them was freed since, which keeps their bounds admissible, and starts
+ *        a rebuild otherwise.
+ */
+class LandmarkHeuristic
+{
+public:
+  /**
+   * @brief Construct a new LandmarkHeuristic object
+   * @param costmap   the environment for path planning
+   * @param landmarks number of landmarks
+   */
+  LandmarkHeuristic(costmap_2d::Costmap2D* costmap, int landmarks);
+
+  /**
+   * @brief Destroy the LandmarkHeuristic object, waiting for a running build
+   */
+  ~LandmarkHeuristic();
+
+  LandmarkHeuristic(const LandmarkHeuristic&) = delete;
+  LandmarkHeuristic& operator=(const LandmarkHeuristic&) = delete;
+
+  /**
+   * @brief Bring the tables up to date with the costmap, starting a rebuild in the background if they no longer hold
+   * @param factor obstacle factor of the planner
+   * @return true if the tables bound the distances on the current costmap
+   */
+  bool update(float factor);
+
+  /**
+   * @brief Set the goal cell of the following estimates
+   * @param goal index of the goal cell
+   */
+  void setGoal(int goal);
+
+  /**
+   * @brief Lower bound of the distance from a cell to the goal
+   * @param cell index of the cell
+   * @return distance in cells, 0 if no landmark reaches both
+   */
+  double estimate(int cell) const;
+
+protected:
+  /**
+   * @brief Distance tables of the landmarks over one snapshot of the passability map
+   */
+  struct Tables
+  {
+    int nx, ny;                            // map size in cells
+    float factor;                          // obstacle factor of the passability
+    std::uint64_t version;                 // journal version of the snapshot
+    std::vector<unsigned char> passable;   // passability the tables were built for
+    std::vector<int> landmarks;            // cells of the landmarks
+    std::vector<double> units;             // distance of one step of the table of each landmark
+    std::vector<std::uint16_t> distances;  // distances in units, one table per landmark, UINT16_MAX if not reached
+  };
+
+  /**
+   * @brief Select the landmarks and compute their distance tables
+   * @param tables tables with the passability filled in
+   */
+  void _build(Tables& tables) const;
+
+  /**
+   * @brief Select landmarks by farthest-point selection over blocks of cells, within the largest component
+   * @param tables tables with the passability filled in, the landmarks are appended
+   */
+  void _selectLandmarks(Tables& tables) const;
+
+protected:
+  costmap_2d::Costmap2D* costmap_;             // costmap followed
+  int landmarks_;                              // number of landmarks
+  std::shared_ptr<CostmapJournal> journal_;    // change journal of the costmap
+  std::shared_ptr<const Tables> tables_;       // tables used by the plans
+  std::uint64_t checked_version_;              // journal version the tables were checked up to
+  bool valid_;                                 // whether no cell blocked for the tables was freed since
+  std::vector<std::uint16_t> goal_distances_;  // distances of the goal in the table of each landmark
+  std::thread builder_;                        // background build of the next tables
+  std::atomic<bool> building_;                 // whether the builder is running
+  std::shared_ptr<const Tables> built_;        // tables finished by the builder and not taken yet
+  std::mutex mutex_;                           // guards built_
+};
+}  // namespace global_planner
+#endif
@@ -0,0 +1,144 @@
+/**
+ * *********************************************************
+ *
+ * @file: pyramid_a_star.h
+ * @brief: Contains the coarse-to-fine A* planner class over a multi-resolution costmap pyramid
+ * @author: Yang Haodong
+ * @date: 2024-05-27
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#ifndef PYRAMID_A_STAR_H
+#define PYRAMID_A_STAR_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "global_planner.h"
+#include "costmap_journal.h"
+#include "grid_state_table.h"
+#include "indexed_heap.h"
+#include "a_star.h"
+
+#define PYRAMID_LEVELS 4   // levels of the pyramid, the cells and their 2x, 4x and 8x coarsenings
+#define DETOUR_RATIO 1.25  // most a coarse path may cost over the bound of its level before the finer one is searched
+
+namespace global_planner
+{
+/**
+ * @brief Class for objects that plan coarse-to-fine using A* over a pyramid of the passability map. Every level
+ *        halves the resolution of the one below and max-pools it: a cell is free only if all of its four children
+ *        are, so a free coarse cell is free all over. The plan is searched on the coarsest level connecting start
+ *        and goal without a detour, as bounded by searching the cells of that level not all blocked. Every finer
+ *        level only searches the cells within a corridor around the path of the level above and a blocked corridor
+ *        falls back to A* over all cells. The pyramid is kept across plans, costmap changes only pool the changed
+ *        cells up again.
+ */
+class PyramidAStar : public GlobalPlanner
+{
+public:
+  /**
+   * @brief Construct a new PyramidAStar object
+   * @param costmap         the environment for path planning
+   * @param levels          levels of the pyramid searched, at most PYRAMID_LEVELS
+   * @param corridor_radius cells of a coarser level around its path which the finer level may search
+   * @param mixed_radius    cells around start and goal which a level searches although partly blocked
+   */
+  PyramidAStar(costmap_2d::Costmap2D* costmap, int levels = PYRAMID_LEVELS, int corridor_radius = 1,
+               int mixed_radius = 1);
+
+  /**
+   * @brief Coarse-to-fine A* implementation
+   * @param start  start node
+   * @param goal   goal node
+   * @param path   path consists of Node
+   * @param expand containing the node been search during the process
+   * @return true if path found, else false
+   */
+  bool plan(const Node& start, const Node& goal, std::vector<Node>& path, std::vector<Node>& expand);
+
+protected:
+  /**
+   * @brief Bring the pyramid up to date with the costmap, rebuilding it or pooling the changed cells up
+   */
+  void _update();
+
+  /**
+   * @brief Build the pyramid of the whole map
+   */
+  void _build();
+
+  /**
+   * @brief Pool a cell from its children on the level below
+   * @param level level of the cell, at least 1
+   * @param i     index of the cell on its level
+   * @return occupancy of the cell
+   */
+  unsigned char _pool(int level, int i) const;
+
+  /**
+   * @brief A* on one level of the pyramid
+   * @param level      level searched
+   * @param start      index of the start cell on the level
+   * @param goal       index of the goal cell on the level
+   * @param corridor   whether to search only the corridor around the path of the level above
+   * @param optimistic whether to search all cells not entirely blocked
+   * @param cells      path of cells on the level from goal to start
+   * @param expand     cells expanded are appended, at their corner on the map
+   * @return true if path found, else false
+   */
+  bool _search(int level, int start, int goal, bool corridor, bool optimistic, std::vector<int>& cells,
+               std::vector<Node>& expand);
+
+  /**
+   * @brief Convert the path of the last search over all cells to nodes
+   * @param cells path of cells from goal to start
+   * @param path  path consists of Node
+   * @return true
+   */
+  bool _extractPath(const std::vector<int>& cells, std::vector<Node>& path);
+
+  /**
+   * @brief Mark the corridor around a path for the search of the level below
+   * @param level level of the path
+   * @param cells path of cells on the level
+   */
+  void _markCorridor(int level, const std::vector<int>& cells);
+
+protected:
+  /**
+   * @brief Occupancy of a cell of the pyramid
+   */
+  enum Occupancy
+  {
+    FREE = 0,     // no child blocked
+    MIXED = 1,    // some children blocked
+    BLOCKED = 2,  // all children blocked
+  };
+
+  int levels_;                                            // levels of the pyramid searched
+  int corridor_radius_;                                   // cells of a coarser level around its path searched finer
+  int mixed_radius_;                                      // cells around start and goal searched though partly blocked
+  int nx_[PYRAMID_LEVELS], ny_[PYRAMID_LEVELS];           // size of each level in cells
+  std::vector<unsigned char> occupancy_[PYRAMID_LEVELS];  // occupancy of the cells of each level, indexed by x + y * nx
+  float built_factor_;                                    // obstacle factor the pyramid was built with
+  bool built_;                                            // whether the pyramid is built
+  std::shared_ptr<CostmapJournal> journal_;               // change journal of the costmap
+  std::uint64_t version_;                                 // journal version the pyramid was built or updated for
+  const unsigned char* map_;                              // costmap snapshot of the journal
+  CostmapJournal::Snapshot snapshot_;                     // held snapshot, not rewritten by other planners
+  std::vector<std::uint32_t> corridor_;                   // stamp of the corridor which covers a cell of a level
+  std::uint32_t corridor_stamp_;                          // stamp of the last corridor
+  GridStateTable states_;                                 // search state of the cells of the level searched
+  IndexedHeap open_list_;                                 // open list keyed on [g + h, g]
+  AStar fallback_;                                        // full search over cells when a corridor is blocked
+};
+}  // namespace global_planner
+#endif
@@ -24,12 +24,6 @@
 
 namespace global_planner
 {
-struct VoronoiData
-{
-  bool is_voronoi;  // whether the grid is in VD or not
-  double dist;      // the distance from the grid to the closest obstacle
-};
-
 /**
  * @brief Class for objects that plan using the Voronoi-based planning algorithm
  */
@@ -42,7 +36,6 @@ public:
    * @param circumscribed_radius  the circumscribed radius of robot
    */
   VoronoiPlanner(costmap_2d::Costmap2D* costmap, double circumscribed_radius);
-  ~VoronoiPlanner();
 
   /**
    * @brief Voronoi-based planning implementation
@@ -53,22 +46,48 @@ public:
    * @return  true if path found, else false
    */
   bool plan(const Node& start, const Node& goal, std::vector<Node>& path, std::vector<Node>& expand);
-  bool plan(const DynamicVoronoi& voronoi, const Node& start, const Node& goal, std::vector<Node>& path);
+
+  /**
+   * @brief Voronoi-based planning implementation, reading the diagram and its skeleton graph in place. The caller
+   *        holds the buffer of the layer owning them for the whole call.
+   * @param voronoi       Voronoi diagram and distance map of the costmap
+   * @param skeleton      skeleton graph of the diagram
+   * @param start         start node
+   * @param goal          goal node
+   * @param path          optimal path consists of Node
+   * @return  true if path found, else false
+   */
+  bool plan(const DynamicVoronoi& voronoi, const costmap_2d::VoronoiSkeleton& skeleton, const Node& start,
+            const Node& goal, std::vector<Node>& path);
 
 protected:
   /**
    * @brief search the shortest path from start to VD, or search the shortest path in VD
+   * @param voronoi       Voronoi diagram and distance map of the costmap
    * @param start         start node
    * @param goal          goal node
    * @param v_goal        the voronoi node in VD which is closest to start node
    * @param path          shortest path from start to VD
    * @return  true if path found, else false
    */
-  bool searchPathWithVoronoi(const Node& start, const Node& goal, std::vector<Node>& path, Node* v_goal = nullptr);
+  bool searchPathWithVoronoi(const DynamicVoronoi& voronoi, const Node& start, const Node& goal,
+                             std::vector<Node>& path, Node* v_goal = nullptr);
+
+  /**
+   * @brief search the shortest path between two cells of VD over the skeleton graph, skipping edges without
+   *        enough clearance
+   * @param voronoi       Voronoi diagram and distance map of the costmap
+   * @param skeleton      skeleton graph of the diagram
+   * @param start         start node in VD
+   * @param goal          goal node in VD
+   * @param path          shortest path in VD, from goal to start
+   * @return  true if path found, else false
+   */
+  bool searchPathInSkeleton(const DynamicVoronoi& voronoi, const costmap_2d::VoronoiSkeleton& skeleton,
+                            const Node& start, const Node& goal, std::vector<Node>& path);
 
 private:
-  VoronoiData** voronoi_diagram_;  // voronoi diagram copy
-  double circumscribed_radius_;    // the circumscribed radius of robot
+  double circumscribed_radius_;  // the circumscribed radius of robot
 };
 
 }  // namespace global_planner
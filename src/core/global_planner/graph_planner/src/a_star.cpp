@@ -20,11 +20,12 @@ namespace global_planner
 {
 /**
  * @brief Construct a new AStar object
- * @param costmap  the environment for path planning
- * @param dijkstra using diksktra implementation
- * @param gbfs     using gbfs implementation
+ * @param costmap   the environment for path planning
+ * @param dijkstra  using diksktra implementation
+ * @param gbfs      using gbfs implementation
+ * @param landmarks number of landmarks of the ALT heuristics, 0 for the Euclidean distance only
  */
-AStar::AStar(costmap_2d::Costmap2D* costmap, bool dijkstra, bool gbfs) : GlobalPlanner(costmap)
+AStar::AStar(costmap_2d::Costmap2D* costmap, bool dijkstra, bool gbfs, int landmarks) : GlobalPlanner(costmap)
 {
   // can not use both dijkstra and GBFS at the same time
   if (!(dijkstra && gbfs))
@@ -37,6 +38,9 @@ AStar::AStar(costmap_2d::Costmap2D* costmap, bool dijkstra, bool gbfs) : GlobalP
     is_dijkstra_ = false;
     is_gbfs_ = false;
   }
+
+  if (landmarks > 0 && !is_dijkstra_)
+    landmarks_ = std::make_unique<LandmarkHeuristic>(costmap, landmarks);
 };
 
 /**
@@ -59,6 +63,11 @@ bool AStar::plan(const Node& start, const Node& goal, std::vector<Node>& path, s
 
   open_list.push(start);
 
+  // the landmark bounds are used while they hold for the costmap, the Euclidean distance bounds the rest
+  const bool is_alt = landmarks_ && landmarks_->update(factor_);
+  if (is_alt)
+    landmarks_->setGoal(grid2Index(goal.x(), goal.y()));
+
   // get all possible motions
   const std::vector<Node> motions = Node::getMotion();
 
@@ -104,7 +113,10 @@ bool AStar::plan(const Node& start, const Node& goal, std::vector<Node>& path, s
 
       // if using dijkstra implementation, do not consider heuristics cost
       if (!is_dijkstra_)
-        node_new.set_h(helper::dist(node_new, goal));
+      {
+        const double h = helper::dist(node_new, goal);
+        node_new.set_h(is_alt ? std::max(h, landmarks_->estimate(node_new.id())) : h);
+      }
 
       // if using GBFS implementation, only consider heuristics cost
       if (is_gbfs_)
@@ -16,18 +16,18 @@
  */
 #include "d_star.h"
 
-#define WINDOW_SIZE 70  // local costmap window size (in grid, 3.5m / 0.05 = 70)
-
 namespace global_planner
 {
 /**
  * @brief Construct a new DStar object
  * @param costmap the environment for path planning
  */
-DStar::DStar(costmap_2d::Costmap2D* costmap) : GlobalPlanner(costmap)
+DStar::DStar(costmap_2d::Costmap2D* costmap) : GlobalPlanner(costmap), open_list_(states_)
 {
-  curr_global_costmap_ = new unsigned char[map_size_];
-  last_global_costmap_ = new unsigned char[map_size_];
+  journal_ = CostmapJournal::instance(costmap);
+  version_ = journal_->version();
+  snapshot_ = journal_->map();
+  curr_global_costmap_ = snapshot_->data();
   goal_.set_x(INF);
   goal_.set_y(INF);
   initMap();
@@ -38,16 +38,7 @@ DStar::DStar(costmap_2d::Costmap2D* costmap) : GlobalPlanner(costmap)
  */
 void DStar::initMap()
 {
-  auto nx = costmap_->getSizeInCellsX();
-  auto ny = costmap_->getSizeInCellsY();
-
-  map_ = new DNodePtr*[nx];
-  for (int i = 0; i < nx; i++)
-  {
-    map_[i] = new DNodePtr[ny];
-    for (int j = 0; j < ny; j++)
-      map_[i][j] = new DNode(i, j, INF, INF, grid2Index(i, j), -1, DNode::NEW, INF);
-  }
+  states_.reset(costmap_->getSizeInCellsX(), costmap_->getSizeInCellsY());
 }
 
 /**
@@ -55,65 +46,56 @@ void DStar::initMap()
  */
 void DStar::reset()
 {
-  auto nx = costmap_->getSizeInCellsX();
-  auto ny = costmap_->getSizeInCellsY();
-
   open_list_.clear();
-
-  for (int i = 0; i < nx; i++)
-    for (int j = 0; j < ny; j++)
-      delete map_[i][j];
-
-  for (int i = 0; i < nx; i++)
-    delete[] map_[i];
-
-  delete[] map_;
-
   initMap();
 }
 
 /**
- * @brief Insert node_ptr into the open_list with h_new
- * @param node_ptr DNode pointer of the DNode to be inserted
- * @param h_new    new h value
+ * @brief Insert a cell into the open_list with h_new
+ * @param s     index of the cell to be inserted
+ * @param h_new new h value
  */
-void DStar::insert(DNodePtr node_ptr, double h_new)
+void DStar::insert(int s, double h_new)
 {
-  if (node_ptr->t_ == DNode::NEW)
-    node_ptr->k_ = h_new;
-  else if (node_ptr->t_ == DNode::OPEN)
-    node_ptr->k_ = std::min(node_ptr->k_, h_new);
-  else if (node_ptr->t_ == DNode::CLOSED)
-    node_ptr->k_ = std::min(node_ptr->g(), h_new);
-
-  node_ptr->set_g(h_new);
-  node_ptr->t_ = DNode::OPEN;
-  open_list_.insert(std::make_pair(node_ptr->k_, node_ptr));
+  unsigned char& t = states_.tag(s);
+  double& k = states_.key(s);
+  if (t == GridStateTable::NEW)
+    k = h_new;
+  else if (t == GridStateTable::OPEN)
+    k = std::min(k, h_new);
+  else if (t == GridStateTable::CLOSED)
+    k = std::min(states_.g(s), h_new);
+
+  // a state is queued once, inserting it again moves it to the new key
+  states_.g(s) = h_new;
+  t = GridStateTable::OPEN;
+  open_list_.push(s, { k, h_new });
 }
 
 /**
  * @brief Check if there is collision between n1 and n2
- * @param n1 DNode pointer of one DNode
- * @param n2 DNode pointer of the other DNode
+ * @param n1 index of one cell
+ * @param n2 index of the other cell
  * @return true if collision, else false
  */
-bool DStar::isCollision(DNodePtr n1, DNodePtr n2)
+bool DStar::isCollision(int n1, int n2)
 {
-  return curr_global_costmap_[n1->id()] > costmap_2d::LETHAL_OBSTACLE * factor_ ||
-         curr_global_costmap_[n2->id()] > costmap_2d::LETHAL_OBSTACLE * factor_;
+  return curr_global_costmap_[n1] > costmap_2d::LETHAL_OBSTACLE * factor_ ||
+         curr_global_costmap_[n2] > costmap_2d::LETHAL_OBSTACLE * factor_;
 }
 
 /**
- * @brief Get neighbour DNodePtrs of node_ptr
- * @param node_ptr   DNode to expand
- * @param neighbours neigbour DNodePtrs in vector
+ * @brief Get neighbour cells of a cell
+ * @param s          index of the cell to expand
+ * @param neighbours neigbour cell indices in vector
  */
-void DStar::getNeighbours(DNodePtr node_ptr, std::vector<DNodePtr>& neighbours)
+void DStar::getNeighbours(int s, std::vector<int>& neighbours)
 {
   auto nx = costmap_->getSizeInCellsX();
   auto ny = costmap_->getSizeInCellsY();
 
-  int x = node_ptr->x(), y = node_ptr->y();
+  int x, y;
+  index2Grid(s, x, y);
   for (int i = -1; i <= 1; i++)
   {
     for (int j = -1; j <= 1; j++)
@@ -125,24 +107,26 @@ void DStar::getNeighbours(DNodePtr node_ptr, std::vector<DNodePtr>& neighbours)
       if (x_n < 0 || x_n >= nx || y_n < 0 || y_n >= ny)
         continue;
 
-      DNodePtr neigbour_ptr = map_[x_n][y_n];
-      neighbours.push_back(neigbour_ptr);
+      neighbours.push_back(grid2Index(x_n, y_n));
     }
   }
 }
 
 /**
  * @brief Get the cost between n1 and n2, return INF if collision
- * @param n1 DNode pointer of one DNode
- * @param n2 DNode pointer of the other DNode
+ * @param n1 index of one cell
+ * @param n2 index of the other cell
  * @return cost between n1 and n2
  */
-double DStar::getCost(DNodePtr n1, DNodePtr n2)
+double DStar::getCost(int n1, int n2)
 {
   if (isCollision(n1, n2))
     return INF;
 
-  return std::hypot(n1->x() - n2->x(), n1->y() - n2->y());
+  int x1, y1, x2, y2;
+  index2Grid(n1, x1, y1);
+  index2Grid(n2, x2, y2);
+  return std::hypot(x1 - x2, y1 - y2);
 }
 
 /**
@@ -154,62 +138,65 @@ double DStar::processState()
   if (open_list_.empty())
     return -1;
 
-  double k_old = open_list_.begin()->first;
-  DNodePtr x = open_list_.begin()->second;
-  open_list_.erase(open_list_.begin());
-  x->t_ = DNode::CLOSED;
-  expand_.push_back(*x);
+  double k_old = open_list_.topKey().k1;
+  int x = open_list_.pop();
+  states_.tag(x) = GridStateTable::CLOSED;
+  expand_.push_back(_getNode(x));
 
-  std::vector<DNodePtr> neigbours;
+  std::vector<int> neigbours;
   getNeighbours(x, neigbours);
 
   // RAISE state, try to reduce k value by neibhbours
-  if (k_old < x->g())
+  if (k_old < states_.g(x))
   {
-    for (DNodePtr y : neigbours)
+    for (int y : neigbours)
     {
-      if (y->t_ != DNode::NEW && y->g() <= k_old && x->g() > y->g() + getCost(y, x))
+      if (states_.tag(y) != GridStateTable::NEW && states_.g(y) <= k_old &&
+          states_.g(x) > states_.g(y) + getCost(y, x))
       {
-        x->set_pid(y->id());
-        x->set_g(y->g() + getCost(y, x));
+        states_.parent(x) = y;
+        states_.g(x) = states_.g(y) + getCost(y, x);
       }
     }
   }
 
   // LOWER state, cost reductions
-  if (k_old == x->g())
+  if (k_old == states_.g(x))
   {
-    for (DNodePtr y : neigbours)
+    for (int y : neigbours)
     {
-      if (y->t_ == DNode::NEW || ((y->pid() == x->id()) && (y->g() != x->g() + getCost(x, y))) ||
-          ((y->pid() != x->id()) && (y->g() > x->g() + getCost(x, y))))
+      if (states_.tag(y) == GridStateTable::NEW ||
+          ((states_.parent(y) == x) && (states_.g(y) != states_.g(x) + getCost(x, y))) ||
+          ((states_.parent(y) != x) && (states_.g(y) > states_.g(x) + getCost(x, y))))
       {
-        y->set_pid(x->id());
-        insert(y, x->g() + getCost(x, y));
+        states_.parent(y) = x;
+        insert(y, states_.g(x) + getCost(x, y));
       }
     }
   }
   else
   {
     // RAISE state
-    for (DNodePtr y : neigbours)
+    for (int y : neigbours)
     {
-      if (y->t_ == DNode::NEW || ((y->pid() == x->id()) && (y->g() != x->g() + getCost(x, y))))
+      if (states_.tag(y) == GridStateTable::NEW ||
+          ((states_.parent(y) == x) && (states_.g(y) != states_.g(x) + getCost(x, y))))
       {
-        y->set_pid(x->id());
-        insert(y, x->g() + getCost(x, y));
+        states_.parent(y) = x;
+        insert(y, states_.g(x) + getCost(x, y));
       }
-      else if (y->pid() != x->id() && (y->g() > x->g() + getCost(x, y)))
+      else if (states_.parent(y) != x && (states_.g(y) > states_.g(x) + getCost(x, y)))
       {
-        insert(x, x->g());
+        insert(x, states_.g(x));
       }
-      else if (y->pid() != x->id() && (x->g() > y->g() + getCost(y, x)) && y->t_ == DNode::CLOSED && (y->g() > k_old))
+      else if (states_.parent(y) != x && (states_.g(x) > states_.g(y) + getCost(y, x)) &&
+               states_.tag(y) == GridStateTable::CLOSED && (states_.g(y) > k_old))
       {
-        insert(y, y->g());
+        insert(y, states_.g(y));
       }
     }
   }
-  return open_list_.begin()->first;
+  return open_list_.empty() ? -1 : open_list_.topKey().k1;
 }
 
 /**
@@ -218,18 +205,9 @@ double DStar::processState()
  */
 void DStar::extractExpand(std::vector<Node>& expand)
 {
-  auto nx = costmap_->getSizeInCellsX();
-  auto ny = costmap_->getSizeInCellsY();
-
-  for (int i = 0; i < nx; i++)
-  {
-    for (int j = 0; j < ny; j++)
-    {
-      DNodePtr node_ptr = map_[i][j];
-      if (node_ptr->t_ == DNode::CLOSED)
-        expand.push_back(*node_ptr);
-    }
-  }
+  for (int i = 0; i < states_.size(); i++)
+    if (states_.touched(i) && states_.tag(i) == GridStateTable::CLOSED)
+      expand.push_back(_getNode(i));
 }
 
 /**
@@ -239,14 +217,12 @@ void DStar::extractExpand(std::vector<Node>& expand)
  */
 void DStar::extractPath(const Node& start, const Node& goal)
 {
-  DNodePtr node_ptr = map_[start.x()][start.y()];
-  while (node_ptr->x() != goal.x() || node_ptr->y() != goal.y())
+  int s = grid2Index(start.x(), start.y());
+  const int g = grid2Index(goal.x(), goal.y());
+  while (s != g)
   {
-    path_.push_back(*node_ptr);
-
-    int x, y;
-    index2Grid(node_ptr->pid(), x, y);
-    node_ptr = map_[x][y];
+    path_.push_back(_getNode(s));
+    s = states_.parent(s);
   }
   std::reverse(path_.begin(), path_.end());
 }
@@ -278,12 +254,12 @@ Node DStar::getState(const Node& current)
 
 /**
  * @brief Modify the map when collision occur between x and y in path, and then do processState()
- * @param x DNode pointer of one DNode
+ * @param x index of the cell
  */
-void DStar::modify(DNodePtr x)
+void DStar::modify(int x)
 {
-  if (x->t_ == DNode::CLOSED)
-    insert(x, x->g());
+  if (states_.tag(x) == GridStateTable::CLOSED)
+    insert(x, states_.g(x));
 }
 
 /**
@@ -295,27 +271,31 @@ void DStar::modify(DNodePtr x)
  */
 bool DStar::plan(const Node& start, const Node& goal, std::vector<Node>& path, std::vector<Node>& expand)
 {
-  // update costmap
-  memcpy(last_global_costmap_, curr_global_costmap_, map_size_);
-  memcpy(curr_global_costmap_, costmap_->getCharMap(), map_size_);
+  // update costmap, changed is every cell changed since the last plan unless the journal lost track of it
+  std::vector<int> changed;
+  const std::uint64_t version = journal_->update();
+  const bool tracked = journal_->changes(version_, changed);
+  version_ = version;
+  snapshot_ = journal_->map();
+  curr_global_costmap_ = snapshot_->data();
 
   expand_.clear();
 
   // new goal set
-  if (goal_.x() != goal.x() || goal_.y() != goal.y())
+  if (!tracked || goal_.x() != goal.x() || goal_.y() != goal.y())
   {
     reset();
     goal_ = goal;
 
-    DNodePtr start_ptr = map_[start.x()][start.y()];
-    DNodePtr goal_ptr = map_[goal.x()][goal.y()];
+    const int start_idx = grid2Index(start.x(), start.y());
+    const int goal_idx = grid2Index(goal.x(), goal.y());
 
-    goal_ptr->set_g(0.0);
-    insert(goal_ptr, 0);
+    states_.g(goal_idx) = 0.0;
+    insert(goal_idx, 0);
     while (1)
     {
       double k_min = processState();
-      if (k_min == -1 || start_ptr->t_ == DNode::CLOSED)
+      if (k_min == -1 || states_.tag(start_idx) == GridStateTable::CLOSED)
         break;
     }
 
@@ -332,38 +312,22 @@ bool DStar::plan(const Node& start, const Node& goal, std::vector<Node>& path, s
     // get current state from path, argmin Euler distance
     Node state = getState(start);
 
-    auto nx = costmap_->getSizeInCellsX();
-    auto ny = costmap_->getSizeInCellsY();
-
     // prepare-repair
-    for (int i = -WINDOW_SIZE / 2; i < WINDOW_SIZE / 2; i++)
+    for (int idx : changed)
     {
-      for (int j = -WINDOW_SIZE / 2; j < WINDOW_SIZE / 2; j++)
-      {
-        int x_n = state.x() + i, y_n = state.y() + j;
-        if (x_n < 0 || x_n >= nx || y_n < 0 || y_n >= ny)
-          continue;
-
-        DNodePtr x = map_[x_n][y_n];
-        std::vector<DNodePtr> neigbours;
-        getNeighbours(x, neigbours);
-
-        int idx = grid2Index(x_n, y_n);
-        if (curr_global_costmap_[idx] != last_global_costmap_[idx])
-        {
-          modify(x);
-          for (DNodePtr y : neigbours)
-            modify(y);
-        }
-      }
+      std::vector<int> neigbours;
+      getNeighbours(idx, neigbours);
+      modify(idx);
+      for (int y : neigbours)
+        modify(y);
     }
 
     // repair-replan
-    DNodePtr x = map_[state.x()][state.y()];
+    const int x = grid2Index(state.x(), state.y());
     while (true)
     {
       double k_min = processState();
-      if (k_min >= x->g() || k_min == -1)
+      if (k_min >= states_.g(x) || k_min == -1)
         break;
     }
 
@@ -376,4 +340,16 @@ bool DStar::plan(const Node& start, const Node& goal, std::vector<Node>& path, s
     return true;
   }
 }
+
+/**
+ * @brief Convert a cell and its search state to Node
+ * @param s index of the cell
+ * @return node of the cell
+ */
+Node DStar::_getNode(int s)
+{
+  int x, y;
+  index2Grid(s, x, y);
+  return Node(x, y, states_.g(s), INF, s, states_.parent(s));
+}
 }  // namespace global_planner
@@ -28,6 +28,8 @@
 #include "lazy_theta_star.h"
 #include "s_theta_star.h"
 #include "hybrid_a_star.h"
+#include "hpa_star.h"
+#include "pyramid_a_star.h"
 
 PLUGINLIB_EXPORT_CLASS(graph_planner::GraphPlanner, nav_core::BaseGlobalPlanner)
 
@@ -75,12 +77,15 @@ void GraphPlanner::initialize(std::string name, costmap_2d::Costmap2DROS* costma
 
     auto costmap = costmap_ros_->getCostmap();
 
+    int landmarks;  // landmarks of the ALT heuristics of a_star and gbfs, 0 for the Euclidean distance only
+    private_nh.param("landmarks", landmarks, 0);
+
     if (planner_name_ == "a_star")
-      g_planner_ = std::make_shared<global_planner::AStar>(costmap);
+      g_planner_ = std::make_shared<global_planner::AStar>(costmap, false, false, landmarks);
     else if (planner_name_ == "dijkstra")
       g_planner_ = std::make_shared<global_planner::AStar>(costmap, true);
     else if (planner_name_ == "gbfs")
-      g_planner_ = std::make_shared<global_planner::AStar>(costmap, false, true);
+      g_planner_ = std::make_shared<global_planner::AStar>(costmap, false, true, landmarks);
     else if (planner_name_ == "jps")
       g_planner_ = std::make_shared<global_planner::JumpPointSearch>(costmap);
     else if (planner_name_ == "d_star")
@@ -100,11 +105,35 @@ void GraphPlanner::initialize(std::string name, costmap_2d::Costmap2DROS* costma
       g_planner_ = std::make_shared<global_planner::SThetaStar>(costmap);
     else if (planner_name_ == "hybrid_a_star")
     {
-      bool is_reverse;  // whether reverse operation is allowed
-      double max_curv;  // maximum curvature of model
+      bool is_reverse;     // whether reverse operation is allowed
+      double max_curv;     // maximum curvature of model
+      bool use_footprint;  // whether to check the robot footprint instead of the inflated centre cell
       private_nh.param("is_reverse", is_reverse, false);
       private_nh.param("max_curv", max_curv, 1.0);
-      g_planner_ = std::make_shared<global_planner::HybridAStar>(costmap, is_reverse, max_curv);
+      private_nh.param("use_footprint", use_footprint, false);
+      auto hybrid_a_star = std::make_shared<global_planner::HybridAStar>(costmap, is_reverse, max_curv);
+      if (use_footprint)
+      {
+        std::vector<std::pair<double, double>> footprint;
+        for (const auto& p : costmap_ros_->getRobotFootprint())
+          footprint.emplace_back(p.x, p.y);
+        hybrid_a_star->setFootprint(footprint);
+      }
+      g_planner_ = hybrid_a_star;
+    }
+    else if (planner_name_ == "hpa_star")
+    {
+      int cluster_size;  // side of the square clusters of the abstract graph in cells
+      private_nh.param("cluster_size", cluster_size, 32);
+      g_planner_ = std::make_shared<global_planner::HPAStar>(costmap, cluster_size);
+    }
+    else if (planner_name_ == "pyramid_a_star")
+    {
+      int pyramid_levels;   // levels of the pyramid searched, the cells and their 2x, 4x and 8x coarsenings
+      int corridor_radius;  // coarse cells around the coarse path searched on the finer level
+      private_nh.param("pyramid_levels", pyramid_levels, PYRAMID_LEVELS);
+      private_nh.param("corridor_radius", corridor_radius, 1);
+      g_planner_ = std::make_shared<global_planner::PyramidAStar>(costmap, pyramid_levels, corridor_radius);
     }
     else
       ROS_ERROR("Unknown planner name: %s", planner_name_.c_str());
@@ -184,24 +213,18 @@ bool GraphPlanner::makePlan(const geometry_msgs::PoseStamped& start, const geome
   if (is_outline_)
     g_planner_->outlineMap();
 
-  // calculate voronoi map
-  bool voronoi_layer_exist = false;
+  // find the voronoi map, its latest completed diagram is read in place
+  boost::shared_ptr<costmap_2d::VoronoiLayer> voronoi_layer;
   if (is_voronoi_map_)
   {
     for (auto layer = costmap_ros_->getLayeredCostmap()->getPlugins()->begin();
          layer != costmap_ros_->getLayeredCostmap()->getPlugins()->end(); ++layer)
     {
-      boost::shared_ptr<costmap_2d::VoronoiLayer> voronoi_layer =
-          boost::dynamic_pointer_cast<costmap_2d::VoronoiLayer>(*layer);
+      voronoi_layer = boost::dynamic_pointer_cast<costmap_2d::VoronoiLayer>(*layer);
       if (voronoi_layer)
-      {
-        voronoi_layer_exist = true;
-        boost::unique_lock<boost::mutex> lock(voronoi_layer->getMutex());
-        voronoi_ = voronoi_layer->getVoronoi();
         break;
-      }
     }
-    if (!voronoi_layer_exist)
+    if (!voronoi_layer)
       ROS_WARN("Failed to get a Voronoi layer for potentional application.");
   }
 
@@ -217,10 +240,18 @@ bool GraphPlanner::makePlan(const geometry_msgs::PoseStamped& start, const geome
   // planning
   if (planner_name_ == "voronoi")
   {
-    if (!voronoi_layer_exist)
+    if (!voronoi_layer)
       ROS_ERROR("Failed to get a Voronoi layer for Voronoi planner.");
-    path_found = std::dynamic_pointer_cast<global_planner::VoronoiPlanner>(g_planner_)
-                     ->plan(voronoi_, start_node, goal_node, path);
+    else
+    {
+      // the buffer is not written by the layer while held
+      const std::shared_ptr<const costmap_2d::VoronoiBuffer> diagram = voronoi_layer->getVoronoiBuffer();
+      if (!diagram)
+        ROS_WARN("The Voronoi diagram is not computed yet.");
+      else
+        path_found = std::dynamic_pointer_cast<global_planner::VoronoiPlanner>(g_planner_)
+                         ->plan(diagram->voronoi, diagram->skeleton, start_node, goal_node, path);
+    }
   }
   else if (planner_name_ == "hybrid_a_star")
   {
@@ -0,0 +1,139 @@
+/**
+ * *********************************************************
+ *
+ * @file: grid_state_table.cpp
+ * @brief: Contains the per-cell state table of the incremental planners
+ * @author: Yang Haodong
+ * @date: 2024-10-09
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#include <algorithm>
+
+#include "nodes.h"
+#include "grid_state_table.h"
+
+namespace global_planner
+{
+/**
+ * @brief Construct a new Grid State Table object
+ */
+GridStateTable::GridStateTable() : size_(0), epoch_(0)
+{
+}
+
+/**
+ * @brief Make every cell untouched. O(1) unless the map size changed.
+ * @param nx map size in cells along x
+ * @param ny map size in cells along y
+ */
+void GridStateTable::reset(unsigned int nx, unsigned int ny)
+{
+  const int size = static_cast<int>(nx * ny);
+  if (size != size_)
+  {
+    // default-initialised arrays, the pages are committed when a search first writes them
+    size_ = size;
+    stamp_.assign(size_, 0);
+    g_.reset(new double[size_]);
+    rhs_.reset(new double[size_]);
+    key_.reset(new double[size_]);
+    parent_.reset(new int[size_]);
+    position_.reset(new int[size_]);
+    tag_.reset(new unsigned char[size_]);
+    epoch_ = 0;
+  }
+
+  // stamps of the previous epochs become stale, a wrap around clears them once
+  if (++epoch_ == 0)
+  {
+    std::fill(stamp_.begin(), stamp_.end(), 0);
+    epoch_ = 1;
+  }
+}
+
+/**
+ * @brief Access the fields of a cell, an untouched cell reads g = rhs = key = INF, no parent, tag NEW and
+ *        no position in the open heap
+ * @param i cell index
+ * @return reference to the field
+ */
+double& GridStateTable::g(int i)
+{
+  _touch(i);
+  return g_[i];
+}
+
+double& GridStateTable::rhs(int i)
+{
+  _touch(i);
+  return rhs_[i];
+}
+
+double& GridStateTable::key(int i)
+{
+  _touch(i);
+  return key_[i];
+}
+
+int& GridStateTable::parent(int i)
+{
+  _touch(i);
+  return parent_[i];
+}
+
+unsigned char& GridStateTable::tag(int i)
+{
+  _touch(i);
+  return tag_[i];
+}
+
+int& GridStateTable::position(int i)
+{
+  _touch(i);
+  return position_[i];
+}
+
+/**
+ * @brief Whether a cell has been touched since the last reset
+ * @param i cell index
+ * @return true if touched, else false
+ */
+bool GridStateTable::touched(int i) const
+{
+  return stamp_[i] == epoch_;
+}
+
+/**
+ * @brief Get the number of cells
+ * @return cells number
+ */
+int GridStateTable::size() const
+{
+  return size_;
+}
+
+/**
+ * @brief Initialise a cell of an older epoch
+ * @param i cell index
+ */
+void GridStateTable::_touch(int i)
+{
+  if (stamp_[i] == epoch_)
+    return;
+
+  stamp_[i] = epoch_;
+  g_[i] = INF;
+  rhs_[i] = INF;
+  key_[i] = INF;
+  parent_[i] = -1;
+  position_[i] = -1;
+  tag_[i] = NEW;
+}
+}  // namespace global_planner
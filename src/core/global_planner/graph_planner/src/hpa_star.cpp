@@ -0,0 +1,608 @@
+/**
+ * *********************************************************
+ *
+ * @file: hpa_star.cpp
+ * @brief: Contains the hierarchical path-finding A* (HPA*) planner class
+ * @author: Yang Haodong
+ * @date: 2024-05-20
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+#include "hpa_star.h"
+
+namespace global_planner
+{
+namespace
+{
+constexpr double kInf = std::numeric_limits<double>::infinity();
+// 8-connected motions, the same as Node::getMotion()
+constexpr int kMotionX[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+constexpr int kMotionY[8] = { 1, 0, -1, 0, 1, -1, 1, -1 };
+constexpr double kMotionCost[8] = { 1.0, 1.0, 1.0, 1.0, M_SQRT2, M_SQRT2, M_SQRT2, M_SQRT2 };
+
+using OpenList = std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>,
+                                     std::greater<std::pair<double, int>>>;
+}  // namespace
+
+/**
+ * @brief Construct a new HPAStar object
+ * @param costmap      the environment for path planning
+ * @param cluster_size side of the square clusters in cells
+ */
+HPAStar::HPAStar(costmap_2d::Costmap2D* costmap, int cluster_size)
+  : GlobalPlanner(costmap)
+  , cluster_size_(std::max(cluster_size, 2))
+  , nx_(0)
+  , ny_(0)
+  , ncx_(0)
+  , ncy_(0)
+  , built_factor_(0.0f)
+  , built_(false)
+  , local_x0_(0)
+  , local_y0_(0)
+  , local_stamp_(0)
+  , abstract_stamp_(0)
+  , fallback_(costmap)
+{
+  journal_ = CostmapJournal::instance(costmap);
+  version_ = journal_->version();
+  snapshot_ = journal_->map();
+  map_ = snapshot_->data();
+
+  const int local_size = cluster_size_ * cluster_size_;
+  local_seen_.assign(local_size, 0);
+  local_g_.assign(local_size, kInf);
+  local_parent_.assign(local_size, -1);
+  local_closed_.assign(local_size, 0);
+  local_target_.assign(local_size, 0);
+}
+
+/**
+ * @brief HPA* implementation
+ * @param start  start node
+ * @param goal   goal node
+ * @param path   path consists of Node
+ * @param expand containing the node been search during the process
+ * @return true if path found, else false
+ */
+bool HPAStar::plan(const Node& start, const Node& goal, std::vector<Node>& path, std::vector<Node>& expand)
+{
+  path.clear();
+  expand.clear();
+
+  _update();
+
+  // A* also leaves a start within obstacles or reaches a goal within them, the abstract graph covers free cells only
+  const int s = start.x() + start.y() * nx_;
+  const int g = goal.x() + goal.y() * nx_;
+  if (!_passable(s) || !_passable(g))
+  {
+    fallback_.setFactor(factor_);
+    return fallback_.plan(start, goal, path, expand);
+  }
+
+  const int sc = _cluster(s), gc = _cluster(g);
+  const int n = static_cast<int>(entrances_.size());
+  const int S = n, G = n + 1;  // vertices of start and goal
+
+  if (abstract_g_.size() < entrances_.size() + 2)
+  {
+    abstract_seen_.resize(entrances_.size() + 2, 0);
+    abstract_g_.resize(entrances_.size() + 2, kInf);
+    abstract_parent_.resize(entrances_.size() + 2, -1);
+    abstract_closed_.resize(entrances_.size() + 2, 0);
+  }
+  if (++abstract_stamp_ == 0)
+  {
+    std::fill(abstract_seen_.begin(), abstract_seen_.end(), 0);
+    std::fill(abstract_closed_.begin(), abstract_closed_.end(), 0);
+    abstract_stamp_ = 1;
+  }
+
+  OpenList open_list;
+  auto relax = [&](int v, double cost, int parent) {
+    if (abstract_seen_[v] != abstract_stamp_ || cost < abstract_g_[v])
+    {
+      abstract_seen_[v] = abstract_stamp_;
+      abstract_g_[v] = cost;
+      abstract_parent_[v] = parent;
+      open_list.emplace(cost + (v == G ? 0.0 : _octile(entrances_[v].cell, g)), v);
+    }
+  };
+
+  // link start and goal to the entrances of their clusters
+  abstract_seen_[S] = abstract_stamp_;
+  abstract_g_[S] = 0.0;
+  abstract_parent_[S] = -1;
+  std::vector<int> targets;
+  for (int e : cluster_entrances_[sc])
+    targets.push_back(entrances_[e].cell);
+  if (sc == gc)
+    targets.push_back(g);
+  _searchCluster(sc, s, targets, &expand);
+  for (int e : cluster_entrances_[sc])
+  {
+    const double cost = _clusterCost(entrances_[e].cell);
+    if (cost < kInf)
+      relax(e, cost, S);
+  }
+  if (sc == gc && _clusterCost(g) < kInf)
+    relax(G, _clusterCost(g), S);
+
+  goal_arcs_.clear();
+  targets.clear();
+  for (int e : cluster_entrances_[gc])
+    targets.push_back(entrances_[e].cell);
+  _searchCluster(gc, g, targets, &expand);
+  for (int e : cluster_entrances_[gc])
+  {
+    const double cost = _clusterCost(entrances_[e].cell);
+    if (cost < kInf)
+      goal_arcs_.emplace_back(e, cost);
+  }
+
+  // search the abstract graph
+  bool found = false;
+  while (!open_list.empty())
+  {
+    const int u = open_list.top().second;
+    open_list.pop();
+    if (abstract_closed_[u] == abstract_stamp_)
+      continue;
+    abstract_closed_[u] = abstract_stamp_;
+
+    if (u == G)
+    {
+      found = true;
+      break;
+    }
+
+    const Entrance& entrance = entrances_[u];
+    int ux, uy;
+    index2Grid(entrance.cell, ux, uy);
+    expand.emplace_back(ux, uy, abstract_g_[u], 0.0, entrance.cell, entrance.cell);
+
+    const double gu = abstract_g_[u];
+    relax(entrance.partner, gu + _octile(entrance.cell, entrances_[entrance.partner].cell), u);
+    for (const auto& arc : entrance.arcs)
+      relax(arc.first, gu + arc.second, u);
+    if (entrance.cluster == gc)
+      for (const auto& arc : goal_arcs_)
+        if (arc.first == u)
+          relax(G, gu + arc.second, u);
+  }
+
+  // every step between two clusters is covered by an entrance, so the goal is unreachable over cells as well
+  if (!found)
+    return false;
+
+  // refine every abstract edge by a search within its cluster, from the goal back to the start
+  std::vector<int> cells{ g };
+  for (int v = G; v != S; v = abstract_parent_[v])
+  {
+    const int u = abstract_parent_[v];
+    const int u_cell = u == S ? s : entrances_[u].cell;
+    const int v_cell = v == G ? g : entrances_[v].cell;
+    if (u_cell == v_cell)
+      continue;
+
+    if (u != S && entrances_[u].partner == v)
+    {
+      cells.push_back(u_cell);
+      continue;
+    }
+
+    const int cluster = u == S ? sc : entrances_[u].cluster;
+    _searchCluster(cluster, u_cell, { v_cell }, &expand);
+    for (int l = local_parent_[(v_cell % nx_ - local_x0_) + (v_cell / nx_ - local_y0_) * cluster_size_]; l >= 0;)
+    {
+      const int x = local_x0_ + l % cluster_size_, y = local_y0_ + l / cluster_size_;
+      cells.push_back(x + y * nx_);
+      l = local_parent_[l];
+    }
+  }
+
+  // cells run from goal to start, the order of the other planners
+  double cost = 0.0;
+  for (int i = static_cast<int>(cells.size()) - 1; i >= 0; i--)
+  {
+    int x, y;
+    index2Grid(cells[i], x, y);
+    if (i + 1 < static_cast<int>(cells.size()))
+      cost += _octile(cells[i], cells[i + 1]);
+    path.emplace_back(x, y, cost, 0.0, cells[i], i + 1 < static_cast<int>(cells.size()) ? cells[i + 1] : cells[i]);
+  }
+  std::reverse(path.begin(), path.end());
+
+  return true;
+}
+
+/**
+ * @brief Bring the abstraction up to date with the costmap, rebuilding it or repairing the changed clusters
+ */
+void HPAStar::_update()
+{
+  std::vector<int> changed;
+  const std::uint64_t version = journal_->update();
+  const bool tracked = journal_->changes(version_, changed);
+  version_ = version;
+  snapshot_ = journal_->map();
+  map_ = snapshot_->data();
+
+  if (!built_ || !tracked || built_factor_ != factor_)
+  {
+    _build();
+    return;
+  }
+
+  // a cell changes the costs within its cluster, and the entrances of the borders and corners it lies on. Those
+  // of a cluster are placed by its own borders and by the east borders of the clusters west, south and south west
+  std::vector<int> clusters, borders;
+  const int cs = cluster_size_;
+  for (int cell : changed)
+  {
+    const unsigned char passable = map_[cell] < costmap_2d::LETHAL_OBSTACLE * factor_;
+    if (passable == passable_[cell])
+      continue;
+    passable_[cell] = passable;
+
+    const int x = cell % nx_, y = cell / nx_;
+    const int c = _cluster(cell);
+    clusters.push_back(c);
+
+    const bool west = x % cs == 0 && x > 0, south = y % cs == 0 && y > 0;
+    if (!west && !south && x % cs != cs - 1 && y % cs != cs - 1)
+      continue;
+    for (int k = 0; k < 2; k++)
+    {
+      borders.push_back(c * 2 + k);
+      if (west)
+        borders.push_back((c - 1) * 2 + k);
+      if (south)
+        borders.push_back((c - ncx_) * 2 + k);
+      if (west && south)
+        borders.push_back((c - ncx_ - 1) * 2 + k);
+    }
+  }
+
+  // entrances of a border lie within the clusters on both sides of it and, for an east border, across its corner
+  std::sort(borders.begin(), borders.end());
+  borders.erase(std::unique(borders.begin(), borders.end()), borders.end());
+  const int num = ncx_ * ncy_;
+  for (int border : borders)
+  {
+    _buildBorder(border);
+    const int c = border / 2;
+    for (int neighbor : { c, c + 1, c + ncx_, c + ncx_ + 1 })
+      if (neighbor < num)
+        clusters.push_back(neighbor);
+  }
+
+  std::sort(clusters.begin(), clusters.end());
+  clusters.erase(std::unique(clusters.begin(), clusters.end()), clusters.end());
+  for (int cluster : clusters)
+    _connectCluster(cluster);
+}
+
+/**
+ * @brief Build the abstraction of the whole map
+ */
+void HPAStar::_build()
+{
+  nx_ = static_cast<int>(costmap_->getSizeInCellsX());
+  ny_ = static_cast<int>(costmap_->getSizeInCellsY());
+  ncx_ = (nx_ + cluster_size_ - 1) / cluster_size_;
+  ncy_ = (ny_ + cluster_size_ - 1) / cluster_size_;
+
+  passable_.resize(nx_ * ny_);
+  for (int i = 0; i < nx_ * ny_; i++)
+    passable_[i] = map_[i] < costmap_2d::LETHAL_OBSTACLE * factor_;
+
+  entrances_.clear();
+  free_entrances_.clear();
+  cluster_entrances_.assign(ncx_ * ncy_, std::vector<int>());
+  border_entrances_.assign(ncx_ * ncy_ * 2, std::vector<int>());
+
+  for (int border = 0; border < ncx_ * ncy_ * 2; border++)
+    _buildBorder(border);
+  for (int cluster = 0; cluster < ncx_ * ncy_; cluster++)
+    _connectCluster(cluster);
+
+  built_ = true;
+  built_factor_ = factor_;
+}
+
+/**
+ * @brief Remove and place again the entrances of the straight and diagonal passages across a border
+ * @param border border index, cluster * 2 for its east border and cluster * 2 + 1 for its north border
+ */
+void HPAStar::_buildBorder(int border)
+{
+  for (int e : border_entrances_[border])
+  {
+    auto& entrances = cluster_entrances_[entrances_[e].cluster];
+    entrances.erase(std::find(entrances.begin(), entrances.end(), e));
+    entrances_[e].partner = -1;
+    entrances_[e].arcs.clear();
+    free_entrances_.push_back(e);
+  }
+  border_entrances_[border].clear();
+
+  const int c = border / 2, cx = c % ncx_, cy = c / ncx_;
+  const bool east = border % 2 == 0;
+  if (east ? cx + 1 >= ncx_ : cy + 1 >= ncy_)
+    return;
+
+  // the last row or column of the cluster and the first one of its neighbour
+  int first, step, across, length;
+  if (east)
+  {
+    first = (cx + 1) * cluster_size_ - 1 + cy * cluster_size_ * nx_;
+    step = nx_;
+    across = 1;
+    length = std::min(cluster_size_, ny_ - cy * cluster_size_);
+  }
+  else
+  {
+    first = cx * cluster_size_ + ((cy + 1) * cluster_size_ - 1) * nx_;
+    step = 1;
+    across = nx_;
+    length = std::min(cluster_size_, nx_ - cx * cluster_size_);
+  }
+
+  // a narrow run of cells free on both sides gets one entrance in its middle, a wide one one at each end
+  int run = -1;
+  for (int i = 0; i <= length; i++)
+  {
+    const int cell = first + i * step;
+    const bool open = i < length && passable_[cell] && passable_[cell + across];
+    if (open && run < 0)
+      run = i;
+    else if (!open && run >= 0)
+    {
+      if (i - run < ENTRANCE_WIDTH)
+      {
+        const int mid = first + (run + i - 1) / 2 * step;
+        _addEntrances(border, mid, mid + across);
+      }
+      else
+      {
+        _addEntrances(border, first + run * step, first + run * step + across);
+        _addEntrances(border, first + (i - 1) * step, first + (i - 1) * step + across);
+      }
+      run = -1;
+    }
+  }
+
+  // a diagonal step across the border is only a passage of its own if both cells beside it are blocked
+  for (int i = 0; i < length; i++)
+  {
+    const int cell = first + i * step;
+    if (!passable_[cell] || passable_[cell + across])
+      continue;
+    if (i > 0 && passable_[cell - step + across] && !passable_[cell - step])
+      _addEntrances(border, cell, cell - step + across);
+    if (i + 1 < length && passable_[cell + step + across] && !passable_[cell + step])
+      _addEntrances(border, cell, cell + step + across);
+  }
+
+  // the same for the diagonal steps across the north east corner of the cluster, kept with its east border
+  if (east && cy + 1 < ncy_)
+  {
+    const int corner = first + (length - 1) * step;  // north east cell of the cluster
+    if (passable_[corner] && passable_[corner + 1 + nx_] && !passable_[corner + 1] && !passable_[corner + nx_])
+      _addEntrances(border, corner, corner + 1 + nx_);
+    if (passable_[corner + 1] && passable_[corner + nx_] && !passable_[corner] && !passable_[corner + 1 + nx_])
+      _addEntrances(border, corner + nx_, corner + 1);
+  }
+}
+
+/**
+ * @brief Add a pair of entrances facing each other across a border
+ * @param border border index
+ * @param c1     cell on the side of the cluster owning the border
+ * @param c2     cell on the other side
+ */
+void HPAStar::_addEntrances(int border, int c1, int c2)
+{
+  int ids[2];
+  for (int& id : ids)
+  {
+    if (free_entrances_.empty())
+    {
+      id = static_cast<int>(entrances_.size());
+      entrances_.emplace_back();
+    }
+    else
+    {
+      id = free_entrances_.back();
+      free_entrances_.pop_back();
+    }
+  }
+
+  const int cells[2] = { c1, c2 };
+  for (int k = 0; k < 2; k++)
+  {
+    Entrance& entrance = entrances_[ids[k]];
+    entrance.cell = cells[k];
+    entrance.cluster = _cluster(cells[k]);
+    entrance.partner = ids[1 - k];
+    entrance.arcs.clear();
+    cluster_entrances_[entrance.cluster].push_back(ids[k]);
+    border_entrances_[border].push_back(ids[k]);
+  }
+}
+
+/**
+ * @brief Compute the costs between the entrances of a cluster
+ * @param cluster cluster index
+ */
+void HPAStar::_connectCluster(int cluster)
+{
+  const std::vector<int>& entrances = cluster_entrances_[cluster];
+  for (int e : entrances)
+    entrances_[e].arcs.clear();
+
+  // costs are symmetric, each search only needs those to the entrances after its own
+  std::vector<int> targets;
+  for (size_t i = 0; i + 1 < entrances.size(); i++)
+  {
+    targets.clear();
+    for (size_t j = i + 1; j < entrances.size(); j++)
+      targets.push_back(entrances_[entrances[j]].cell);
+    _searchCluster(cluster, entrances_[entrances[i]].cell, targets, nullptr);
+
+    for (size_t j = i + 1; j < entrances.size(); j++)
+    {
+      const double cost = _clusterCost(entrances_[entrances[j]].cell);
+      if (cost < kInf)
+      {
+        entrances_[entrances[i]].arcs.emplace_back(entrances[j], cost);
+        entrances_[entrances[j]].arcs.emplace_back(entrances[i], cost);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Search within a cluster from a cell until all targets are expanded, A* towards a single target and
+ *        Dijkstra towards several
+ * @param cluster cluster index
+ * @param from    index of the start cell
+ * @param targets indices of the target cells within the cluster
+ * @param expand  cells expanded are appended unless nullptr
+ */
+void HPAStar::_searchCluster(int cluster, int from, const std::vector<int>& targets, std::vector<Node>* expand)
+{
+  local_x0_ = cluster % ncx_ * cluster_size_;
+  local_y0_ = cluster / ncx_ * cluster_size_;
+  const int x1 = std::min(local_x0_ + cluster_size_, nx_);
+  const int y1 = std::min(local_y0_ + cluster_size_, ny_);
+
+  if (++local_stamp_ == 0)
+  {
+    std::fill(local_seen_.begin(), local_seen_.end(), 0);
+    std::fill(local_closed_.begin(), local_closed_.end(), 0);
+    std::fill(local_target_.begin(), local_target_.end(), 0);
+    local_stamp_ = 1;
+  }
+
+  int remaining = 0;
+  for (int target : targets)
+  {
+    const int l = (target % nx_ - local_x0_) + (target / nx_ - local_y0_) * cluster_size_;
+    if (local_target_[l] != local_stamp_)
+    {
+      local_target_[l] = local_stamp_;
+      remaining++;
+    }
+  }
+  const int to = targets.size() == 1 ? targets.front() : -1;  // target of the heuristics
+
+  const int l0 = (from % nx_ - local_x0_) + (from / nx_ - local_y0_) * cluster_size_;
+  local_seen_[l0] = local_stamp_;
+  local_g_[l0] = 0.0;
+  local_parent_[l0] = -1;
+  local_open_.clear();
+  local_open_.emplace_back(to < 0 ? 0.0 : _octile(from, to), l0);
+
+  const std::greater<std::pair<double, int>> greater;
+  while (!local_open_.empty() && remaining > 0)
+  {
+    std::pop_heap(local_open_.begin(), local_open_.end(), greater);
+    const int l = local_open_.back().second;
+    local_open_.pop_back();
+    if (local_closed_[l] == local_stamp_)
+      continue;
+    local_closed_[l] = local_stamp_;
+    if (local_target_[l] == local_stamp_)
+      remaining--;
+
+    const int x = local_x0_ + l % cluster_size_, y = local_y0_ + l / cluster_size_;
+    if (expand)
+    {
+      const int parent = local_parent_[l];
+      expand->emplace_back(x, y, local_g_[l], 0.0, x + y * nx_,
+                           parent < 0 ? x + y * nx_ :
+                                        local_x0_ + parent % cluster_size_ +
+                                            (local_y0_ + parent / cluster_size_) * nx_);
+    }
+
+    for (int k = 0; k < 8; k++)
+    {
+      const int xn = x + kMotionX[k], yn = y + kMotionY[k];
+      if (xn < local_x0_ || xn >= x1 || yn < local_y0_ || yn >= y1 || !passable_[xn + yn * nx_])
+        continue;
+
+      const int ln = l + kMotionX[k] + kMotionY[k] * cluster_size_;
+      if (local_closed_[ln] == local_stamp_)
+        continue;
+
+      const double g = local_g_[l] + kMotionCost[k];
+      if (local_seen_[ln] != local_stamp_ || g < local_g_[ln])
+      {
+        local_seen_[ln] = local_stamp_;
+        local_g_[ln] = g;
+        local_parent_[ln] = l;
+        local_open_.emplace_back(to < 0 ? g : g + _octile(xn + yn * nx_, to), ln);
+        std::push_heap(local_open_.begin(), local_open_.end(), greater);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Get the cost found by the last cluster search to a cell of that cluster
+ * @param cell index of the cell
+ * @return cost, infinity if not reached
+ */
+double HPAStar::_clusterCost(int cell) const
+{
+  const int l = (cell % nx_ - local_x0_) + (cell / nx_ - local_y0_) * cluster_size_;
+  return local_closed_[l] == local_stamp_ ? local_g_[l] : kInf;
+}
+
+/**
+ * @brief Get the cluster of a cell
+ * @param cell index of the cell
+ * @return cluster index
+ */
+int HPAStar::_cluster(int cell) const
+{
+  return cell % nx_ / cluster_size_ + cell / nx_ / cluster_size_ * ncx_;
+}
+
+/**
+ * @brief Whether a cell can be entered
+ * @param cell index of the cell
+ * @return true if the cell is not an obstacle
+ */
+bool HPAStar::_passable(int cell) const
+{
+  return cell >= 0 && cell < nx_ * ny_ && passable_[cell];
+}
+
+/**
+ * @brief Octile distance between two cells, a consistent heuristics of the 8-connected grid
+ * @param c1 index of one cell
+ * @param c2 index of the other cell
+ * @return distance in cells
+ */
+double HPAStar::_octile(int c1, int c2) const
+{
+  const int dx = std::abs(c1 % nx_ - c2 % nx_), dy = std::abs(c1 / nx_ - c2 / nx_);
+  return std::max(dx, dy) + (M_SQRT2 - 1.0) * std::min(dx, dy);
+}
+}  // namespace global_planner
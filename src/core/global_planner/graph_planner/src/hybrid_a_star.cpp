@@ -14,11 +14,17 @@
  *
  * ********************************************************
  */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <queue>
 #include <unordered_set>
 
 #include "hybrid_a_star.h"
+#include "thread_pool.h"
 
 namespace global_planner
 {
@@ -106,27 +112,28 @@ bool HybridAStar::HybridNode::operator!=(const HybridNode& n) const
 }
 
 /**
- * @brief Get permissible motion
+ * @brief Get permissible motion, built once
  * @return Node vector of permissible motions
  */
-std::vector<HybridAStar::HybridNode> HybridAStar::HybridNode::getMotion()
+const std::vector<HybridAStar::HybridNode>& HybridAStar::HybridNode::getMotion()
 {
-  // double R = 1.0;
-  double R = 1.3;
-
-  // // 20 deg 0.349065 rad
-  double alpha = 14 * M_PI / 180;
-
-  // R, alpha
-  double dy[] = { 0, -R * (1 - cos(alpha)), R * (1 - cos(alpha)) };
-  double dx[] = { alpha * R, R * sin(alpha), R * sin(alpha) };
-  double dt[] = { 0, alpha, -alpha };
-
-  return {
-    HybridNode(dx[0], dy[0], dt[0], 0, 0, 0, 0, 0),   HybridNode(dx[1], dy[1], dt[1], 0, 0, 0, 0, 1),
-    HybridNode(dx[2], dy[2], dt[2], 0, 0, 0, 0, 2),   HybridNode(-dx[0], dy[0], -dt[0], 0, 0, 0, 0, 3),
-    HybridNode(-dx[1], dy[1], -dt[1], 0, 0, 0, 0, 4), HybridNode(-dx[2], dy[2], -dt[2], 0, 0, 0, 0, 5),
-  };
+  static const std::vector<HybridNode> motions = [] {
+    // arcs of radius R turning by alpha, a whole number of headings so that successors stay on the discrete headings
+    double R = MOTION_RADIUS;
+    double alpha = MOTION_HEADINGS * DELTA_HEADING;
+
+    // R, alpha, left turns have positive dy and dt
+    double dy[] = { 0, R * (1 - cos(alpha)), -R * (1 - cos(alpha)) };
+    double dx[] = { alpha * R, R * sin(alpha), R * sin(alpha) };
+    double dt[] = { 0, alpha, -alpha };
+
+    return std::vector<HybridNode>{
+      HybridNode(dx[0], dy[0], dt[0], 0, 0, 0, 0, 0),   HybridNode(dx[1], dy[1], dt[1], 0, 0, 0, 0, 1),
+      HybridNode(dx[2], dy[2], dt[2], 0, 0, 0, 0, 2),   HybridNode(-dx[0], dy[0], -dt[0], 0, 0, 0, 0, 3),
+      HybridNode(-dx[1], dy[1], -dt[1], 0, 0, 0, 0, 4), HybridNode(-dx[2], dy[2], -dt[2], 0, 0, 0, 0, 5),
+    };
+  }();
+  return motions;
 }
 
 /**
@@ -136,12 +143,21 @@ std::vector<HybridAStar::HybridNode> HybridAStar::HybridNode::getMotion()
  * @param max_curv   maximum curvature of model
  */
 HybridAStar::HybridAStar(costmap_2d::Costmap2D* costmap, bool is_reverse, double max_curv)
-  : GlobalPlanner(costmap), is_reverse_(is_reverse), max_curv_(max_curv)
+  : GlobalPlanner(costmap)
+  , h_map_hash_(0)
+  , is_reverse_(is_reverse)
+  , max_curv_(max_curv)
+  , shot_failures_(SHOT_CACHE, ShotFailure{ 0, 0, 0.0f })
+  , shot_plan_(0)
+  , states_(HEADINGS)
+  , sweep_res_(0.0)
+  , footprint_checker_(HEADINGS)
+  , footprint_hash_(0)
 {
-  dubins_gen_.setStep(1.5);
-  dubins_gen_.setMaxCurv(max_curv_);
   goal_ = HybridNode();
   a_star_planner_ = std::make_shared<AStar>(costmap);
+  _buildPrimitives();
+  _buildHeuristicTable();
 }
 
 /**
@@ -165,78 +181,172 @@ bool HybridAStar::plan(HybridNode& start, HybridNode& goal, std::vector<Node>& p
   updateIndex(start);
   updateIndex(goal);
 
-  // update heuristic map
-  if (goal_ != goal)
+  // update heuristic map, it follows the obstacles so a costmap update invalidates it as well
+  const std::uint64_t map_hash = _hashCostmap();
+  const bool goal_changed = goal_ != goal;
+  goal_ = goal;
+  if (goal_changed || (map_hash != h_map_hash_))
   {
-    goal_ = goal;
+    h_map_hash_ = map_hash;
     unsigned int gx, gy;
     world2Map(goal.x_, goal.y_, gx, gy);
     Node h_start(gx, gy, 0, 0, grid2Index(gx, gy), 0);
     genHeurisiticMap(h_start);
   }
 
-  // possible directions and motions
+  // possible directions, the primitive sweeps and the footprint masks follow the costmap resolution
   int dir = is_reverse_ ? 6 : 3;
-  const std::vector<HybridNode> motions = HybridNode::getMotion();
+  if (costmap_->getResolution() != sweep_res_)
+  {
+    _buildPrimitives();
+    if (footprint_checker_.valid())
+    {
+      footprint_checker_.setFootprint(footprint_, costmap_->getResolution());
+      footprint_hash_ = 0;
+    }
+  }
 
-  // open list and closed list
-  std::priority_queue<HybridNode, std::vector<HybridNode>, HybridNode::compare_cost> open_list;
-  std::unordered_map<int, HybridNode> closed_list;
+  // the footprint only collides with obstacles, the inflation is left to the heuristic and the path costs
+  if (footprint_checker_.valid() && (footprint_hash_ != map_hash))
+  {
+    footprint_hash_ = map_hash;
+    footprint_checker_.update(costmap_->getCharMap(), costmap_->getSizeInCellsX(), costmap_->getSizeInCellsY(),
+                              costmap_2d::LETHAL_OBSTACLE);
+  }
+  const unsigned char* charmap = costmap_->getCharMap();
+  const double obstacle = _obstacleCost();
+  const double nx = costmap_->getSizeInCellsX(), ny = costmap_->getSizeInCellsY();
+
+  // the state table and the open list keep their memory between plans, one lattice cell per straight motion
+  const double step = HybridNode::getMotion()[0].x_ / costmap_->getResolution();
+  states_.reset(costmap_->getSizeInCellsX(), costmap_->getSizeInCellsY(), static_cast<unsigned int>(step));
+  open_list_.clear();
+
+  // the samples of a sweep are evenly spaced along the arc, the footprint is checked every few of them
+  const int sweep_samples = primitives_[0].sweep_end - primitives_[0].sweep_begin;
+  const int footprint_stride =
+      std::max(1, static_cast<int>(footprint_checker_.spacing() * sweep_samples / std::max(step, 1.0)));
+
+  // failed shots are remembered within a plan only, a wrap around clears them once
+  if (++shot_plan_ == 0)
+  {
+    std::fill(shot_failures_.begin(), shot_failures_.end(), ShotFailure{ 0, 0, 0.0f });
+    shot_plan_ = 1;
+  }
+  int shot_countdown = 0;
+  std::vector<Node> path_shot;
 
-  open_list.push(start);
+  unsigned int mx, my;
+  if (world2Map(start.x_, start.y_, mx, my))
+  {
+    // the search runs on the discrete headings, start from the nearest one
+    const int heading = states_.heading(start.t_ + 0.5 * DELTA_HEADING);
+    updateHeuristic(start);
+    int slot = states_.push(
+        { start.x_, start.y_, heading * DELTA_HEADING, start.g(), start.h(), -1, start.prim_, heading, false });
+    states_.slot(mx, my, heading) = slot;
+    open_list_.push_back({ start.g() + start.h(), start.h(), slot });
+  }
 
   // main process
-  while (!open_list.empty())
+  while (!open_list_.empty())
   {
     // pop current node from open list
-    HybridNode current = open_list.top();
-    open_list.pop();
+    std::pop_heap(open_list_.begin(), open_list_.end(), compare_open());
+    const int cur_slot = open_list_.back().slot;
+    open_list_.pop_back();
 
-    // current node does not exist in closed list
-    if (closed_list.find(current.id()) != closed_list.end())
+    // a state is expanded once with its best cost, later entries of it are outdated
+    if (states_[cur_slot].closed)
       continue;
+    states_[cur_slot].closed = true;
 
-    closed_list.insert(std::make_pair(current.id(), current));
-    expand.emplace_back(current.x_, current.y_, 0, 0, _worldToIndex(current.x_, current.y_));
+    const HybridStateTable::State& cur = states_[cur_slot];
+    const int cur_heading = cur.heading;
+    HybridNode current(cur.x, cur.y, cur.t, cur.g, cur.h, 0, 0, cur.prim);
+    const int cur_index = _worldToIndex(current.x_, current.y_);
+    expand.emplace_back(current.x_, current.y_, 0, 0, cur_index);
 
-    // goal shot
-    std::vector<Node> path_dubins;
-    if (std::hypot(current.x_ - goal.x_, current.y_ - goal.y_) < 50)
+    // current position in cells, the sweeps are added to it
+    const double cur_u = (current.x_ - costmap_->getOriginX()) / sweep_res_;
+    const double cur_v = (current.y_ - costmap_->getOriginY()) / sweep_res_;
+
+    // goal shot, one every few expansions far from the goal and one every expansion close to it
+    if ((--shot_countdown <= 0) && (current.h() < SHOT_RANGE))
     {
-      if (dubinsShot(current, goal, path_dubins))
+      shot_countdown = std::max(1, static_cast<int>(current.h() / SHOT_SPACING));
+      if (analyticShot(current, goal, path_shot))
       {
-        path = _convertClosedListToPath(closed_list, start, current);
+        path = _convertStatesToPath(cur_slot);
         std::reverse(path.begin(), path.end());
-        path.insert(path.end(), path_dubins.begin(), path_dubins.end());
+        path.insert(path.end(), path_shot.begin(), path_shot.end());
         std::reverse(path.begin(), path.end());
         return true;
       }
     }
 
     // explore neighbor of current node
-    for (size_t i = 0; i < dir; i++)
+    for (int i = 0; i < dir; i++)
     {
       // explore a new node
-      HybridNode node_new = current + motions[i];
-      updateIndex(node_new);
+      const Primitive& motion = primitives_[cur_heading * MOTIONS + i];
+      const double x = current.x_ + motion.dx, y = current.y_ + motion.dy;
+
+      // next node hit the boundary
+      if (!world2Map(x, y, mx, my))
+        continue;
 
       // node_new in closed list
-      if (closed_list.find(node_new.id()) != closed_list.end())
+      int& slot = states_.slot(mx, my, motion.heading);
+      if ((slot >= 0) && states_[slot].closed)
         continue;
 
-      // next node hit the boundary or obstacle
+      // every cell swept by the arc must be inside the map and free
       // prevent planning failed when the current within inflation
-      if ((_worldToIndex(node_new.x_, node_new.y_) < 0) || (_worldToIndex(node_new.x_, node_new.y_) >= map_size_) ||
-          (node_new.t_ / DELTA_HEADING >= HEADINGS) ||
-          (costmap_->getCharMap()[_worldToIndex(node_new.x_, node_new.y_)] >= costmap_2d::LETHAL_OBSTACLE * factor_ &&
-           costmap_->getCharMap()[_worldToIndex(node_new.x_, node_new.y_)] >=
-               costmap_->getCharMap()[_worldToIndex(current.x_, current.y_)]))
+      bool collision = false;
+      for (int k = motion.sweep_begin, last = cur_index; !collision && (k < motion.sweep_end); k++)
+      {
+        const double u = cur_u + sweep_[k].first, v = cur_v + sweep_[k].second;
+        if ((u < 0) || (v < 0) || (u >= nx) || (v >= ny))
+          collision = true;
+        else if (grid2Index(static_cast<int>(u), static_cast<int>(v)) != last)
+        {
+          last = grid2Index(static_cast<int>(u), static_cast<int>(v));
+          collision = charmap[last] >= obstacle && charmap[last] >= charmap[cur_index];
+        }
+      }
+
+      // the footprint every half inscribed radius along the arc and at its end, turning evenly along it
+      if (!collision && footprint_checker_.valid())
+      {
+        const double turn = helper::pi2pi(motion.heading * DELTA_HEADING - current.t_);
+        for (int j = footprint_stride; !collision && (j < sweep_samples + footprint_stride); j += footprint_stride)
+        {
+          const int k = std::min(j, sweep_samples);
+          const auto& p = sweep_[motion.sweep_begin + k - 1];
+          collision = footprint_checker_.collides(cur_u + p.first, cur_v + p.second,
+                                                  current.t_ + turn * k / sweep_samples);
+        }
+      }
+      if (collision)
+        continue;
+
+      // node_new in open list with a lower cost
+      HybridNode node_new(x, y, motion.heading * DELTA_HEADING, current.g() + motion_cost_[current.prim_][i], 0, 0, 0,
+                          i);
+      if ((slot >= 0) && (states_[slot].g <= node_new.g()))
         continue;
 
-      node_new.set_pid(current.id());
       updateHeuristic(node_new);
+      HybridStateTable::State state{ node_new.x_, node_new.y_,    node_new.t_,    node_new.g(), node_new.h(),
+                                     cur_slot,    node_new.prim_, motion.heading, false };
+      if (slot >= 0)
+        states_[slot] = state;
+      else
+        slot = states_.push(state);
 
-      open_list.push(node_new);
+      open_list_.push_back({ node_new.g() + node_new.h(), node_new.h(), slot });
+      std::push_heap(open_list_.begin(), open_list_.end(), compare_open());
     }
   }
 
@@ -249,34 +359,108 @@ bool HybridAStar::plan(HybridNode& start, HybridNode& goal, std::vector<Node>& p
 }
 
 /**
- * @brief Try using Dubins curves to connect the start and goal
+ * @brief Check collisions with the robot footprint instead of the centre cell against the inflated costmap
+ * @param footprint footprint vertices in the robot frame in meters, empty to check the centre cell only
+ */
+void HybridAStar::setFootprint(const std::vector<std::pair<double, double>>& footprint)
+{
+  footprint_ = footprint;
+  footprint_checker_ = helper::FootprintChecker(HEADINGS);
+  if (!footprint_.empty())
+    footprint_checker_.setFootprint(footprint_, costmap_->getResolution());
+
+  // the obstacle cost of the heuristic map changes with the collision model
+  footprint_hash_ = 0;
+  h_map_hash_ = 0;
+}
+
+/**
+ * @brief Try using a Dubins curve (Reeds-Shepp if reversing) to connect the start and goal
  * @param start          start node
  * @param goal           goal node
- * @param path           dubins path between start and goal
+ * @param path           curve between start and goal in cells, without the start
  * @return true if shot successfully, else false
  */
-bool HybridAStar::dubinsShot(const HybridNode& start, const HybridNode& goal, std::vector<Node>& path)
+bool HybridAStar::analyticShot(const HybridNode& start, const HybridNode& goal, std::vector<Node>& path)
 {
-  unsigned int sx, sy, gx, gy;
-  world2Map(start.x_, start.y_, sx, sy);
-  world2Map(goal.x_, goal.y_, gx, gy);
-  std::vector<std::tuple<double, double, double>> poes = { { sx, sy, start.t_ }, { gx, gy, goal.t_ } };
-  std::vector<std::pair<double, double>> path_dubins;
+  unsigned int mx, my;
+  if (!world2Map(start.x_, start.y_, mx, my))
+    return false;
+  const int index = grid2Index(mx, my);
+
+  // a failed shot is not retried from the 8 x 8 cells and two headings around it until the search is a few
+  // primitives closer to the goal, and always retried within a few primitives of the goal where every shot counts
+  const std::uint64_t key = (static_cast<std::uint64_t>(mx >> 3) << 40) | (static_cast<std::uint64_t>(my >> 3) << 16) |
+                            static_cast<std::uint64_t>(states_.heading(start.t_) >> 1);
+  const double retry = SHOT_RETRY * HybridNode::getMotion()[0].x_;
+  ShotFailure& failure = shot_failures_[(key * 0x9e3779b97f4a7c15ULL >> 32) % SHOT_CACHE];
+  if ((failure.plan == shot_plan_) && (failure.key == key) && (start.h() > std::max(failure.h - retry, retry)))
+    return false;
 
-  if (dubins_gen_.run(poes, path_dubins))
+  // the turning radius of the shots is 1 / max_curv_ cells
+  const double res = costmap_->getResolution();
+  const double curv_max = max_curv_ / res;
+  dubins_gen_.setMaxCurv(curv_max);
+  rs_gen_.setMaxCurv(curv_max);
+
+  // the length decides before any sample is drawn, a free curve is a way around the obstacles so the 2D search
+  // cost of its start, a grid path, is not much longer than the curve
+  const trajectory_generation::Pose2d from(start.x_, start.y_, start.t_), to(goal.x_, goal.y_, goal.t_);
+  const double length =
+      is_reverse_ ? rs_gen_.distance(from, to, shot_segments_) : dubins_gen_.distance(from, to, shot_segments_);
+  if (shot_segments_.empty() || (h_map_[index] > SHOT_SLACK * length + 4.0 * res))
+    return false;
+
+  // step along the segments and check each sample as it is drawn, the first collision ends the shot
+  const unsigned char* charmap = costmap_->getCharMap();
+  const double obstacle = _obstacleCost();
+  const double step = 0.5 * res;
+  double x = start.x_, y = start.y_, t = start.t_;
+  int last = index, samples = 0;
+  path.clear();
+  for (const auto& segment : shot_segments_)
   {
-    path.clear();
-    for (auto const& p : path_dubins)
+    // Dubins and Reeds-Shepp share the modes, a negative length drives backwards
+    const double curv = segment.first == DUBINS_L ? curv_max : (segment.first == DUBINS_R ? -curv_max : 0.0);
+    const int n = static_cast<int>(std::ceil(std::abs(segment.second) / step));
+    for (int k = 0; k < n; k++)
     {
-      if (costmap_->getCharMap()[grid2Index(p.first, p.second)] >= costmap_2d::LETHAL_OBSTACLE * factor_)
-        return false;
+      const double dl = segment.second / n;
+      if (curv == 0.0)
+      {
+        x += dl * std::cos(t);
+        y += dl * std::sin(t);
+      }
       else
-        path.emplace_back(p.first, p.second);
+      {
+        x += (std::sin(t + curv * dl) - std::sin(t)) / curv;
+        y -= (std::cos(t + curv * dl) - std::cos(t)) / curv;
+        t += curv * dl;
+      }
+
+      const double u = (x - costmap_->getOriginX()) / res, v = (y - costmap_->getOriginY()) / res;
+      bool collision = !world2Map(x, y, mx, my);
+      if (!collision && (grid2Index(mx, my) != last))
+      {
+        last = grid2Index(mx, my);
+        collision = charmap[last] >= obstacle;
+      }
+      if (!collision && footprint_checker_.valid())
+        collision = footprint_checker_.collides(u, v, t);
+      if (collision)
+      {
+        failure = { key, shot_plan_, static_cast<float>(start.h()) };
+        return false;
+      }
+
+      // keep a point every 1.5 cells
+      if (++samples % 3 == 0)
+        path.emplace_back(u, v);
     }
-    return true;
   }
-  else
-    return false;
+
+  path.emplace_back((goal.x_ - costmap_->getOriginX()) / res, (goal.y_ - costmap_->getOriginY()) / res);
+  return true;
 }
 
 /**
@@ -285,40 +469,55 @@ bool HybridAStar::dubinsShot(const HybridNode& start, const HybridNode& goal, st
  */
 void HybridAStar::updateIndex(HybridNode& node)
 {
-  node.set_id(static_cast<int>(node.t_ / DELTA_HEADING) + _worldToIndex(node.x(), node.y()));
+  // every cell owns HEADINGS consecutive ids, so states of neighbouring cells never collide
+  node.set_id(_worldToIndex(node.x_, node.y_) * HEADINGS + states_.heading(node.t_));
 }
 
 /**
- * @brief update the h-value of hybrid node
+ * @brief update the h-value of hybrid node, the larger of the 2D search cost and the non-holonomic cost
  * @param node hybrid node to update
  */
 void HybridAStar::updateHeuristic(HybridNode& node)
 {
-  // Dubins cost function
+  // Dubins cost function, the goal pose relative to the node is looked up in the table, poses below the x-axis
+  // are mirrored above it and poses beyond the table are left to the 2D search cost
   double cost_dubins = 0.0;
-  // std::vector<std::tuple<double, double, double>> poes = { { node.x_, node.y_, node.t_ },
-  //                                                          { goal_.x_, goal_.y_, goal_.t_ } };
-  // std::vector<std::pair<double, double>> path_dubins;
-  // if (dubins_gen_.run(poes, path_dubins))
-  //   cost_dubins = dubins_gen_.len(path_dubins);
+  const int n = static_cast<int>(HEURISTIC_RANGE / HEURISTIC_STEP);
+  const double dx = goal_.x_ - node.x_, dy = goal_.y_ - node.y_;
+  const double u = (std::cos(node.t_) * dx + std::sin(node.t_) * dy) / MOTION_RADIUS;
+  const double v = (std::cos(node.t_) * dy - std::sin(node.t_) * dx) / MOTION_RADIUS;
+  if ((std::abs(u) <= HEURISTIC_RANGE) && (std::abs(v) <= HEURISTIC_RANGE))
+  {
+    const int iu = static_cast<int>(std::lround(u / HEURISTIC_STEP)) + n;
+    const int iv = static_cast<int>(std::lround(std::abs(v) / HEURISTIC_STEP));
+    const int heading = states_.heading((v < 0 ? node.t_ - goal_.t_ : goal_.t_ - node.t_) + 0.5 * DELTA_HEADING);
+    cost_dubins = h_table_[(heading * (n + 1) + iv) * (2 * n + 1) + iu] * MOTION_RADIUS;
+  }
 
   // 2D search cost function
-  double cost_2d = h_map_[_worldToIndex(node.x_, node.y_)].g() * costmap_->getResolution();
+  const int index = _worldToIndex(node.x_, node.y_);
+  double cost_2d = index < 0 ? std::numeric_limits<double>::infinity() : h_map_[index];
   node.set_h(std::max(cost_2d, cost_dubins));
 }
 
 /**
- * @brief generate heurisitic map using A* algorithm, each matric of map is the distance between it and start.
+ * @brief generate heurisitic map using Dijkstra algorithm, each matric of map is the obstacle-aware distance
+ *        between it and start, infinite if it cannot reach the start.
  * @param start start node
  */
 void HybridAStar::genHeurisiticMap(const Node& start)
 {
-  // open list and closed list
-  std::priority_queue<Node, std::vector<Node>, Node::compare_cost> open_list;
-  std::unordered_map<int, Node> open_set;
-
-  open_list.push(start);
-  open_set.emplace(start.id(), start);
+  const unsigned char* charmap = costmap_->getCharMap();
+  const int nx = costmap_->getSizeInCellsX(), ny = costmap_->getSizeInCellsY();
+  const double res = costmap_->getResolution();
+  const double obstacle = _obstacleCost();
+
+  // open list of (cost, index), entries outdated by a cheaper one are skipped when popped
+  using Entry = std::pair<float, int>;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open_list;
+  h_map_.assign(map_size_, std::numeric_limits<float>::infinity());
+  h_map_[start.id()] = 0.0f;
+  open_list.emplace(0.0f, start.id());
 
   // get all possible motions
   const std::vector<Node> motions = Node::getMotion();
@@ -327,36 +526,38 @@ void HybridAStar::genHeurisiticMap(const Node& start)
   while (!open_list.empty())
   {
     // pop current node from open list
-    Node current = open_list.top();
+    const Entry current = open_list.top();
     open_list.pop();
+    if (current.first > h_map_[current.second])
+      continue;
 
-    h_map_.emplace(current.id(), current);
+    // the vehicle drives from a neighbor into the current cell, which has to be free unless it is the goal
+    // prevent planning failed when the current within inflation
+    const int x = current.second % nx, y = current.second / nx;
+    const unsigned char cost = charmap[current.second];
+    const bool blocked = (current.second != start.id()) && (cost >= obstacle);
 
     // explore neighbor of current node
     for (const auto& motion : motions)
     {
-      // explore a new node
-      Node node_new = current + motion;
-      node_new.set_id(grid2Index(node_new.x(), node_new.y()));
-
-      // node_new in closed list
-      if (h_map_.find(node_new.id()) != h_map_.end())
+      // next node hit the boundary
+      const int mx = x + motion.x(), my = y + motion.y();
+      if ((mx < 0) || (my < 0) || (mx >= nx) || (my >= ny))
         continue;
 
-      // next node hit the boundary or obstacle
-      // prevent planning failed when the current within inflation
-      if ((node_new.id() < 0) || (node_new.id() >= map_size_))
+      // the neighbor may only leave the inflation towards cheaper cells, and never cut the corner of an obstacle
+      const int index = grid2Index(mx, my);
+      if (blocked && (cost >= charmap[index]))
+        continue;
+      if ((motion.x() != 0) && (motion.y() != 0) &&
+          ((charmap[grid2Index(mx, y)] >= obstacle) || (charmap[grid2Index(x, my)] >= obstacle)))
         continue;
 
-      if (open_set.find(node_new.id()) != open_set.end())
-      {
-        if (open_set[node_new.id()].g() > node_new.g())
-          open_set[node_new.id()].set_g(node_new.g());
-      }
-      else
+      const float g = current.first + static_cast<float>(motion.g() * res);
+      if (g < h_map_[index])
       {
-        open_list.push(node_new);
-        open_set.emplace(node_new.id(), node_new);
+        h_map_[index] = g;
+        open_list.emplace(g, index);
       }
     }
   }
@@ -366,41 +567,179 @@ void HybridAStar::genHeurisiticMap(const Node& start)
  * @brief Tranform from world map(x, y) to grid index(i)
  * @param wx world map x
  * @param wy world map y
- * @return index
+ * @return index, -1 if outside the map
  */
 int HybridAStar::_worldToIndex(double wx, double wy)
 {
   unsigned int gx, gy;
-  world2Map(wx, wy, gx, gy);
+  if (!world2Map(wx, wy, gx, gy))
+    return -1;
   return grid2Index(gx, gy);
 }
 
 /**
- * @brief Convert closed list to path
- * @param closed_list closed list
- * @param start       start node
- * @param goal        goal node
- * @return vector containing path nodes
+ * @brief Tabulate every motion primitive from every discrete heading, with the points it sweeps sampled in cells
+ *        at half the costmap resolution
+ */
+void HybridAStar::_buildPrimitives()
+{
+  const std::vector<HybridNode>& motions = HybridNode::getMotion();
+  const double R = MOTION_RADIUS;
+  const double length = motions[0].x_;  // every primitive is an arc of the same length
+  sweep_res_ = costmap_->getResolution();
+  const int samples = std::max(1, static_cast<int>(std::ceil(length / (0.5 * sweep_res_))));
+
+  primitives_.resize(HEADINGS * MOTIONS);
+  sweep_.clear();
+  for (int h = 0; h < HEADINGS; h++)
+  {
+    const double cos_t = std::cos(h * DELTA_HEADING), sin_t = std::sin(h * DELTA_HEADING);
+    for (int m = 0; m < MOTIONS; m++)
+    {
+      // driving direction and turning side of the primitive in the vehicle frame
+      const double d = m < 3 ? 1.0 : -1.0;
+      const double k = motions[m].y_ > 0 ? 1.0 : (motions[m].y_ < 0 ? -1.0 : 0.0);
+
+      Primitive& p = primitives_[h * MOTIONS + m];
+      p.sweep_begin = static_cast<int>(sweep_.size());
+      for (int i = 1; i <= samples; i++)
+      {
+        const double arc = length * i / samples;
+        const double psi = d * k * arc / R;
+        const double lx = k == 0 ? d * arc : k * R * std::sin(psi);
+        const double ly = k == 0 ? 0.0 : k * R * (1 - std::cos(psi));
+        sweep_.emplace_back((lx * cos_t - ly * sin_t) / sweep_res_, (lx * sin_t + ly * cos_t) / sweep_res_);
+      }
+      p.sweep_end = static_cast<int>(sweep_.size());
+      p.dx = sweep_.back().first * sweep_res_;
+      p.dy = sweep_.back().second * sweep_res_;
+      p.heading = (h + static_cast<int>(std::lround(motions[m].t_ / DELTA_HEADING)) + HEADINGS) % HEADINGS;
+    }
+  }
+
+  // penalize turning, change of direction and reversing
+  for (int prev = 0; prev < MOTIONS; prev++)
+  {
+    for (int next = 0; next < MOTIONS; next++)
+    {
+      double penalty = 1.0;
+      // forward driving
+      if (prev < 3)
+      {
+        if (next != prev)
+          penalty = next > 2 ? PENALTY_TURNING * PENALTY_COD : PENALTY_TURNING;
+      }
+      // reverse driving
+      else
+      {
+        if (next != prev)
+          penalty = next < 3 ? PENALTY_TURNING * PENALTY_COD * PENALTY_REVERSING : PENALTY_TURNING * PENALTY_REVERSING;
+        else
+          penalty = PENALTY_REVERSING;
+      }
+      motion_cost_[prev][next] = length * penalty;
+    }
+  }
+}
+
+/**
+ * @brief Tabulate the obstacle-free Dubins (Reeds-Shepp if reversing) length to every goal pose relative to
+ *        the vehicle, in turning radii
+ */
+void HybridAStar::_buildHeuristicTable()
+{
+  // the vehicle sits at the origin heading along x, one layer per relative goal heading with the goal positions
+  // of the upper half-plane, the lower one is its mirror image
+  const int n = static_cast<int>(HEURISTIC_RANGE / HEURISTIC_STEP);
+  const int width = 2 * n + 1, height = n + 1;
+  h_table_.resize(HEADINGS * height * width);
+
+  helper::ThreadPool::instance().parallelFor(HEADINGS, [&](int h, int) {
+    trajectory_generation::Dubins dubins(0.1, 1.0);
+    trajectory_generation::ReedsShepp reeds_shepp(0.1, 1.0);
+    for (int iv = 0; iv < height; iv++)
+    {
+      for (int iu = 0; iu < width; iu++)
+      {
+        const trajectory_generation::Pose2d origin(0.0, 0.0, 0.0);
+        const trajectory_generation::Pose2d goal((iu - n) * HEURISTIC_STEP, iv * HEURISTIC_STEP, h * DELTA_HEADING);
+        const double length = is_reverse_ ? reeds_shepp.distance(origin, goal) : dubins.distance(origin, goal);
+        h_table_[(h * height + iv) * width + iu] = static_cast<float>(length);
+      }
+    }
+  });
+}
+
+/**
+ * @brief Fingerprint of the costmap content, the heuristic map is rebuilt when it changes
+ * @return hash of the map size and costs
  */
-std::vector<Node> HybridAStar::_convertClosedListToPath(std::unordered_map<int, HybridNode>& closed_list,
-                                                        const HybridNode& start, const HybridNode& goal)
+std::uint64_t HybridAStar::_hashCostmap() const
+{
+  // FNV-1a over the geometry and the costs, eight cells at a time
+  std::uint64_t h = 0xcbf29ce484222325ULL;
+  auto mix = [&h](std::uint64_t word) { h = (h ^ word) * 0x100000001b3ULL; };
+
+  const double geometry[] = { static_cast<double>(costmap_->getSizeInCellsX()),
+                              static_cast<double>(costmap_->getSizeInCellsY()), costmap_->getResolution(),
+                              costmap_->getOriginX(), costmap_->getOriginY() };
+  for (const double value : geometry)
+  {
+    std::uint64_t word;
+    std::memcpy(&word, &value, sizeof(word));
+    mix(word);
+  }
+
+  const unsigned char* charmap = costmap_->getCharMap();
+  const std::size_t size = static_cast<std::size_t>(map_size_);
+  std::size_t i = 0;
+  for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t))
+  {
+    std::uint64_t word;
+    std::memcpy(&word, charmap + i, sizeof(word));
+    mix(word);
+  }
+  for (; i < size; i++)
+    mix(charmap[i]);
+
+  return h;
+}
+
+/**
+ * @brief Cost from which a cell blocks the robot centre, with a footprint only the cells inflated by the
+ *        inscribed radius do
+ * @return obstacle cost
+ */
+double HybridAStar::_obstacleCost() const
+{
+  if (footprint_checker_.valid())
+    return costmap_2d::INSCRIBED_INFLATED_OBSTACLE;
+  return costmap_2d::LETHAL_OBSTACLE * factor_;
+}
+
+/**
+ * @brief Convert the parent chain of a searched state to path
+ * @param slot  slot of the last state in the state table
+ * @return vector containing path nodes, from the last state back to the start
+ */
+std::vector<Node> HybridAStar::_convertStatesToPath(int slot)
 {
   unsigned int cur_x, cur_y;
   std::vector<Node> path;
-  auto current = closed_list.find(goal.id());
-  while (current->second != start)
+  for (; slot >= 0; slot = states_[slot].parent)
   {
-    world2Map(current->second.x_, current->second.y_, cur_x, cur_y);
+    world2Map(states_[slot].x, states_[slot].y, cur_x, cur_y);
     path.emplace_back(cur_x, cur_y);
-    auto it = closed_list.find(current->second.pid());
-    if (it != closed_list.end())
-      current = it;
-    else
-      return {};
   }
-  world2Map(start.x_, start.y_, cur_x, cur_y);
-  path.emplace_back(cur_x, cur_y);
   return path;
 }
 
+/**
+ * @brief Heap order of the open list, lowest f first and lowest h on ties
+ */
+bool HybridAStar::compare_open::operator()(const OpenEntry& e1, const OpenEntry& e2) const
+{
+  return (e1.f > e2.f) || ((e1.f == e2.f) && (e1.h > e2.h));
+}
+
 }  // namespace global_planner
\ No newline at end of file
@@ -0,0 +1,152 @@
+/**
+ * *********************************************************
+ *
+ * @file: hybrid_state_table.cpp
+ * @brief: Contains the heading-aware state table of the Hybrid A* planner
+ * @author: Yang Haodong
+ * @date: 2024-10-05
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#include <algorithm>
+#include <cmath>
+
+#include "hybrid_state_table.h"
+
+namespace global_planner
+{
+constexpr int HybridStateTable::kTile;
+
+/**
+ * @brief Construct a new Hybrid State Table object
+ * @param headings number of discrete headings
+ */
+HybridStateTable::HybridStateTable(int headings)
+  : headings_(headings), nx_(0), ny_(0), lattice_(1), tiles_x_(0), generation_(0)
+{
+}
+
+/**
+ * @brief Start a new search, all states become unvisited. O(1) unless the map or lattice size changed.
+ * @param nx      map size in cells along x
+ * @param ny      map size in cells along y
+ * @param lattice lattice cell side in map cells
+ */
+void HybridStateTable::reset(unsigned int nx, unsigned int ny, unsigned int lattice)
+{
+  lattice = std::max(lattice, 1u);
+  if ((nx != nx_) || (ny != ny_) || (lattice != lattice_))
+  {
+    nx_ = nx;
+    ny_ = ny;
+    lattice_ = lattice;
+    const unsigned int span = kTile * lattice;
+    tiles_x_ = (nx + span - 1) / span;
+    tiles_.clear();
+    tiles_.resize(static_cast<std::size_t>(tiles_x_) * ((ny + span - 1) / span));
+    generation_ = 0;
+  }
+
+  // stamps of the previous searches become stale, a wrap around clears them once
+  if (++generation_ == 0)
+  {
+    for (auto& tile : tiles_)
+      for (auto& entry : tile)
+        entry.stamp = 0;
+    generation_ = 1;
+  }
+
+  pool_.clear();
+}
+
+/**
+ * @brief Discrete heading of an angle
+ * @param t angle in radians
+ * @return heading index in [0, headings)
+ */
+int HybridStateTable::heading(double t) const
+{
+  const double two_pi = 2.0 * M_PI;
+  double r = std::fmod(t, two_pi);
+  if (r < 0)
+    r += two_pi;
+  int h = static_cast<int>(r * headings_ / two_pi);
+  return h < headings_ ? h : 0;
+}
+
+/**
+ * @brief Get the slot of a discrete state in the node pool
+ * @param mx      map cell x, inside the map
+ * @param my      map cell y, inside the map
+ * @param heading heading index
+ * @return reference to the slot, -1 if the state has not been visited in this search
+ */
+int& HybridStateTable::slot(unsigned int mx, unsigned int my, int heading)
+{
+  const unsigned int lx = mx / lattice_, ly = my / lattice_;
+  std::vector<Entry>& tile = tiles_[(ly / kTile) * tiles_x_ + lx / kTile];
+  if (tile.empty())
+    tile.assign(kTile * kTile * headings_, Entry{ 0, -1 });
+
+  Entry& entry = tile[((ly % kTile) * kTile + lx % kTile) * headings_ + heading];
+  if (entry.stamp != generation_)
+  {
+    entry.stamp = generation_;
+    entry.slot = -1;
+  }
+  return entry.slot;
+}
+
+/**
+ * @brief Append a node to the pool
+ * @param state node to append
+ * @return slot of the node
+ */
+int HybridStateTable::push(const State& state)
+{
+  pool_.push_back(state);
+  return static_cast<int>(pool_.size()) - 1;
+}
+
+/**
+ * @brief Access a node of the pool
+ * @param slot slot of the node
+ * @return node
+ */
+HybridStateTable::State& HybridStateTable::operator[](int slot)
+{
+  return pool_[slot];
+}
+
+const HybridStateTable::State& HybridStateTable::operator[](int slot) const
+{
+  return pool_[slot];
+}
+
+/**
+ * @brief Get the number of nodes created in this search
+ * @return nodes number
+ */
+int HybridStateTable::size() const
+{
+  return static_cast<int>(pool_.size());
+}
+
+/**
+ * @brief Get the memory held by the tiles and the node pool
+ * @return memory in bytes
+ */
+std::size_t HybridStateTable::memory() const
+{
+  std::size_t bytes = tiles_.capacity() * sizeof(std::vector<Entry>) + pool_.capacity() * sizeof(State);
+  for (const auto& tile : tiles_)
+    bytes += tile.capacity() * sizeof(Entry);
+  return bytes;
+}
+}  // namespace global_planner
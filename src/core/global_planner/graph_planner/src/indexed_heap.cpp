@@ -0,0 +1,208 @@
+/**
+ * *********************************************************
+ *
+ * @file: indexed_heap.cpp
+ * @brief: Contains the indexed open heap of the incremental planners
+ * @author: Yang Haodong
+ * @date: 2024-10-10
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#include "indexed_heap.h"
+
+namespace global_planner
+{
+bool IndexedHeap::Key::operator<(const Key& other) const
+{
+  return (k1 < other.k1) || ((k1 == other.k1) && (k2 < other.k2));
+}
+
+bool IndexedHeap::Key::operator<=(const Key& other) const
+{
+  return !(other < *this);
+}
+
+/**
+ * @brief Construct a new Indexed Heap object
+ * @param states state table which holds the heap position of each cell
+ */
+IndexedHeap::IndexedHeap(GridStateTable& states) : states_(states)
+{
+}
+
+/**
+ * @brief Remove every cell from the heap
+ */
+void IndexedHeap::clear()
+{
+  for (const Entry& e : entries_)
+    states_.position(e.s) = -1;
+  entries_.clear();
+}
+
+/**
+ * @brief Whether the heap is empty
+ */
+bool IndexedHeap::empty() const
+{
+  return entries_.empty();
+}
+
+/**
+ * @brief Get the number of queued cells
+ * @return cells number
+ */
+int IndexedHeap::size() const
+{
+  return static_cast<int>(entries_.size());
+}
+
+/**
+ * @brief Get the cell with the lowest key and its key, the heap must not be empty
+ */
+int IndexedHeap::top() const
+{
+  return entries_.front().s;
+}
+
+const IndexedHeap::Key& IndexedHeap::topKey() const
+{
+  return entries_.front().key;
+}
+
+/**
+ * @brief Remove the cell with the lowest key, the heap must not be empty
+ * @return the removed cell
+ */
+int IndexedHeap::pop()
+{
+  const int s = entries_.front().s;
+  remove(s);
+  return s;
+}
+
+/**
+ * @brief Whether a cell is queued
+ * @param s index of the cell
+ * @return true if queued, else false
+ */
+bool IndexedHeap::contains(int s) const
+{
+  return states_.position(s) >= 0;
+}
+
+/**
+ * @brief Get the key of a queued cell
+ * @param s index of the cell
+ * @return key of the cell
+ */
+const IndexedHeap::Key& IndexedHeap::key(int s) const
+{
+  return entries_[states_.position(s)].key;
+}
+
+/**
+ * @brief Queue a cell with a key, or move it to the key if it is queued already
+ * @param s index of the cell
+ * @param k key of the cell
+ */
+void IndexedHeap::push(int s, const Key& k)
+{
+  int& i = states_.position(s);
+  if (i < 0)
+  {
+    i = static_cast<int>(entries_.size());
+    entries_.push_back({ k, s });
+    _siftUp(i);
+  }
+  else if (k < entries_[i].key)
+  {
+    entries_[i].key = k;
+    _siftUp(i);
+  }
+  else
+  {
+    entries_[i].key = k;
+    _siftDown(i);
+  }
+}
+
+/**
+ * @brief Remove a cell from the heap, nothing happens if it is not queued
+ * @param s index of the cell
+ */
+void IndexedHeap::remove(int s)
+{
+  int& pos = states_.position(s);
+  const int i = pos;
+  if (i < 0)
+    return;
+  pos = -1;
+
+  // the last entry fills the hole and moves whichever way its key requires
+  const Entry last = entries_.back();
+  entries_.pop_back();
+  if (i == static_cast<int>(entries_.size()))
+    return;
+
+  const bool up = last.key < entries_[i].key;
+  entries_[i] = last;
+  states_.position(last.s) = i;
+  if (up)
+    _siftUp(i);
+  else
+    _siftDown(i);
+}
+
+/**
+ * @brief Move the entry at a heap position towards the root or the leaves until the heap order holds
+ * @param i heap position
+ */
+void IndexedHeap::_siftUp(int i)
+{
+  const Entry e = entries_[i];
+  while (i > 0)
+  {
+    const int parent = (i - 1) / 4;
+    if (!(e.key < entries_[parent].key))
+      break;
+    entries_[i] = entries_[parent];
+    states_.position(entries_[i].s) = i;
+    i = parent;
+  }
+  entries_[i] = e;
+  states_.position(e.s) = i;
+}
+
+void IndexedHeap::_siftDown(int i)
+{
+  const Entry e = entries_[i];
+  const int n = static_cast<int>(entries_.size());
+  while (true)
+  {
+    // smallest of the up to four children
+    const int first = 4 * i + 1;
+    if (first >= n)
+      break;
+    int child = first;
+    const int last = first + 4 < n ? first + 4 : n;
+    for (int c = first + 1; c < last; c++)
+      if (entries_[c].key < entries_[child].key)
+        child = c;
+
+    if (!(entries_[child].key < e.key))
+      break;
+    entries_[i] = entries_[child];
+    states_.position(entries_[i].s) = i;
+    i = child;
+  }
+  entries_[i] = e;
+  states_.position(e.s) = i;
+}
+}  // namespace global_planner
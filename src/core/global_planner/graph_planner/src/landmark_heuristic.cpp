@@ -0,0 +1,303 @@
+/**
+ * *********************************************************
+ *
+ * @file: landmark_heuristic.cpp
+ * @brief: Contains the ALT (A*, landmarks and triangle inequality) heuristics of a costmap
+ * @author: Yang Haodong
+ * @date: 2024-06-03
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+#include "thread_pool.h"
+#include "landmark_heuristic.h"
+
+namespace global_planner
+{
+namespace
+{
+constexpr double kInf = std::numeric_limits<double>::infinity();
+constexpr std::uint16_t kUnreached = std::numeric_limits<std::uint16_t>::max();
+// 8-connected motions, the same as Node::getMotion()
+constexpr int kMotionX[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+constexpr int kMotionY[8] = { 1, 0, -1, 0, 1, -1, 1, -1 };
+constexpr double kMotionCost[8] = { 1.0, 1.0, 1.0, 1.0, M_SQRT2, M_SQRT2, M_SQRT2, M_SQRT2 };
+
+/**
+ * @brief Dijkstra over the passable cells of a grid
+ * @param passable passability of the cells
+ * @param nx       grid width in cells
+ * @param ny       grid height in cells
+ * @param source   index of the source cell
+ * @param dist     distances from the source, infinity if not reached
+ */
+void dijkstra(const std::vector<unsigned char>& passable, int nx, int ny, int source, std::vector<double>& dist)
+{
+  using OpenList = std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>,
+                                       std::greater<std::pair<double, int>>>;
+  dist.assign(nx * ny, kInf);
+  dist[source] = 0.0;
+  OpenList open_list;
+  open_list.emplace(0.0, source);
+  while (!open_list.empty())
+  {
+    const double d = open_list.top().first;
+    const int u = open_list.top().second;
+    open_list.pop();
+    if (d > dist[u])
+      continue;
+
+    const int x = u % nx, y = u / nx;
+    for (int k = 0; k < 8; k++)
+    {
+      const int xn = x + kMotionX[k], yn = y + kMotionY[k];
+      if (xn < 0 || xn >= nx || yn < 0 || yn >= ny || !passable[xn + yn * nx])
+        continue;
+      const int v = xn + yn * nx;
+      if (d + kMotionCost[k] < dist[v])
+      {
+        dist[v] = d + kMotionCost[k];
+        open_list.emplace(dist[v], v);
+      }
+    }
+  }
+}
+}  // namespace
+
+/**
+ * @brief Construct a new LandmarkHeuristic object
+ * @param costmap   the environment for path planning
+ * @param landmarks number of landmarks
+ */
+LandmarkHeuristic::LandmarkHeuristic(costmap_2d::Costmap2D* costmap, int landmarks)
+  : costmap_(costmap), landmarks_(std::max(landmarks, 1)), checked_version_(0), valid_(false), building_(false)
+{
+  journal_ = CostmapJournal::instance(costmap);
+}
+
+/**
+ * @brief Destroy the LandmarkHeuristic object, waiting for a running build
+ */
+LandmarkHeuristic::~LandmarkHeuristic()
+{
+  if (builder_.joinable())
+    builder_.join();
+}
+
+/**
+ * @brief Bring the tables up to date with the costmap, starting a rebuild in the background if they no longer hold
+ * @param factor obstacle factor of the planner
+ * @return true if the tables bound the distances on the current costmap
+ */
+bool LandmarkHeuristic::update(float factor)
+{
+  const std::uint64_t version = journal_->update();
+  const CostmapJournal::Snapshot snapshot = journal_->map();
+  const unsigned char* map = snapshot->data();
+  const int nx = static_cast<int>(costmap_->getSizeInCellsX());
+  const int ny = static_cast<int>(costmap_->getSizeInCellsY());
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (built_)
+    {
+      tables_ = built_;
+      built_.reset();
+      checked_version_ = tables_->version;
+      valid_ = true;
+    }
+  }
+
+  // blocking cells only lengthens distances, freeing one a table saw blocked may shorten them below its bounds
+  if (tables_ && valid_ && version != checked_version_)
+  {
+    std::vector<int> changed;
+    valid_ = journal_->changes(checked_version_, changed);
+    for (size_t i = 0; valid_ && i < changed.size(); i++)
+      valid_ = tables_->passable[changed[i]] || map[changed[i]] >= costmap_2d::LETHAL_OBSTACLE * tables_->factor;
+    checked_version_ = version;
+  }
+
+  const bool usable = tables_ && valid_ && tables_->nx == nx && tables_->ny == ny && tables_->factor == factor;
+
+  // tables being built are checked once taken, and rebuilt again if the costmap freed cells meanwhile
+  if (!usable && !building_ && nx * ny > 0)
+  {
+    if (builder_.joinable())
+      builder_.join();
+
+    auto tables = std::make_shared<Tables>();
+    tables->nx = nx;
+    tables->ny = ny;
+    tables->factor = factor;
+    tables->version = version;
+    tables->passable.resize(nx * ny);
+    for (int i = 0; i < nx * ny; i++)
+      tables->passable[i] = map[i] < costmap_2d::LETHAL_OBSTACLE * factor;
+
+    building_ = true;
+    builder_ = std::thread([this, tables]() {
+      _build(*tables);
+      std::lock_guard<std::mutex> lock(mutex_);
+      built_ = tables;
+      building_ = false;
+    });
+  }
+
+  return usable;
+}
+
+/**
+ * @brief Set the goal cell of the following estimates
+ * @param goal index of the goal cell
+ */
+void LandmarkHeuristic::setGoal(int goal)
+{
+  const int n = tables_->nx * tables_->ny;
+  goal_distances_.resize(tables_->landmarks.size());
+  for (size_t k = 0; k < tables_->landmarks.size(); k++)
+    goal_distances_[k] = goal >= 0 && goal < n ? tables_->distances[k * n + goal] : kUnreached;
+}
+
+/**
+ * @brief Lower bound of the distance from a cell to the goal
+ * @param cell index of the cell
+ * @return distance in cells, 0 if no landmark reaches both
+ */
+double LandmarkHeuristic::estimate(int cell) const
+{
+  // a distance d stored as floor(d / unit) is known to one unit, so the bound drops one
+  const int n = tables_->nx * tables_->ny;
+  double h = 0.0;
+  for (size_t k = 0; k < goal_distances_.size(); k++)
+  {
+    const std::uint16_t dg = goal_distances_[k], dn = tables_->distances[k * n + cell];
+    if (dg == kUnreached || dn == kUnreached)
+      continue;
+    const int steps = std::abs(static_cast<int>(dg) - static_cast<int>(dn)) - 1;
+    h = std::max(h, steps * tables_->units[k]);
+  }
+
+  return h;
+}
+
+/**
+ * @brief Select the landmarks and compute their distance tables
+ * @param tables tables with the passability filled in
+ */
+void LandmarkHeuristic::_build(Tables& tables) const
+{
+  _selectLandmarks(tables);
+
+  const int n = tables.nx * tables.ny;
+  const int k_num = static_cast<int>(tables.landmarks.size());
+  tables.units.assign(k_num, 1.0);
+  tables.distances.resize(static_cast<size_t>(k_num) * n);
+
+  helper::ThreadPool::instance().parallelFor(k_num, [&](int k, int) {
+    std::vector<double> dist;
+    dijkstra(tables.passable, tables.nx, tables.ny, tables.landmarks[k], dist);
+
+    double max_dist = 0.0;
+    for (double d : dist)
+      if (d < kInf)
+        max_dist = std::max(max_dist, d);
+    const double unit = max_dist > 0.0 ? max_dist / (kUnreached - 1) : 1.0;
+
+    std::uint16_t* table = tables.distances.data() + static_cast<size_t>(k) * n;
+    for (int i = 0; i < n; i++)
+      table[i] = dist[i] < kInf ? static_cast<std::uint16_t>(std::min(dist[i] / unit, kUnreached - 1.0)) : kUnreached;
+    tables.units[k] = unit;
+  });
+}
+
+/**
+ * @brief Select landmarks by farthest-point selection over blocks of cells, within the largest component
+ * @param tables tables with the passability filled in, the landmarks are appended
+ */
+void LandmarkHeuristic::_selectLandmarks(Tables& tables) const
+{
+  // a block is passable if any of its cells is, and stands for the first of them
+  const int bx = (tables.nx + LANDMARK_BLOCK - 1) / LANDMARK_BLOCK;
+  const int by = (tables.ny + LANDMARK_BLOCK - 1) / LANDMARK_BLOCK;
+  std::vector<unsigned char> passable(bx * by, 0);
+  std::vector<int> cell(bx * by, -1);
+  for (int y = tables.ny - 1; y >= 0; y--)
+  {
+    for (int x = tables.nx - 1; x >= 0; x--)
+    {
+      const int b = x / LANDMARK_BLOCK + y / LANDMARK_BLOCK * bx;
+      if (tables.passable[x + y * tables.nx])
+      {
+        passable[b] = 1;
+        cell[b] = x + y * tables.nx;
+      }
+    }
+  }
+
+  // seed within the largest component, so that the landmarks cover the map planned on
+  std::vector<unsigned char> seen(bx * by, 0);
+  std::vector<int> stack;
+  int seed = -1, seed_size = 0;
+  for (int b = 0; b < bx * by; b++)
+  {
+    if (!passable[b] || seen[b])
+      continue;
+    int size = 0;
+    seen[b] = 1;
+    stack.push_back(b);
+    while (!stack.empty())
+    {
+      const int u = stack.back();
+      stack.pop_back();
+      size++;
+      for (int k = 0; k < 8; k++)
+      {
+        const int xn = u % bx + kMotionX[k], yn = u / bx + kMotionY[k];
+        if (xn >= 0 && xn < bx && yn >= 0 && yn < by && passable[xn + yn * bx] && !seen[xn + yn * bx])
+        {
+          seen[xn + yn * bx] = 1;
+          stack.push_back(xn + yn * bx);
+        }
+      }
+    }
+    if (size > seed_size)
+    {
+      seed = b;
+      seed_size = size;
+    }
+  }
+  if (seed < 0)
+    return;
+
+  // every landmark is the block farthest from those before, the first one farthest from the seed
+  std::vector<double> dist, nearest(bx * by, kInf);
+  dijkstra(passable, bx, by, seed, dist);
+  for (int k = 0; k < landmarks_; k++)
+  {
+    int farthest = -1;
+    for (int b = 0; b < bx * by; b++)
+      if (dist[b] < kInf && (farthest < 0 || dist[b] > dist[farthest]))
+        farthest = b;
+    if (farthest < 0 || (k > 0 && dist[farthest] == 0.0))
+      break;
+
+    tables.landmarks.push_back(cell[farthest]);
+    dijkstra(passable, bx, by, farthest, dist);
+    for (int b = 0; b < bx * by; b++)
+      nearest[b] = std::min(nearest[b], dist[b]);
+    dist = nearest;
+  }
+}
+}  // namespace global_planner
@@ -16,18 +16,18 @@
  */
 #include "lpa_star.h"
 
-#define WINDOW_SIZE 70  // local costmap window size (in grid, 3.5m / 0.05 = 70)
-
 namespace global_planner
 {
 /**
  * @brief Construct a new LPAStar object
  * @param costmap the environment for path planning
  */
-LPAStar::LPAStar(costmap_2d::Costmap2D* costmap) : GlobalPlanner(costmap)
+LPAStar::LPAStar(costmap_2d::Costmap2D* costmap) : GlobalPlanner(costmap), open_list_(states_)
 {
-  curr_global_costmap_ = new unsigned char[map_size_];
-  last_global_costmap_ = new unsigned char[map_size_];
+  journal_ = CostmapJournal::instance(costmap);
+  version_ = journal_->version();
+  snapshot_ = journal_->map();
+  curr_global_costmap_ = snapshot_->data();
   start_.set_x(INF);
   start_.set_y(INF);
   goal_.set_x(INF);
@@ -40,19 +40,7 @@ LPAStar::LPAStar(costmap_2d::Costmap2D* costmap) : GlobalPlanner(costmap)
  */
 void LPAStar::initMap()
 {
-  auto nx = costmap_->getSizeInCellsX();
-  auto ny = costmap_->getSizeInCellsY();
-
-  map_ = new LNodePtr*[nx];
-  for (int i = 0; i < nx; i++)
-  {
-    map_[i] = new LNodePtr[ny];
-    for (int j = 0; j < ny; j++)
-    {
-      map_[i][j] = new LNode(i, j, INF, INF, grid2Index(i, j), -1, INF, INF);
-      map_[i][j]->open_it = open_list_.end();  // allocate empty memory
-    }
-  }
+  states_.reset(costmap_->getSizeInCellsX(), costmap_->getSizeInCellsY());
 }
 
 /**
@@ -60,67 +48,59 @@ void LPAStar::initMap()
  */
 void LPAStar::reset()
 {
-  auto nx = costmap_->getSizeInCellsX();
-  auto ny = costmap_->getSizeInCellsY();
-
   open_list_.clear();
-
-  for (int i = 0; i < nx; i++)
-    for (int j = 0; j < ny; j++)
-      delete map_[i][j];
-
-  for (int i = 0; i < nx; i++)
-    delete[] map_[i];
-
-  delete[] map_;
-
   initMap();
 }
 
 /**
  * @brief Get heuristics between n1 and n2
- * @param n1 LNode pointer of on LNode
- * @param n2 LNode pointer of the other LNode
+ * @param n1 index of one cell
+ * @param n2 index of the other cell
  * @return heuristics between n1 and n2
  */
-double LPAStar::getH(LNodePtr n1, LNodePtr n2)
+double LPAStar::getH(int n1, int n2)
 {
-  return std::hypot(n1->x() - n2->x(), n1->y() - n2->y());
+  int x1, y1, x2, y2;
+  index2Grid(n1, x1, y1);
+  index2Grid(n2, x2, y2);
+  return std::hypot(x1 - x2, y1 - y2);
 }
 
 /**
  * @brief Calculate the key of s
- * @param s LNode pointer
+ * @param s index of the cell
  * @return the key value
  */
-double LPAStar::calculateKey(LNodePtr s)
+IndexedHeap::Key LPAStar::calculateKey(int s)
 {
-  return std::min(s->g(), s->rhs) + 0.9 * getH(s, goal_ptr_);
+  const double g = std::min(states_.g(s), states_.rhs(s));
+  return { g + 0.9 * getH(s, goal_idx_), g };
 }
 
 /**
  * @brief Check if there is collision between n1 and n2
- * @param n1 LNode pointer of one LNode
- * @param n2 LNode pointer of the other LNode
+ * @param n1 index of one cell
+ * @param n2 index of the other cell
  * @return true if collision, else false
  */
-bool LPAStar::isCollision(LNodePtr n1, LNodePtr n2)
+bool LPAStar::isCollision(int n1, int n2)
 {
-  return (curr_global_costmap_[n1->id()] > costmap_2d::LETHAL_OBSTACLE * factor_) ||
-         (curr_global_costmap_[n2->id()] > costmap_2d::LETHAL_OBSTACLE * factor_);
+  return (curr_global_costmap_[n1] > costmap_2d::LETHAL_OBSTACLE * factor_) ||
+         (curr_global_costmap_[n2] > costmap_2d::LETHAL_OBSTACLE * factor_);
 }
 
 /**
- * @brief Get neighbour LNodePtrs of nodePtr
- * @param node_ptr   LNode to expand
- * @param neighbours neigbour LNodePtrs in vector
+ * @brief Get neighbour cells of a cell, except those in collision
+ * @param s          index of the cell to expand
+ * @param neighbours neigbour cell indices in vector
  */
-void LPAStar::getNeighbours(LNodePtr node_ptr, std::vector<LNodePtr>& neighbours)
+void LPAStar::getNeighbours(int s, std::vector<int>& neighbours)
 {
   auto nx = costmap_->getSizeInCellsX();
   auto ny = costmap_->getSizeInCellsY();
 
-  int x = node_ptr->x(), y = node_ptr->y();
+  int x, y;
+  index2Grid(s, x, y);
   for (int i = -1; i <= 1; i++)
   {
     for (int j = -1; j <= 1; j++)
@@ -132,61 +112,54 @@ void LPAStar::getNeighbours(LNodePtr node_ptr, std::vector<LNodePtr>& neighbours
       if (x_n < 0 || x_n >= nx || y_n < 0 || y_n >= ny)
         continue;
 
-      LNodePtr neigbour_ptr = map_[x_n][y_n];
-      if (isCollision(node_ptr, neigbour_ptr))
+      const int n = grid2Index(x_n, y_n);
+      if (isCollision(s, n))
         continue;
 
-      neighbours.push_back(neigbour_ptr);
+      neighbours.push_back(n);
     }
   }
 }
 
 /**
  * @brief Get the cost between n1 and n2, return INF if collision
- * @param n1 LNode pointer of one LNode
- * @param n2 LNode pointer of the other LNode
+ * @param n1 index of one cell
+ * @param n2 index of the other cell
  * @return cost between n1 and n2
  */
-double LPAStar::getCost(LNodePtr n1, LNodePtr n2)
+double LPAStar::getCost(int n1, int n2)
 {
   if (isCollision(n1, n2))
     return INF;
 
-  return std::hypot(n1->x() - n2->x(), n1->y() - n2->y());
+  return getH(n1, n2);
 }
 
 /**
  * @brief Update vertex u
- * @param u LNode pointer to update
+ * @param u index of the cell to update
  */
-void LPAStar::updateVertex(LNodePtr u)
+void LPAStar::updateVertex(int u)
 {
   // u != start
-  if (u->x() != start_.x() || u->y() != start_.y())
+  if (u != start_idx_)
   {
-    std::vector<LNodePtr> neigbours;
+    std::vector<int> neigbours;
     getNeighbours(u, neigbours);
 
     // min_{s\in pred(u)}(g(s) + c(s, u))
-    u->rhs = INF;
-    for (LNodePtr s : neigbours)
-      if (s->g() + getCost(s, u) < u->rhs)
-        u->rhs = s->g() + getCost(s, u);
+    double& rhs = states_.rhs(u);
+    rhs = INF;
+    for (int s : neigbours)
+      if (states_.g(s) + getCost(s, u) < rhs)
+        rhs = states_.g(s) + getCost(s, u);
   }
 
-  // u in openlist, remove u
-  if (u->open_it != open_list_.end())
-  {
-    open_list_.erase(u->open_it);
-    u->open_it = open_list_.end();
-  }
-
-  // g(u) != rhs(u)
-  if (u->g() != u->rhs)
-  {
-    u->key = calculateKey(u);
-    u->open_it = open_list_.insert(std::make_pair(u->key, u));
-  }
+  // g(u) != rhs(u), u is queued with its new key, else it is locally consistent and leaves the open list
+  if (states_.g(u) != states_.rhs(u))
+    open_list_.push(u, calculateKey(u));
+  else
+    open_list_.remove(u);
 }
 
 /**
@@ -194,35 +167,28 @@ void LPAStar::updateVertex(LNodePtr u)
  */
 void LPAStar::computeShortestPath()
 {
-  while (true)
+  // until the goal is locally consistent and no queued cell can lower its cost
+  while (!open_list_.empty() &&
+         (open_list_.topKey() < calculateKey(goal_idx_) || states_.rhs(goal_idx_) != states_.g(goal_idx_)))
   {
-    if (open_list_.empty())
-      break;
-
-    LNodePtr u = open_list_.begin()->second;
-    open_list_.erase(open_list_.begin());
-    u->open_it = open_list_.end();
-    expand_.push_back(*u);
-
-    // goal reached
-    if (u->key >= calculateKey(goal_ptr_) && goal_ptr_->rhs == goal_ptr_->g())
-      break;
+    int u = open_list_.pop();
+    expand_.push_back(_getNode(u));
 
     // Locally over-consistent -> Locally consistent
-    if (u->g() > u->rhs)
+    if (states_.g(u) > states_.rhs(u))
     {
-      u->set_g(u->rhs);
+      states_.g(u) = states_.rhs(u);
     }
     // Locally under-consistent -> Locally over-consistent
     else
     {
-      u->set_g(INF);
+      states_.g(u) = INF;
       updateVertex(u);
     }
 
-    std::vector<LNodePtr> neigbours;
+    std::vector<int> neigbours;
     getNeighbours(u, neigbours);
-    for (LNodePtr s : neigbours)
+    for (int s : neigbours)
       updateVertex(s);
   }
 }
@@ -236,26 +202,27 @@ void LPAStar::computeShortestPath()
 bool LPAStar::extractPath(const Node& start, const Node& goal)
 {
   std::vector<Node> path_temp;
-  LNodePtr node_ptr = map_[goal.x()][goal.y()];
+  int s = grid2Index(goal.x(), goal.y());
+  const int end = grid2Index(start.x(), start.y());
   int count = 0;
-  while (node_ptr->x() != start.x() || node_ptr->y() != start.y())
+  while (s != end)
   {
-    path_temp.push_back(*node_ptr);
+    path_temp.push_back(_getNode(s));
 
     // argmin_{s\in pred(u)}
-    std::vector<LNodePtr> neigbours;
-    getNeighbours(node_ptr, neigbours);
+    std::vector<int> neigbours;
+    getNeighbours(s, neigbours);
     double min_cost = INF;
-    LNodePtr next_node_ptr;
-    for (LNodePtr node_n_ptr : neigbours)
+    int next = s;
+    for (int n : neigbours)
     {
-      if (node_n_ptr->g() < min_cost)
+      if (states_.g(n) < min_cost)
       {
-        min_cost = node_n_ptr->g();
-        next_node_ptr = node_n_ptr;
+        min_cost = states_.g(n);
+        next = n;
       }
     }
-    node_ptr = next_node_ptr;
+    s = next;
 
     // TODO: it happens to cannnot find a path to start sometimes..
     // use counter to solve it templately
@@ -300,24 +267,27 @@ Node LPAStar::getState(const Node& current)
  */
 bool LPAStar::plan(const Node& start, const Node& goal, std::vector<Node>& path, std::vector<Node>& expand)
 {
-  // update costmap
-  memcpy(last_global_costmap_, curr_global_costmap_, map_size_);
-  memcpy(curr_global_costmap_, costmap_->getCharMap(), map_size_);
+  // update costmap, changed is every cell changed since the last plan unless the journal lost track of it
+  std::vector<int> changed;
+  const std::uint64_t version = journal_->update();
+  const bool tracked = journal_->changes(version_, changed);
+  version_ = version;
+  snapshot_ = journal_->map();
+  curr_global_costmap_ = snapshot_->data();
 
   expand_.clear();
 
   // new start or goal set
-  if (start_.x() != start.x() || start_.y() != start.y() || goal_.x() != goal.x() || goal_.y() != goal.y())
+  if (!tracked || start_.x() != start.x() || start_.y() != start.y() || goal_.x() != goal.x() || goal_.y() != goal.y())
   {
     reset();
     start_ = start;
     goal_ = goal;
-    start_ptr_ = map_[start.x()][start.y()];
-    goal_ptr_ = map_[goal.x()][goal.y()];
+    start_idx_ = grid2Index(start.x(), start.y());
+    goal_idx_ = grid2Index(goal.x(), goal.y());
 
-    start_ptr_->rhs = 0.0;
-    start_ptr_->key = calculateKey(start_ptr_);
-    start_ptr_->open_it = open_list_.insert(std::make_pair(start_ptr_->key, start_ptr_));
+    states_.rhs(start_idx_) = 0.0;
+    open_list_.push(start_idx_, calculateKey(start_idx_));
 
     computeShortestPath();
 
@@ -337,25 +307,13 @@ bool LPAStar::plan(const Node& start, const Node& goal, std::vector<Node>& path,
   {
     Node state = getState(start);
 
-    for (int i = -WINDOW_SIZE / 2; i < WINDOW_SIZE / 2; ++i)
+    for (int idx : changed)
     {
-      for (int j = -WINDOW_SIZE / 2; j < WINDOW_SIZE / 2; ++j)
-      {
-        int x_n = state.x() + i, y_n = state.y() + j;
-        if (x_n < 0 || x_n > costmap_->getSizeInCellsX() - 1 || y_n < 0 || y_n > costmap_->getSizeInCellsY() - 1)
-          continue;
-
-        int idx = grid2Index(x_n, y_n);
-        if (curr_global_costmap_[idx] != last_global_costmap_[idx])
-        {
-          LNodePtr u = map_[x_n][y_n];
-          std::vector<LNodePtr> neigbours;
-          getNeighbours(u, neigbours);
-          updateVertex(u);
-          for (LNodePtr s : neigbours)
-            updateVertex(s);
-        }
-      }
+      std::vector<int> neigbours;
+      getNeighbours(idx, neigbours);
+      updateVertex(idx);
+      for (int s : neigbours)
+        updateVertex(s);
     }
     computeShortestPath();
 
@@ -370,4 +328,16 @@ bool LPAStar::plan(const Node& start, const Node& goal, std::vector<Node>& path,
     return true;
   }
 }
+
+/**
+ * @brief Convert a cell and its search state to Node
+ * @param s index of the cell
+ * @return node of the cell
+ */
+Node LPAStar::_getNode(int s)
+{
+  int x, y;
+  index2Grid(s, x, y);
+  return Node(x, y, states_.g(s), INF, s, states_.parent(s));
+}
 }  // namespace global_planner
\ No newline at end of file
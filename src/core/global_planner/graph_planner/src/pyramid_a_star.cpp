@@ -0,0 +1,345 @@
+/**
+ * *********************************************************
+ *
+ * @file: pyramid_a_star.cpp
+ * @brief: Contains the coarse-to-fine A* planner class over a multi-resolution costmap pyramid
+ * @author: Yang Haodong
+ * @date: 2024-05-27
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#include <algorithm>
+#include <cmath>
+
+#include "pyramid_a_star.h"
+
+namespace global_planner
+{
+namespace
+{
+// 8-connected motions, the same as Node::getMotion()
+constexpr int kMotionX[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+constexpr int kMotionY[8] = { 1, 0, -1, 0, 1, -1, 1, -1 };
+constexpr double kMotionCost[8] = { 1.0, 1.0, 1.0, 1.0, M_SQRT2, M_SQRT2, M_SQRT2, M_SQRT2 };
+}  // namespace
+
+/**
+ * @brief Construct a new PyramidAStar object
+ * @param costmap         the environment for path planning
+ * @param levels          levels of the pyramid searched, at most PYRAMID_LEVELS
+ * @param corridor_radius cells of a coarser level around its path which the finer level may search
+ * @param mixed_radius    cells around start and goal which a level searches although partly blocked
+ */
+PyramidAStar::PyramidAStar(costmap_2d::Costmap2D* costmap, int levels, int corridor_radius, int mixed_radius)
+  : GlobalPlanner(costmap)
+  , levels_(std::min(std::max(levels, 1), PYRAMID_LEVELS))
+  , corridor_radius_(std::max(corridor_radius, 0))
+  , mixed_radius_(std::max(mixed_radius, 0))
+  , built_factor_(0.0f)
+  , built_(false)
+  , corridor_stamp_(0)
+  , open_list_(states_)
+  , fallback_(costmap)
+{
+  journal_ = CostmapJournal::instance(costmap);
+  version_ = journal_->version();
+  snapshot_ = journal_->map();
+  map_ = snapshot_->data();
+}
+
+/**
+ * @brief Coarse-to-fine A* implementation
+ * @param start  start node
+ * @param goal   goal node
+ * @param path   path consists of Node
+ * @param expand containing the node been search during the process
+ * @return true if path found, else false
+ */
+bool PyramidAStar::plan(const Node& start, const Node& goal, std::vector<Node>& path, std::vector<Node>& expand)
+{
+  path.clear();
+  expand.clear();
+
+  _update();
+
+  // A* also leaves a start within obstacles or reaches a goal within them, the pyramid covers free cells only
+  const int s = start.x() + start.y() * nx_[0];
+  const int g = goal.x() + goal.y() * nx_[0];
+  if (s < 0 || s >= nx_[0] * ny_[0] || g < 0 || g >= nx_[0] * ny_[0] || occupancy_[0][s] || occupancy_[0][g])
+  {
+    fallback_.setFactor(factor_);
+    return fallback_.plan(start, goal, path, expand);
+  }
+
+  auto index = [this](int level, int x, int y) { return (x >> level) + (y >> level) * nx_[level]; };
+
+  // the coarsest level whose path is no detour, narrow passages are closed on the coarser ones. Searched over the
+  // cells not all blocked, a level bounds the cost of any path on the map and reaches the goal if the map does
+  std::vector<int> cells;
+  int level = levels_ - 1;
+  for (; level > 0; level--)
+  {
+    const int ls = index(level, start.x(), start.y()), lg = index(level, goal.x(), goal.y());
+    if (!_search(level, ls, lg, false, true, cells, expand))
+      return false;
+    const double bound = states_.g(lg);
+    if (_search(level, ls, lg, false, false, cells, expand) && states_.g(lg) <= DETOUR_RATIO * bound)
+      break;
+  }
+
+  // without any coarse level connecting them without a detour the search over all cells is final
+  if (level == 0)
+    return _search(0, s, g, false, false, cells, expand) && _extractPath(cells, path);
+
+  // refine level by level within the corridor of the path above, and over all cells if the corridor is blocked
+  bool found = true;
+  while (found && level > 0)
+  {
+    _markCorridor(level, cells);
+    level--;
+    const int ls = index(level, start.x(), start.y()), lg = index(level, goal.x(), goal.y());
+    found = _search(level, ls, lg, true, false, cells, expand);
+  }
+  if (!found)
+  {
+    std::vector<Node> fallback_expand;
+    fallback_.setFactor(factor_);
+    const bool result = fallback_.plan(start, goal, path, fallback_expand);
+    expand.insert(expand.end(), fallback_expand.begin(), fallback_expand.end());
+    return result;
+  }
+
+  return _extractPath(cells, path);
+}
+
+/**
+ * @brief Convert the path of the last search over all cells to nodes
+ * @param cells path of cells from goal to start
+ * @param path  path consists of Node
+ * @return true
+ */
+bool PyramidAStar::_extractPath(const std::vector<int>& cells, std::vector<Node>& path)
+{
+  for (size_t i = 0; i < cells.size(); i++)
+  {
+    int x, y;
+    index2Grid(cells[i], x, y);
+    path.emplace_back(x, y, states_.g(cells[i]), 0.0, cells[i], states_.parent(cells[i]));
+  }
+  path.back().set_pid(path.back().id());
+
+  return true;
+}
+
+/**
+ * @brief Bring the pyramid up to date with the costmap, rebuilding it or pooling the changed cells up
+ */
+void PyramidAStar::_update()
+{
+  std::vector<int> changed;
+  const std::uint64_t version = journal_->update();
+  const bool tracked = journal_->changes(version_, changed);
+  version_ = version;
+  snapshot_ = journal_->map();
+  map_ = snapshot_->data();
+
+  if (!built_ || !tracked || built_factor_ != factor_)
+  {
+    _build();
+    return;
+  }
+
+  // cells whose blocking flipped, pooled up as long as their parents flip too
+  std::vector<int> flipped;
+  for (int cell : changed)
+  {
+    const unsigned char occupancy = map_[cell] >= costmap_2d::LETHAL_OBSTACLE * factor_ ? BLOCKED : FREE;
+    if (occupancy != occupancy_[0][cell])
+    {
+      occupancy_[0][cell] = occupancy;
+      flipped.push_back(cell);
+    }
+  }
+
+  std::vector<int> parents;
+  for (int level = 1; level < levels_ && !flipped.empty(); level++)
+  {
+    parents.clear();
+    for (int i : flipped)
+      parents.push_back((i % nx_[level - 1] >> 1) + (i / nx_[level - 1] >> 1) * nx_[level]);
+    std::sort(parents.begin(), parents.end());
+    parents.erase(std::unique(parents.begin(), parents.end()), parents.end());
+
+    flipped.clear();
+    for (int i : parents)
+    {
+      const unsigned char occupancy = _pool(level, i);
+      if (occupancy != occupancy_[level][i])
+      {
+        occupancy_[level][i] = occupancy;
+        flipped.push_back(i);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Build the pyramid of the whole map
+ */
+void PyramidAStar::_build()
+{
+  nx_[0] = static_cast<int>(costmap_->getSizeInCellsX());
+  ny_[0] = static_cast<int>(costmap_->getSizeInCellsY());
+  occupancy_[0].resize(nx_[0] * ny_[0]);
+  for (int i = 0; i < nx_[0] * ny_[0]; i++)
+    occupancy_[0][i] = map_[i] >= costmap_2d::LETHAL_OBSTACLE * factor_ ? BLOCKED : FREE;
+
+  for (int level = 1; level < levels_; level++)
+  {
+    nx_[level] = (nx_[level - 1] + 1) / 2;
+    ny_[level] = (ny_[level - 1] + 1) / 2;
+    occupancy_[level].resize(nx_[level] * ny_[level]);
+    for (int i = 0; i < nx_[level] * ny_[level]; i++)
+      occupancy_[level][i] = _pool(level, i);
+  }
+
+  if (levels_ > 1)
+    corridor_.assign(nx_[1] * ny_[1], 0);
+  corridor_stamp_ = 0;
+  built_ = true;
+  built_factor_ = factor_;
+}
+
+/**
+ * @brief Pool a cell from its children on the level below
+ * @param level level of the cell, at least 1
+ * @param i     index of the cell on its level
+ * @return occupancy of the cell
+ */
+unsigned char PyramidAStar::_pool(int level, int i) const
+{
+  const std::vector<unsigned char>& below = occupancy_[level - 1];
+  const int nx = nx_[level - 1], ny = ny_[level - 1];
+  const int x = i % nx_[level] * 2, y = i / nx_[level] * 2;
+  const int c = x + y * nx;
+
+  unsigned char low = below[c], high = below[c];
+  auto pool = [&](int child) {
+    low = std::min(low, below[child]);
+    high = std::max(high, below[child]);
+  };
+  if (x + 1 < nx)
+    pool(c + 1);
+  if (y + 1 < ny)
+    pool(c + nx);
+  if (x + 1 < nx && y + 1 < ny)
+    pool(c + nx + 1);
+
+  return low == high ? low : static_cast<unsigned char>(MIXED);
+}
+
+/**
+ * @brief A* on one level of the pyramid
+ * @param level      level searched
+ * @param start      index of the start cell on the level
+ * @param goal       index of the goal cell on the level
+ * @param corridor   whether to search only the corridor around the path of the level above
+ * @param optimistic whether to search all cells not entirely blocked
+ * @param cells      path of cells on the level from goal to start
+ * @param expand     cells expanded are appended, at their corner on the map
+ * @return true if path found, else false
+ */
+bool PyramidAStar::_search(int level, int start, int goal, bool corridor, bool optimistic, std::vector<int>& cells,
+                           std::vector<Node>& expand)
+{
+  const int nx = nx_[level], ny = ny_[level];
+  const std::vector<unsigned char>& occupancy = occupancy_[level];
+  const double scale = static_cast<double>(1 << level);  // costs are in cells of the map
+  const int sx = start % nx, sy = start / nx;
+  const int gx = goal % nx, gy = goal / nx;
+  auto heuristics = [&](int x, int y) {
+    const int dx = std::abs(x - gx), dy = std::abs(y - gy);
+    return scale * (std::max(dx, dy) + (M_SQRT2 - 1.0) * std::min(dx, dy));
+  };
+
+  states_.reset(nx_[0], ny_[0]);
+  open_list_.clear();
+  states_.g(start) = 0.0;
+  open_list_.push(start, { heuristics(start % nx, start / nx), 0.0 });
+
+  while (!open_list_.empty())
+  {
+    const int u = open_list_.pop();
+    states_.tag(u) = GridStateTable::CLOSED;
+
+    const int x = u % nx, y = u / nx;
+    const double g = states_.g(u);
+    const int cell = (x << level) + (y << level) * nx_[0];
+    expand.emplace_back(x << level, y << level, g, 0.0, cell, cell);
+
+    if (u == goal)
+    {
+      cells.clear();
+      for (int i = goal; i >= 0; i = states_.parent(i))
+        cells.push_back(i);
+      return true;
+    }
+
+    for (int k = 0; k < 8; k++)
+    {
+      const int xn = x + kMotionX[k], yn = y + kMotionY[k];
+      if (xn < 0 || xn >= nx || yn < 0 || yn >= ny)
+        continue;
+
+      // start and goal may lie next to obstacles, the mixed cells around them are left to the finer levels
+      const int v = xn + yn * nx;
+      if (occupancy[v] == BLOCKED || states_.tag(v) == GridStateTable::CLOSED)
+        continue;
+      if (occupancy[v] == MIXED && !optimistic && std::max(std::abs(xn - sx), std::abs(yn - sy)) > mixed_radius_ &&
+          std::max(std::abs(xn - gx), std::abs(yn - gy)) > mixed_radius_)
+        continue;
+      if (corridor && corridor_[(xn >> 1) + (yn >> 1) * nx_[level + 1]] != corridor_stamp_)
+        continue;
+
+      const double g_new = g + scale * kMotionCost[k];
+      if (g_new < states_.g(v))
+      {
+        states_.g(v) = g_new;
+        states_.parent(v) = u;
+        open_list_.push(v, { g_new + heuristics(xn, yn), g_new });
+      }
+    }
+  }
+
+  return false;
+}
+
+/**
+ * @brief Mark the corridor around a path for the search of the level below
+ * @param level level of the path
+ * @param cells path of cells on the level
+ */
+void PyramidAStar::_markCorridor(int level, const std::vector<int>& cells)
+{
+  if (++corridor_stamp_ == 0)
+  {
+    std::fill(corridor_.begin(), corridor_.end(), 0);
+    corridor_stamp_ = 1;
+  }
+
+  const int nx = nx_[level], ny = ny_[level];
+  for (int i : cells)
+  {
+    const int x = i % nx, y = i / nx;
+    for (int yn = std::max(y - corridor_radius_, 0); yn <= std::min(y + corridor_radius_, ny - 1); yn++)
+      for (int xn = std::max(x - corridor_radius_, 0); xn <= std::min(x + corridor_radius_, nx - 1); xn++)
+        corridor_[xn + yn * nx] = corridor_stamp_;
+  }
+}
+}  // namespace global_planner
@@ -17,8 +17,10 @@
 #include <algorithm>
 #include <queue>
 #include <cmath>
+#include <limits>
 #include <unordered_set>
 
+#include "thread_pool.h"
 #include "voronoi.h"
 
 namespace global_planner
@@ -31,16 +33,6 @@ namespace global_planner
 VoronoiPlanner::VoronoiPlanner(costmap_2d::Costmap2D* costmap, double circumscribed_radius)
   : GlobalPlanner(costmap), circumscribed_radius_(circumscribed_radius)
 {
-  voronoi_diagram_ = new VoronoiData*[costmap_->getSizeInCellsX()];
-  for (unsigned int i = 0; i < costmap_->getSizeInCellsX(); i++)
-    voronoi_diagram_[i] = new VoronoiData[costmap_->getSizeInCellsY()];
-}
-
-VoronoiPlanner::~VoronoiPlanner()
-{
-  for (unsigned int i = 0; i < costmap_->getSizeInCellsX(); i++)
-    delete[] voronoi_diagram_[i];
-  delete[] voronoi_diagram_;
 }
 
 /**
@@ -55,35 +47,46 @@ bool VoronoiPlanner::plan(const Node& start, const Node& goal, std::vector<Node>
 {
   return true;
 }
-bool VoronoiPlanner::plan(const DynamicVoronoi& voronoi, const Node& start, const Node& goal, std::vector<Node>& path)
-{
-  // update voronoi diagram
-  for (unsigned int j = 0; j < costmap_->getSizeInCellsY(); j++)
-  {
-    for (unsigned int i = 0; i < costmap_->getSizeInCellsX(); i++)
-    {
-      voronoi_diagram_[i][j].dist = voronoi.getDistance(i, j) * costmap_->getResolution();
-      voronoi_diagram_[i][j].is_voronoi = voronoi.isVoronoi(i, j);
-    }
-  }
 
+/**
+ * @brief Voronoi-based planning implementation, reading the diagram and its skeleton graph in place. The caller
+ *        holds the buffer of the layer owning them for the whole call.
+ * @param voronoi       Voronoi diagram and distance map of the costmap
+ * @param skeleton      skeleton graph of the diagram
+ * @param start         start node
+ * @param goal          goal node
+ * @param path          optimal path consists of Node
+ * @return  true if path found, else false
+ */
+bool VoronoiPlanner::plan(const DynamicVoronoi& voronoi, const costmap_2d::VoronoiSkeleton& skeleton,
+                          const Node& start, const Node& goal, std::vector<Node>& path)
+{
   // clear vector
   path.clear();
 
+  // the layer has not built the diagram of this costmap yet
+  if (voronoi.getSizeX() != costmap_->getSizeInCellsX() || voronoi.getSizeY() != costmap_->getSizeInCellsY() ||
+      skeleton.getSizeX() != static_cast<int>(voronoi.getSizeX()) ||
+      skeleton.getSizeY() != static_cast<int>(voronoi.getSizeY()))
+    return false;
+
   // start/goal to Voronoi Diagram, shortest path in Voronoi Diagram
   std::vector<Node> path_s, path_g, path_v;
 
   // start/goal point in Voronoi Diagram
   Node v_start, v_goal;
 
-  if (!searchPathWithVoronoi(start, goal, path_s, &v_start))
-    return false;
-
-  if (!searchPathWithVoronoi(goal, start, path_g, &v_goal))
+  // the start and goal connections are independent, searched in parallel
+  bool found[2];
+  helper::ThreadPool::instance().parallelFor(2, [&](int i, int) {
+    found[i] = (i == 0) ? searchPathWithVoronoi(voronoi, start, goal, path_s, &v_start) :
+                          searchPathWithVoronoi(voronoi, goal, start, path_g, &v_goal);
+  });
+  if (!found[0] || !found[1])
     return false;
   std::reverse(path_g.begin(), path_g.end());
 
-  if (!searchPathWithVoronoi(v_start, v_goal, path_v))
+  if (!searchPathInSkeleton(voronoi, skeleton, v_start, v_goal, path_v))
     return false;
 
   path_g.insert(path_g.end(), path_v.begin(), path_v.end());
@@ -95,16 +98,21 @@ bool VoronoiPlanner::plan(const DynamicVoronoi& voronoi, const Node& start, cons
 
 /**
  * @brief search the shortest path from start to VD, or search the shortest path in VD
+ * @param voronoi       Voronoi diagram and distance map of the costmap
  * @param start         start node
  * @param goal          goal node
  * @param v_goal        the voronoi node in VD which is closest to start node
  * @param path          shortest path from start to VD
  * @return  true if path found, else false
  */
-bool VoronoiPlanner::searchPathWithVoronoi(const Node& start, const Node& goal, std::vector<Node>& path, Node* v_goal)
+bool VoronoiPlanner::searchPathWithVoronoi(const DynamicVoronoi& voronoi, const Node& start, const Node& goal,
+                                           std::vector<Node>& path, Node* v_goal)
 {
   path.clear();
 
+  // clearance threshold in cells, the distance map of the diagram is in cells
+  const double min_dist = circumscribed_radius_ / costmap_->getResolution();
+
   // open list and closed list
   std::priority_queue<Node, std::vector<Node>, Node::compare_cost> open_list;
   std::unordered_map<int, Node> closed_list;
@@ -127,7 +135,7 @@ bool VoronoiPlanner::searchPathWithVoronoi(const Node& start, const Node& goal,
     closed_list.insert(std::make_pair(current.id(), current));
 
     // goal found
-    if ((current == goal) || (v_goal == nullptr ? false : voronoi_diagram_[current.x()][current.y()].is_voronoi))
+    if ((current == goal) || (v_goal == nullptr ? false : voronoi.isVoronoi(current.x(), current.y())))
     {
       path = _convertClosedListToPath(closed_list, start, current);
       if (v_goal != nullptr)
@@ -154,11 +162,11 @@ bool VoronoiPlanner::searchPathWithVoronoi(const Node& start, const Node& goal,
 
       // next node hit the boundary or obstacle
       if ((node_new.id() < 0) || (node_new.id() >= map_size_) ||
-          (voronoi_diagram_[node_new.x()][node_new.y()].dist < circumscribed_radius_))
+          (voronoi.getDistance(node_new.x(), node_new.y()) < min_dist))
         continue;
 
       // search in VD
-      if ((v_goal == nullptr) && (!voronoi_diagram_[node_new.x()][node_new.y()].is_voronoi))
+      if ((v_goal == nullptr) && (!voronoi.isVoronoi(node_new.x(), node_new.y())))
         continue;
 
       node_new.set_h(helper::dist(node_new, goal));
@@ -168,4 +176,176 @@ bool VoronoiPlanner::searchPathWithVoronoi(const Node& start, const Node& goal,
   }
   return false;
 }
+
+/**
+ * @brief search the shortest path between two cells of VD over the skeleton graph, skipping edges without
+ *        enough clearance
+ * @param voronoi       Voronoi diagram and distance map of the costmap
+ * @param skeleton      skeleton graph of the diagram
+ * @param start         start node in VD
+ * @param goal          goal node in VD
+ * @param path          shortest path in VD, from goal to start
+ * @return  true if path found, else false
+ */
+bool VoronoiPlanner::searchPathInSkeleton(const DynamicVoronoi& voronoi, const costmap_2d::VoronoiSkeleton& skeleton,
+                                          const Node& start, const Node& goal, std::vector<Node>& path)
+{
+  using Edge = costmap_2d::VoronoiSkeleton::Edge;
+
+  path.clear();
+
+  const double min_dist = circumscribed_radius_ / costmap_->getResolution();
+  const auto& nodes = skeleton.nodes();
+  const auto& edges = skeleton.edges();
+  const int nx = static_cast<int>(costmap_->getSizeInCellsX());
+
+  // the cells of an edge from its from node (0) to its to node (cells.size() + 1)
+  auto cellOf = [&](const Edge& e, int i) {
+    if (i == 0)
+      return nodes[e.from].x + nodes[e.from].y * nx;
+    if (i == static_cast<int>(e.cells.size()) + 1)
+      return nodes[e.to].x + nodes[e.to].y * nx;
+    return e.cells[i - 1];
+  };
+
+  // a cell between two 8-adjacent cells is a staircase corner, which the path cuts as the edge lengths do
+  auto adjacent = [&](int a, int b) { return std::abs(a % nx - b % nx) <= 1 && std::abs(a / nx - b / nx) <= 1; };
+  auto stepLength = [&](int a, int b) { return (a % nx != b % nx && a / nx != b / nx) ? M_SQRT2 : 1.0; };
+
+  // length of the part [i, j] of an edge, negative if some cell lacks clearance
+  auto partLength = [&](const Edge& e, int i, int j) {
+    const int step = i < j ? 1 : -1;
+    double length = 0.0;
+    int k0 = -1, k1 = cellOf(e, i);
+    for (int k = i; k != j; k += step)
+    {
+      const int b = cellOf(e, k + step);
+      if (voronoi.getDistance(b % nx, b / nx) < min_dist)
+        return -1.0;
+      if (k0 != -1 && adjacent(k0, b))
+      {
+        length += stepLength(k0, b) - stepLength(k0, k1);
+      }
+      else
+      {
+        length += stepLength(k1, b);
+        k0 = k1;
+      }
+      k1 = b;
+    }
+    return voronoi.getDistance(cellOf(e, i) % nx, cellOf(e, i) / nx) < min_dist ? -1.0 : length;
+  };
+
+  // a cell of VD is either a node of the graph or lies on an edge, which is split there by a virtual node
+  struct Anchor
+  {
+    int node, edge, index;
+  };
+  auto locate = [&](const Node& n, int virtual_node) {
+    Anchor a{ skeleton.nodeAt(n.x(), n.y()), skeleton.edgeAt(n.x(), n.y()), 0 };
+    if (a.node == -1 && a.edge != -1)
+    {
+      const std::vector<int>& cells = edges[a.edge].cells;
+      a.node = virtual_node;
+      a.index = static_cast<int>(std::find(cells.begin(), cells.end(), grid2Index(n.x(), n.y())) - cells.begin()) + 1;
+    }
+    return a;
+  };
+
+  const int n_nodes = static_cast<int>(nodes.size());
+  const Anchor s = locate(start, n_nodes), g = locate(goal, n_nodes + 1);
+  if (s.node == -1 || g.node == -1)
+    return false;
+
+  // A* over the nodes and the two virtual ones, each hop records the part of an edge it follows
+  struct Hop
+  {
+    int from, edge, i, j;
+  };
+  std::vector<double> cost(n_nodes + 2, std::numeric_limits<double>::max());
+  std::vector<Hop> hop(n_nodes + 2, { -1, -1, 0, 0 });
+  std::vector<bool> closed(n_nodes + 2, false);
+  std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<std::pair<double, int>>>
+      open_list;
+
+  auto h = [&](int u) {
+    int cell = u == s.node ? grid2Index(start.x(), start.y()) : grid2Index(goal.x(), goal.y());
+    if (u < n_nodes)
+      cell = nodes[u].x + nodes[u].y * nx;
+    return std::hypot(cell % nx - goal.x(), cell / nx - goal.y());
+  };
+  auto relax = [&](int u, int v, int e, int i, int j, double length) {
+    if (length < 0.0 || cost[u] + length >= cost[v])
+      return;
+    cost[v] = cost[u] + length;
+    hop[v] = { u, e, i, j };
+    open_list.push({ cost[v] + h(v), v });
+  };
+
+  cost[s.node] = 0.0;
+  open_list.push({ h(s.node), s.node });
+  while (!open_list.empty())
+  {
+    const int u = open_list.top().second;
+    open_list.pop();
+    if (closed[u])
+      continue;
+    closed[u] = true;
+    if (u == g.node)
+      break;
+
+    if (u == n_nodes)
+    {
+      // virtual start, out to both ends of its edge or along it to the goal
+      const Edge& e = edges[s.edge];
+      const int end = static_cast<int>(e.cells.size()) + 1;
+      relax(u, e.from, s.edge, s.index, 0, partLength(e, s.index, 0));
+      relax(u, e.to, s.edge, s.index, end, partLength(e, s.index, end));
+      if (g.edge == s.edge && g.node == n_nodes + 1)
+        relax(u, g.node, s.edge, s.index, g.index, partLength(e, s.index, g.index));
+      continue;
+    }
+
+    for (const int k : nodes[u].edges)
+    {
+      const Edge& e = edges[k];
+      const int end = static_cast<int>(e.cells.size()) + 1;
+      if (e.from != e.to && e.clearance >= min_dist)
+      {
+        if (e.from == u)
+          relax(u, e.to, k, 0, end, e.length);
+        else
+          relax(u, e.from, k, end, 0, e.length);
+      }
+
+      // virtual goal on this edge
+      if (k == g.edge && g.node == n_nodes + 1)
+        relax(u, g.node, k, e.from == u ? 0 : end, g.index, partLength(e, e.from == u ? 0 : end, g.index));
+    }
+  }
+
+  if (!closed[g.node])
+    return false;
+
+  // cells of the hops from the goal back to the start, which is the order of the other searches
+  for (int v = g.node; v != s.node; v = hop[v].from)
+  {
+    const Hop& p = hop[v];
+    const int step = p.i < p.j ? 1 : -1;
+    for (int k = p.j; k != p.i; k -= step)
+    {
+      const int cell = cellOf(edges[p.edge], k);
+      if (path.size() > 1 && adjacent(path[path.size() - 2].id(), cell))
+        path.pop_back();
+      if (path.empty() || path.back().id() != cell)
+        path.emplace_back(cell % nx, cell / nx, 0, 0, cell, -1);
+    }
+  }
+  const int start_idx = grid2Index(start.x(), start.y());
+  if (path.size() > 1 && adjacent(path[path.size() - 2].id(), start_idx))
+    path.pop_back();
+  path.emplace_back(start.x(), start.y(), 0, 0, start_idx, -1);
+
+  return true;
+}
 }  // namespace global_planner
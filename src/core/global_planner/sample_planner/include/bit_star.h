@@ -0,0 +1,152 @@
+/**
+ * *********************************************************
+ *
+ * @file: bit_star.h
+ * @brief: Contains the Batch Informed Trees (BIT*) planner class
+ * @author: Yang Haodong
+ * @date: 2024-09-22
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#ifndef BIT_STAR_H
+#define BIT_STAR_H
+
+#include <queue>
+
+#include "rrt.h"
+#include "spatial_index.h"
+
+namespace global_planner
+{
+/**
+ * @brief Class for objects that plan using the BIT* algorithm.
+ *        Samples are added in batches and searched as an implicit random geometric graph in heuristic order,
+ *        edges are only collision checked when they could improve the current solution.
+ */
+class BITStar : public RRT
+{
+public:
+  /**
+   * @brief Construct a new BITStar object
+   * @param costmap    the environment for path planning
+   * @param sample_num andom sample points
+   * @param max_dist   max distance between sample points, i.e. the longest edge of the graph
+   * @param batch_size samples number of each batch
+   */
+  BITStar(costmap_2d::Costmap2D* costmap, int sample_num, double max_dist, int batch_size);
+
+  /**
+   * @brief BIT* implementation
+   * @param start  start node
+   * @param goal   goal node
+   * @param path   optimal path consists of Node
+   * @param expand containing the node been search during the process
+   * @return true if path found, else false
+   */
+  bool plan(const Node& start, const Node& goal, std::vector<Node>& path, std::vector<Node>& expand);
+
+protected:
+  /**
+   * @brief Sample or tree vertex of the implicit graph
+   */
+  struct BITNode
+  {
+    int x, y;                   // grid map coordinate
+    int id;                     // cell index
+    double g;                   // cost-to-come in the tree
+    int parent;                 // parent handle, -1 if none
+    std::vector<int> children;  // children handles
+    bool in_tree;               // tree vertex or sample
+    bool alive;                 // removed by pruning or not
+    bool is_new;                // added to the tree in the current batch
+  };
+
+  /**
+   * @brief Queue element, vertex queue uses target = -1
+   */
+  struct QueueItem
+  {
+    double key;
+    int source, target;
+    bool operator>(const QueueItem& other) const
+    {
+      return key > other.key;
+    }
+  };
+  using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+  /**
+   * @brief Add a sample to the implicit graph
+   * @param node sample node
+   * @return handle of the sample, -1 if the cell is already used
+   */
+  int _addSample(const Node& node);
+
+  /**
+   * @brief Sample a new batch in the free space or the informed ellipse
+   */
+  void _sampleBatch();
+
+  /**
+   * @brief Remove the samples and vertices which can not improve the current solution
+   */
+  void _prune();
+
+  /**
+   * @brief Expand a tree vertex into the edge queue
+   * @param v vertex handle
+   */
+  void _expandVertex(int v);
+
+  /**
+   * @brief Move a sample into the tree or rewire a vertex
+   * @param v parent handle
+   * @param x child handle
+   * @param cost edge cost
+   */
+  void _connect(int v, int x, double cost);
+
+  /**
+   * @brief Propagate a cost decrease to the subtree
+   * @param v root handle of the subtree
+   */
+  void _updateChildren(int v);
+
+  /**
+   * @brief Heuristic cost-to-come, cost-to-go and edge cost
+   */
+  double _gHat(int v) const;
+  double _hHat(int v) const;
+  double _cHat(int v, int x) const;
+
+  /**
+   * @brief Key of the top of the vertex or edge queue
+   */
+  double _bestVertexKey();
+  double _bestEdgeKey();
+
+  /**
+   * @brief Current best solution cost
+   */
+  double _cBest() const;
+
+protected:
+  int batch_size_;                             // samples number of each batch
+  double radius_;                              // connection radius of the current batch
+  std::vector<BITNode> nodes_;                 // samples and vertices
+  std::unordered_map<int, int> cell_to_node_;  // cell index -> handle
+  int start_h_, goal_h_;                       // start and goal handle
+  SpatialIndex samples_;                       // spatial index of samples
+  SpatialIndex tree_;                          // spatial index of tree vertices
+  Queue vertex_queue_;                         // vertex expansion queue
+  Queue edge_queue_;                           // edge evaluation queue
+  std::vector<int> near_;                      // neighbour query buffer
+};
+}  // namespace global_planner
+#endif  // BIT_STAR_H
@@ -0,0 +1,246 @@
+/**
+ * *********************************************************
+ *
+ * @file: free_space_sampler.h
+ * @brief: Sampler drawing only from free cells of the costmap, with optional low-discrepancy sequences
+ * @author: Yang Haodong
+ * @date: 2024-09-20
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#ifndef FREE_SPACE_SAMPLER_H
+#define FREE_SPACE_SAMPLER_H
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <costmap_2d/cost_values.h>
+#include <costmap_2d/costmap_2d.h>
+
+#include "nodes.h"
+
+namespace global_planner
+{
+/**
+ * @brief Sampling statistics of a single planning query
+ */
+struct SampleStats
+{
+  int drawn = 0;                                // number of samples drawn
+  int wasted = 0;                               // samples rejected by the planner (collision, duplicated, ...)
+  double first_solution_t = -1.0;               // time to first solution in seconds, -1 if no solution
+  int first_solution_iter = -1;                 // samples drawn before first solution, -1 if no solution
+  std::chrono::steady_clock::time_point start;  // query start time
+
+  /**
+   * @brief Fraction of drawn samples that were wasted
+   * @return wasted / drawn, 0 if nothing drawn
+   */
+  double wastedRatio() const
+  {
+    return drawn > 0 ? static_cast<double>(wasted) / drawn : 0.0;
+  }
+};
+
+/**
+ * @brief Draws cells uniformly from the free space of the costmap.
+ *        The free cells are stored compactly in row-major order and only rebuilt when the costmap changes,
+ *        so no sample ever lands in lethal or unknown space.
+ */
+class FreeSpaceSampler
+{
+public:
+  /**
+   * @brief Source of the (u, v) numbers in [0, 1)^2 mapped to free cells
+   */
+  enum class Sequence
+  {
+    UNIFORM = 0,  // pseudo random numbers
+    HALTON = 1,   // Halton sequence with bases (2, 3)
+    SOBOL = 2     // 2D Sobol sequence
+  };
+
+  /**
+   * @brief Construct a new Free Space Sampler object
+   * @param costmap the environment for path planning
+   */
+  FreeSpaceSampler(costmap_2d::Costmap2D* costmap);
+
+  /**
+   * @brief Set the obstacle factor, cells with cost >= LETHAL_OBSTACLE * factor are not sampled
+   * @param factor obstacle factor
+   */
+  void setFactor(float factor);
+
+  /**
+   * @brief Set the source sequence of samples
+   * @param sequence sample sequence
+   */
+  void setSequence(Sequence sequence);
+
+  /**
+   * @brief Parse the sequence name, i.e. "uniform", "halton" or "sobol"
+   * @param name     sequence name
+   * @param sequence parsed sequence
+   * @return true if the name is known, else false
+   */
+  static bool parseSequence(const std::string& name, Sequence& sequence);
+
+  /**
+   * @brief Prepare a new planning query: rebuild the free-cell index if the costmap changed and reset statistics
+   * @return true if the free-cell index was rebuilt
+   */
+  bool reset();
+
+  /**
+   * @brief Draw a free cell uniformly from the whole map
+   * @param node sampled node (id = -1 if there is no free cell)
+   * @return true if successful, else false
+   */
+  bool sample(Node& node);
+
+  /**
+   * @brief Draw a free cell uniformly from the informed ellipse with foci start and goal
+   * @param start  start node (focus)
+   * @param goal   goal node (focus)
+   * @param c_best major axis length, i.e. the best cost so far
+   * @param node   sampled node (id = -1 if there is no free cell in the ellipse)
+   * @return true if successful, else false
+   */
+  bool sampleEllipse(const Node& start, const Node& goal, double c_best, Node& node);
+
+  /**
+   * @brief Draw a pseudo random number in [0, 1) from the internal engine
+   * @return random number
+   */
+  double uniform();
+
+  /**
+   * @brief Judge whether a cell is free
+   * @param x grid map x
+   * @param y grid map y
+   * @return true if free, else false
+   */
+  bool isFree(int x, int y) const;
+
+  /**
+   * @brief Record a sample drawn outside the sampler, e.g. the goal bias
+   */
+  void biased();
+
+  /**
+   * @brief Record a sample rejected by the planner
+   */
+  void reject();
+
+  /**
+   * @brief Record a feasible solution, only the first one of each query is kept
+   */
+  void solutionFound();
+
+  /**
+   * @brief Get the statistics of the current query
+   * @return sample statistics
+   */
+  const SampleStats& stats() const;
+
+  /**
+   * @brief Get the number of free cells in the index
+   * @return free cells number
+   */
+  int freeCellsNum() const;
+
+protected:
+  /**
+   * @brief A set of row-wise runs in the sorted free-cell index, sampled in proportion to their size
+   */
+  struct Region
+  {
+    std::vector<int> begin;  // first position of each run in free_cells_
+    std::vector<int> acc;    // accumulated cells number up to and including each run
+    int total = 0;           // total cells number
+
+    void clear()
+    {
+      begin.clear();
+      acc.clear();
+      total = 0;
+    }
+
+    void push(int b, int n)
+    {
+      if (n <= 0)
+        return;
+      total += n;
+      begin.push_back(b);
+      acc.push_back(total);
+    }
+  };
+
+  /**
+   * @brief Hash of the costmap passability used to detect changes
+   * @return hash value
+   */
+  uint64_t _passabilityHash() const;
+
+  /**
+   * @brief Rebuild the free-cell index
+   */
+  void _rebuild();
+
+  /**
+   * @brief Next point of the configured sequence
+   * @param u first coordinate in [0, 1)
+   * @param v second coordinate in [0, 1)
+   */
+  void _next(double& u, double& v);
+
+  /**
+   * @brief Map (u, v) to a cell of the region: u selects the run, v the cell inside the run
+   * @param region sampling region
+   * @param u      first coordinate in [0, 1)
+   * @param v      second coordinate in [0, 1)
+   * @return cell index in costmap
+   */
+  int _pick(const Region& region, double u, double v) const;
+
+  /**
+   * @brief Build the runs of free cells inside the ellipse
+   * @param start  start node (focus)
+   * @param goal   goal node (focus)
+   * @param c_best major axis length
+   */
+  void _buildEllipse(const Node& start, const Node& goal, double c_best);
+
+protected:
+  costmap_2d::Costmap2D* costmap_;  // costmap buffer
+  float factor_;                    // obstacle factor
+  Sequence sequence_;               // sample sequence
+
+  int nx_, ny_;                  // costmap size in cells
+  uint64_t hash_;                // passability hash of the indexed costmap
+  bool valid_;                   // whether the index has been built
+  std::vector<int> free_cells_;  // free cells index, row-major sorted
+  std::vector<int> row_begin_;   // first position of each row in free_cells_, size ny_ + 1
+  Region map_region_;            // whole free space
+
+  Region ellipse_region_;             // free space inside the last informed ellipse
+  int ellipse_start_, ellipse_goal_;  // foci of the last informed ellipse
+  double ellipse_c_best_;             // major axis length of the last informed ellipse
+
+  std::mt19937 eng_;          // pseudo random engine
+  uint32_t seq_index_;        // index in low-discrepancy sequence
+  double shift_u_, shift_v_;  // random shift of low-discrepancy sequence in each query
+  SampleStats stats_;         // statistics of the current query
+};
+}  // namespace global_planner
+#endif  // FREE_SPACE_SAMPLER_H
@@ -18,6 +18,7 @@
 #define QUICK_INFORMED_RRT_H
 
 #include "informed_rrt.h"
+#include "spatial_index.h"
 
 namespace global_planner
 {
@@ -65,7 +66,13 @@ protected:
    * @param node sample node
    * @return nearest node
    */
-  Node _findNearestPoint(std::unordered_map<int, Node> list, Node& node);
+  Node _findNearestPoint(std::unordered_map<int, Node>& list, Node& node);
+
+  /**
+   * @brief Add a node to the sample list and the spatial index
+   * @param node sample node
+   */
+  void _addSample(const Node& node);
 
 protected:
   int n_threads_;     // parallel rewire process
@@ -73,6 +80,11 @@ protected:
   double d_extend_;   // increased distance of adaptive extend step size
   double max_dist_;   // recover value of max_dist_ when met obstacle
   double t_freedom_;  // freedom of t distribution
+
+  SpatialIndex index_;             // spatial index of sample list
+  std::vector<int> near_;          // neighbours inside the optimization circle
+  std::vector<double> near_dist_;  // distance to each neighbour
+  std::vector<char> near_free_;    // whether the edge to each neighbour is collision free
 };
 }  // namespace global_planner
 #endif  // QUICK_INFORMED_RRT_H
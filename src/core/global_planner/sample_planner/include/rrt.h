@@ -18,6 +18,8 @@
 #define RRT_H
 
 #include "global_planner.h"
+#include "free_space_sampler.h"
+#include "footprint_checker.h"
 
 namespace global_planner
 {
@@ -45,7 +47,31 @@ public:
    */
   bool plan(const Node& start, const Node& goal, std::vector<Node>& path, std::vector<Node>& expand);
 
+  /**
+   * @brief Set the source sequence of the free-space sampler
+   * @param sequence sample sequence
+   */
+  void setSampleSequence(FreeSpaceSampler::Sequence sequence);
+
+  /**
+   * @brief Check collisions with the robot footprint along the edges, besides the centre cell against the inflated
+   *        costmap
+   * @param footprint footprint vertices in the robot frame in meters, empty to check the centre cell only
+   */
+  void setFootprint(const std::vector<std::pair<double, double>>& footprint);
+
+  /**
+   * @brief Get the sampling statistics of the last planning query
+   * @return sample statistics
+   */
+  const SampleStats& getSampleStats() const;
+
 protected:
+  /**
+   * @brief Prepare the free-space sampler and the footprint checker for a new query, both follow the costmap
+   */
+  void _resetSampler();
+
   /**
    * @brief Regular the new node by the nearest node in the sample list
    * @param list sample list
@@ -76,11 +102,13 @@ protected:
   bool _checkGoal(const Node& new_node);
 
 protected:
-  Node start_, goal_;                          // start and goal node copy
-  std::unordered_map<int, Node> sample_list_;  // set of sample nodes
-  int sample_num_;                             // max sample number
-  double max_dist_;                            // max distance threshold
-  double opti_sample_p_ = 0.05;                // optimized sample probability, default to 0.05
+  Node start_, goal_;                           // start and goal node copy
+  std::unordered_map<int, Node> sample_list_;   // set of sample nodes
+  int sample_num_;                              // max sample number
+  double max_dist_;                             // max distance threshold
+  double opti_sample_p_ = 0.05;                 // optimized sample probability, default to 0.05
+  FreeSpaceSampler sampler_;                    // free-space sampler
+  helper::FootprintChecker footprint_checker_;  // footprint collision checker, if a footprint is set
 };
 }  // namespace global_planner
 #endif  // RRT_H
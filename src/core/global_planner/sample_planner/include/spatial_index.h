@@ -0,0 +1,114 @@
+/**
+ * *********************************************************
+ *
+ * @file: spatial_index.h
+ * @brief: Uniform bucket grid for nearest and radius queries over sample points
+ * @author: Yang Haodong
+ * @date: 2024-09-22
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <vector>
+
+namespace global_planner
+{
+/**
+ * @brief Uniform bucket grid over the costmap storing (handle, x, y) entries.
+ *        Insertion and removal are O(1), radius queries only visit the buckets overlapping the query circle.
+ */
+class SpatialIndex
+{
+public:
+  /**
+   * @brief Construct a new Spatial Index object
+   * @param nx          costmap size in cells along x
+   * @param ny          costmap size in cells along y
+   * @param bucket_size bucket edge length in cells
+   */
+  SpatialIndex(int nx = 0, int ny = 0, double bucket_size = 1.0);
+
+  /**
+   * @brief Reset the grid geometry, all entries are removed
+   * @param nx          costmap size in cells along x
+   * @param ny          costmap size in cells along y
+   * @param bucket_size bucket edge length in cells
+   */
+  void reset(int nx, int ny, double bucket_size);
+
+  /**
+   * @brief Remove all entries while keeping the geometry and the allocated buckets
+   */
+  void clear();
+
+  /**
+   * @brief Insert an entry
+   * @param handle user defined handle, e.g. the node id
+   * @param x      grid map x
+   * @param y      grid map y
+   */
+  void insert(int handle, int x, int y);
+
+  /**
+   * @brief Remove an entry
+   * @param handle handle of the entry
+   * @param x      grid map x the entry was inserted with
+   * @param y      grid map y the entry was inserted with
+   * @return true if the entry was found, else false
+   */
+  bool remove(int handle, int x, int y);
+
+  /**
+   * @brief Find the nearest entry
+   * @param x        query grid map x
+   * @param y        query grid map y
+   * @param min_dist distance to the nearest entry (optional)
+   * @return handle of the nearest entry, -1 if empty
+   */
+  int nearest(int x, int y, double* min_dist = nullptr) const;
+
+  /**
+   * @brief Find all entries inside the circle
+   * @param x       query grid map x
+   * @param y       query grid map y
+   * @param r       query radius in cells
+   * @param handles handles of the entries inside the circle, appended
+   */
+  void radius(int x, int y, double r, std::vector<int>& handles) const;
+
+  /**
+   * @brief Get the number of entries
+   * @return entries number
+   */
+  int size() const;
+
+protected:
+  struct Entry
+  {
+    int handle;
+    int x, y;
+  };
+
+  /**
+   * @brief Bucket coordinate of a cell coordinate, clamped into the grid
+   */
+  int _bucketX(int x) const;
+  int _bucketY(int y) const;
+
+protected:
+  int bx_, by_;                              // buckets number along x and y
+  double bucket_size_;                       // bucket edge length in cells
+  int size_;                                 // entries number
+  std::vector<std::vector<Entry>> buckets_;  // entries of each bucket
+  std::vector<int> used_;                    // buckets which may be non-empty, for fast clearing
+};
+}  // namespace global_planner
+#endif  // SPATIAL_INDEX_H
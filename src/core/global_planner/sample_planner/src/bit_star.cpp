@@ -0,0 +1,403 @@
+/**
+ * *********************************************************
+ *
+ * @file: bit_star.cpp
+ * @brief: Contains the Batch Informed Trees (BIT*) planner class
+ * @author: Yang Haodong
+ * @date: 2024-09-22
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#include <algorithm>
+#include <limits>
+
+#include "bit_star.h"
+
+namespace global_planner
+{
+namespace
+{
+constexpr double kInf = std::numeric_limits<double>::max();
+}  // namespace
+
+/**
+ * @brief Construct a new BITStar object
+ * @param costmap    the environment for path planning
+ * @param sample_num andom sample points
+ * @param max_dist   max distance between sample points, i.e. the longest edge of the graph
+ * @param batch_size samples number of each batch
+ */
+BITStar::BITStar(costmap_2d::Costmap2D* costmap, int sample_num, double max_dist, int batch_size)
+  : RRT(costmap, sample_num, max_dist)
+  , batch_size_(std::max(batch_size, 1))
+  , radius_(max_dist)
+  , start_h_(-1)
+  , goal_h_(-1)
+{
+}
+
+/**
+ * @brief BIT* implementation
+ * @param start  start node
+ * @param goal   goal node
+ * @param path   optimal path consists of Node
+ * @param expand containing the node been search during the process
+ * @return true if path found, else false
+ */
+bool BITStar::plan(const Node& start, const Node& goal, std::vector<Node>& path, std::vector<Node>& expand)
+{
+  // clear vector
+  path.clear();
+  expand.clear();
+  nodes_.clear();
+  cell_to_node_.clear();
+  vertex_queue_ = Queue();
+  edge_queue_ = Queue();
+
+  // free-space index and footprint bitmap are only rebuilt if the costmap changed
+  _resetSampler();
+
+  // buckets as large as the longest edge, so a radius query visits at most 3 x 3 buckets
+  const int nx = static_cast<int>(costmap_->getSizeInCellsX());
+  const int ny = static_cast<int>(costmap_->getSizeInCellsY());
+  samples_.reset(nx, ny, max_dist_);
+  tree_.reset(nx, ny, max_dist_);
+
+  // copy
+  start_ = start, goal_ = goal;
+  start_h_ = _addSample(start);
+  samples_.remove(start_h_, start.x(), start.y());
+  tree_.insert(start_h_, start.x(), start.y());
+  nodes_[start_h_].g = 0.0;
+  nodes_[start_h_].in_tree = true;
+  goal_h_ = _addSample(goal);
+  if (goal_h_ == -1)
+    goal_h_ = start_h_;
+
+  // main loop
+  int sampled = 0;
+  while (true)
+  {
+    // a batch is finished, prune the graph and add a new one
+    if (vertex_queue_.empty() && edge_queue_.empty())
+    {
+      if (sampled >= sample_num_)
+        break;
+
+      _prune();
+      _sampleBatch();
+      sampled += batch_size_;
+
+      for (size_t i = 0; i < nodes_.size(); i++)
+      {
+        auto& v = nodes_[i];
+        if (v.alive && v.in_tree)
+        {
+          v.is_new = false;
+          vertex_queue_.push({ v.g + _hHat(i), static_cast<int>(i), -1 });
+        }
+      }
+    }
+
+    // expand vertices which may lead to better edges than the queued ones
+    while (!vertex_queue_.empty() && _bestVertexKey() <= _bestEdgeKey())
+    {
+      int v = vertex_queue_.top().source;
+      vertex_queue_.pop();
+      if (nodes_[v].alive && nodes_[v].in_tree)
+        _expandVertex(v);
+    }
+
+    if (edge_queue_.empty())
+      continue;
+
+    QueueItem edge = edge_queue_.top();
+    edge_queue_.pop();
+    const int v = edge.source, x = edge.target;
+    if (!nodes_[v].alive || !nodes_[v].in_tree || !nodes_[x].alive)
+      continue;
+
+    const double c_hat = _cHat(v, x);
+    if (nodes_[v].g + c_hat + _hHat(x) < _cBest())
+    {
+      // lazy evaluation: cheap bounds first, collision check last
+      if (_gHat(v) + c_hat + _hHat(x) >= _cBest() || nodes_[v].g + c_hat >= nodes_[x].g)
+        continue;
+
+      Node n1(nodes_[v].x, nodes_[v].y, 0, 0, nodes_[v].id, -1);
+      Node n2(nodes_[x].x, nodes_[x].y, 0, 0, nodes_[x].id, -1);
+      if (_isAnyObstacleInPath(n1, n2))
+        continue;
+
+      const bool improved = (x == goal_h_);
+      _connect(v, x, c_hat);
+      if (improved)
+        sampler_.solutionFound();
+    }
+    else
+    {
+      // no queued edge can improve the solution any more
+      vertex_queue_ = Queue();
+      edge_queue_ = Queue();
+    }
+  }
+
+  // tree
+  std::unordered_map<int, Node> closed_list;
+  for (const auto& v : nodes_)
+  {
+    if (!v.alive || !v.in_tree)
+      continue;
+    Node n(v.x, v.y, v.g, 0, v.id, v.parent == -1 ? -1 : nodes_[v.parent].id);
+    closed_list.insert(std::make_pair(n.id(), n));
+    expand.push_back(n);
+  }
+
+  if (nodes_[goal_h_].in_tree)
+  {
+    path = _convertClosedListToPath(closed_list, start, goal);
+    return !path.empty();
+  }
+
+  return false;
+}
+
+/**
+ * @brief Add a sample to the implicit graph
+ * @param node sample node
+ * @return handle of the sample, -1 if the cell is already used
+ */
+int BITStar::_addSample(const Node& node)
+{
+  if (cell_to_node_.count(node.id()))
+    return -1;
+
+  const int h = static_cast<int>(nodes_.size());
+  nodes_.push_back({ node.x(), node.y(), node.id(), kInf, -1, {}, false, true, false });
+  cell_to_node_.insert(std::make_pair(node.id(), h));
+  samples_.insert(h, node.x(), node.y());
+
+  return h;
+}
+
+/**
+ * @brief Sample a new batch in the free space or the informed ellipse
+ */
+void BITStar::_sampleBatch()
+{
+  const double c_best = _cBest();
+  for (int i = 0; i < batch_size_; i++)
+  {
+    Node node;
+    bool valid = c_best < kInf ? sampler_.sampleEllipse(start_, goal_, c_best, node) : false;
+    if (!valid && !sampler_.sample(node))
+      break;
+
+    if (_addSample(node) == -1)
+      sampler_.reject();
+  }
+
+  // connection radius of the random geometric graph in 2D
+  const int q = std::max(tree_.size() + samples_.size(), 2);
+  const double area = static_cast<double>(sampler_.freeCellsNum());
+  const double r_rgg = 2.0 * std::sqrt(1.5 * area / M_PI * std::log(static_cast<double>(q)) / q);
+  radius_ = std::min(max_dist_, r_rgg);
+}
+
+/**
+ * @brief Remove the samples and vertices which can not improve the current solution
+ */
+void BITStar::_prune()
+{
+  const double c_best = _cBest();
+  if (c_best == kInf)
+    return;
+
+  auto f_hat = [&](int h) { return _gHat(h) + _hHat(h); };
+
+  // keep the subtree of vertices which may improve the solution
+  std::vector<int> stack{ start_h_ };
+  std::vector<char> keep(nodes_.size(), 0);
+  keep[start_h_] = 1;
+  while (!stack.empty())
+  {
+    int v = stack.back();
+    stack.pop_back();
+    auto& children = nodes_[v].children;
+    children.erase(std::remove_if(children.begin(), children.end(), [&](int c) { return f_hat(c) > c_best + 1e-6; }),
+                   children.end());
+    for (int c : children)
+    {
+      keep[c] = 1;
+      stack.push_back(c);
+    }
+  }
+
+  for (size_t i = 0; i < nodes_.size(); i++)
+  {
+    auto& n = nodes_[i];
+    if (!n.alive)
+      continue;
+
+    if (n.in_tree)
+    {
+      if (keep[i])
+        continue;
+
+      // disconnected vertices that may still be useful are recycled as samples
+      tree_.remove(i, n.x, n.y);
+      n.in_tree = false;
+      n.parent = -1;
+      n.children.clear();
+      n.g = kInf;
+      if (f_hat(i) < c_best)
+      {
+        samples_.insert(i, n.x, n.y);
+        continue;
+      }
+    }
+    else
+    {
+      if (f_hat(i) < c_best)
+        continue;
+      samples_.remove(i, n.x, n.y);
+      sampler_.reject();
+    }
+
+    n.alive = false;
+    cell_to_node_.erase(n.id);
+  }
+}
+
+/**
+ * @brief Expand a tree vertex into the edge queue
+ * @param v vertex handle
+ */
+void BITStar::_expandVertex(int v)
+{
+  const auto& nv = nodes_[v];
+  const double c_best = _cBest();
+
+  // edges to samples
+  near_.clear();
+  samples_.radius(nv.x, nv.y, radius_, near_);
+  for (int x : near_)
+  {
+    const double c_hat = _cHat(v, x);
+    if (_gHat(v) + c_hat + _hHat(x) < c_best)
+      edge_queue_.push({ nv.g + c_hat + _hHat(x), v, x });
+  }
+
+  // rewiring edges to vertices, only for vertices added in this batch
+  if (nv.is_new)
+  {
+    near_.clear();
+    tree_.radius(nv.x, nv.y, radius_, near_);
+    for (int w : near_)
+    {
+      if (w == v || nv.parent == w || nodes_[w].parent == v)
+        continue;
+      const double c_hat = _cHat(v, w);
+      if (_gHat(v) + c_hat + _hHat(w) < c_best && nv.g + c_hat < nodes_[w].g)
+        edge_queue_.push({ nv.g + c_hat + _hHat(w), v, w });
+    }
+  }
+}
+
+/**
+ * @brief Move a sample into the tree or rewire a vertex
+ * @param v parent handle
+ * @param x child handle
+ * @param cost edge cost
+ */
+void BITStar::_connect(int v, int x, double cost)
+{
+  auto& nx = nodes_[x];
+  const bool rewire = nx.in_tree;
+  if (rewire)
+  {
+    // rewire
+    auto& siblings = nodes_[nx.parent].children;
+    siblings.erase(std::remove(siblings.begin(), siblings.end(), x), siblings.end());
+  }
+  else
+  {
+    samples_.remove(x, nx.x, nx.y);
+    tree_.insert(x, nx.x, nx.y);
+    nx.in_tree = true;
+    nx.is_new = true;
+  }
+
+  nx.parent = v;
+  nx.g = nodes_[v].g + cost;
+  nodes_[v].children.push_back(x);
+  _updateChildren(x);
+
+  if (!rewire)
+    vertex_queue_.push({ nx.g + _hHat(x), x, -1 });
+}
+
+/**
+ * @brief Propagate a cost decrease to the subtree
+ * @param v root handle of the subtree
+ */
+void BITStar::_updateChildren(int v)
+{
+  std::vector<int> stack{ v };
+  while (!stack.empty())
+  {
+    int p = stack.back();
+    stack.pop_back();
+    for (int c : nodes_[p].children)
+    {
+      nodes_[c].g = nodes_[p].g + _cHat(p, c);
+      stack.push_back(c);
+    }
+  }
+}
+
+/**
+ * @brief Heuristic cost-to-come, cost-to-go and edge cost
+ */
+double BITStar::_gHat(int v) const
+{
+  return std::hypot(nodes_[v].x - start_.x(), nodes_[v].y - start_.y());
+}
+
+double BITStar::_hHat(int v) const
+{
+  return std::hypot(nodes_[v].x - goal_.x(), nodes_[v].y - goal_.y());
+}
+
+double BITStar::_cHat(int v, int x) const
+{
+  return std::hypot(nodes_[v].x - nodes_[x].x, nodes_[v].y - nodes_[x].y);
+}
+
+/**
+ * @brief Key of the top of the vertex or edge queue
+ */
+double BITStar::_bestVertexKey()
+{
+  return vertex_queue_.empty() ? kInf : vertex_queue_.top().key;
+}
+
+double BITStar::_bestEdgeKey()
+{
+  return edge_queue_.empty() ? kInf : edge_queue_.top().key;
+}
+
+/**
+ * @brief Current best solution cost
+ */
+double BITStar::_cBest() const
+{
+  return nodes_[goal_h_].in_tree ? nodes_[goal_h_].g : kInf;
+}
+}  // namespace global_planner
@@ -0,0 +1,417 @@
+/**
+ * *********************************************************
+ *
+ * @file: free_space_sampler.cpp
+ * @brief: Sampler drawing only from free cells of the costmap, with optional low-discrepancy sequences
+ * @author: Yang Haodong
+ * @date: 2024-09-20
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "free_space_sampler.h"
+
+namespace global_planner
+{
+namespace
+{
+/**
+ * @brief Radical inverse of i in the given base, i.e. the i-th element of the van der Corput sequence
+ */
+double radicalInverse(uint32_t i, uint32_t base)
+{
+  double inv_base = 1.0 / base, f = inv_base, r = 0.0;
+  while (i > 0)
+  {
+    r += f * (i % base);
+    i /= base;
+    f *= inv_base;
+  }
+  return r;
+}
+
+/**
+ * @brief Second dimension of the Sobol sequence (primitive polynomial x + 1)
+ */
+double sobol2(uint32_t i)
+{
+  uint32_t v = 1u << 31, x = 0;
+  for (; i > 0; i >>= 1, v ^= v >> 1)
+    if (i & 1u)
+      x ^= v;
+  return x * (1.0 / 4294967296.0);
+}
+}  // namespace
+
+/**
+ * @brief Construct a new Free Space Sampler object
+ * @param costmap the environment for path planning
+ */
+FreeSpaceSampler::FreeSpaceSampler(costmap_2d::Costmap2D* costmap)
+  : costmap_(costmap)
+  , factor_(0.5f)
+  , sequence_(Sequence::UNIFORM)
+  , nx_(0)
+  , ny_(0)
+  , hash_(0)
+  , valid_(false)
+  , ellipse_start_(-1)
+  , ellipse_goal_(-1)
+  , ellipse_c_best_(-1.0)
+  , eng_(std::random_device{}())
+  , seq_index_(0)
+  , shift_u_(0.0)
+  , shift_v_(0.0)
+{
+}
+
+/**
+ * @brief Set the obstacle factor, cells with cost >= LETHAL_OBSTACLE * factor are not sampled
+ * @param factor obstacle factor
+ */
+void FreeSpaceSampler::setFactor(float factor)
+{
+  if (factor != factor_)
+    valid_ = false;
+  factor_ = factor;
+}
+
+/**
+ * @brief Set the source sequence of samples
+ * @param sequence sample sequence
+ */
+void FreeSpaceSampler::setSequence(Sequence sequence)
+{
+  sequence_ = sequence;
+}
+
+/**
+ * @brief Parse the sequence name, i.e. "uniform", "halton" or "sobol"
+ * @param name     sequence name
+ * @param sequence parsed sequence
+ * @return true if the name is known, else false
+ */
+bool FreeSpaceSampler::parseSequence(const std::string& name, Sequence& sequence)
+{
+  if (name == "uniform")
+    sequence = Sequence::UNIFORM;
+  else if (name == "halton")
+    sequence = Sequence::HALTON;
+  else if (name == "sobol")
+    sequence = Sequence::SOBOL;
+  else
+    return false;
+  return true;
+}
+
+/**
+ * @brief Prepare a new planning query: rebuild the free-cell index if the costmap changed and reset statistics
+ * @return true if the free-cell index was rebuilt
+ */
+bool FreeSpaceSampler::reset()
+{
+  bool rebuilt = false;
+  uint64_t hash = _passabilityHash();
+  if (!valid_ || hash != hash_ || nx_ != static_cast<int>(costmap_->getSizeInCellsX()) ||
+      ny_ != static_cast<int>(costmap_->getSizeInCellsY()))
+  {
+    _rebuild();
+    hash_ = hash;
+    rebuilt = true;
+  }
+
+  // randomly shifted low-discrepancy sequence, so repeated queries do not reuse the same points
+  seq_index_ = 0;
+  shift_u_ = uniform();
+  shift_v_ = uniform();
+
+  stats_ = SampleStats();
+  stats_.start = std::chrono::steady_clock::now();
+
+  return rebuilt;
+}
+
+/**
+ * @brief Draw a free cell uniformly from the whole map
+ * @param node sampled node (id = -1 if there is no free cell)
+ * @return true if successful, else false
+ */
+bool FreeSpaceSampler::sample(Node& node)
+{
+  if (map_region_.total == 0)
+  {
+    node.set_id(-1);
+    return false;
+  }
+
+  double u, v;
+  _next(u, v);
+  int id = _pick(map_region_, u, v);
+  node = Node(id % nx_, id / nx_, 0, 0, id, -1);
+  stats_.drawn++;
+
+  return true;
+}
+
+/**
+ * @brief Draw a free cell uniformly from the informed ellipse with foci start and goal
+ * @param start  start node (focus)
+ * @param goal   goal node (focus)
+ * @param c_best major axis length, i.e. the best cost so far
+ * @param node   sampled node (id = -1 if there is no free cell in the ellipse)
+ * @return true if successful, else false
+ */
+bool FreeSpaceSampler::sampleEllipse(const Node& start, const Node& goal, double c_best, Node& node)
+{
+  if (start.id() != ellipse_start_ || goal.id() != ellipse_goal_ || c_best != ellipse_c_best_)
+    _buildEllipse(start, goal, c_best);
+
+  if (ellipse_region_.total == 0)
+  {
+    node.set_id(-1);
+    return false;
+  }
+
+  double u, v;
+  _next(u, v);
+  int id = _pick(ellipse_region_, u, v);
+  node = Node(id % nx_, id / nx_, 0, 0, id, -1);
+  stats_.drawn++;
+
+  return true;
+}
+
+/**
+ * @brief Draw a pseudo random number in [0, 1) from the internal engine
+ * @return random number
+ */
+double FreeSpaceSampler::uniform()
+{
+  return std::uniform_real_distribution<double>(0.0, 1.0)(eng_);
+}
+
+/**
+ * @brief Judge whether a cell is free
+ * @param x grid map x
+ * @param y grid map y
+ * @return true if free, else false
+ */
+bool FreeSpaceSampler::isFree(int x, int y) const
+{
+  if (x < 0 || y < 0 || x >= nx_ || y >= ny_)
+    return false;
+  return costmap_->getCharMap()[y * nx_ + x] < costmap_2d::LETHAL_OBSTACLE * factor_;
+}
+
+/**
+ * @brief Record a sample drawn outside the sampler, e.g. the goal bias
+ */
+void FreeSpaceSampler::biased()
+{
+  stats_.drawn++;
+}
+
+/**
+ * @brief Record a sample rejected by the planner
+ */
+void FreeSpaceSampler::reject()
+{
+  stats_.wasted++;
+}
+
+/**
+ * @brief Record a feasible solution, only the first one of each query is kept
+ */
+void FreeSpaceSampler::solutionFound()
+{
+  if (stats_.first_solution_iter >= 0)
+    return;
+  stats_.first_solution_iter = stats_.drawn;
+  stats_.first_solution_t =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - stats_.start).count();
+}
+
+/**
+ * @brief Get the statistics of the current query
+ * @return sample statistics
+ */
+const SampleStats& FreeSpaceSampler::stats() const
+{
+  return stats_;
+}
+
+/**
+ * @brief Get the number of free cells in the index
+ * @return free cells number
+ */
+int FreeSpaceSampler::freeCellsNum() const
+{
+  return static_cast<int>(free_cells_.size());
+}
+
+/**
+ * @brief Hash of the costmap passability used to detect changes
+ * @return hash value
+ */
+uint64_t FreeSpaceSampler::_passabilityHash() const
+{
+  const unsigned char* charmap = costmap_->getCharMap();
+  const size_t n = static_cast<size_t>(costmap_->getSizeInCellsX()) * costmap_->getSizeInCellsY();
+
+  // FNV-1a over 8-byte words
+  uint64_t h = 1469598103934665603ULL;
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= n; i += sizeof(uint64_t))
+  {
+    uint64_t w;
+    std::memcpy(&w, charmap + i, sizeof(uint64_t));
+    h = (h ^ w) * 1099511628211ULL;
+  }
+  for (; i < n; i++)
+    h = (h ^ charmap[i]) * 1099511628211ULL;
+
+  return h;
+}
+
+/**
+ * @brief Rebuild the free-cell index
+ */
+void FreeSpaceSampler::_rebuild()
+{
+  nx_ = static_cast<int>(costmap_->getSizeInCellsX());
+  ny_ = static_cast<int>(costmap_->getSizeInCellsY());
+
+  const unsigned char* charmap = costmap_->getCharMap();
+  const float threshold = costmap_2d::LETHAL_OBSTACLE * factor_;
+
+  free_cells_.clear();
+  free_cells_.reserve(static_cast<size_t>(nx_) * ny_);
+  row_begin_.assign(ny_ + 1, 0);
+  map_region_.clear();
+
+  for (int y = 0; y < ny_; y++)
+  {
+    row_begin_[y] = static_cast<int>(free_cells_.size());
+    const int offset = y * nx_;
+    for (int x = 0; x < nx_; x++)
+      if (charmap[offset + x] < threshold)
+        free_cells_.push_back(offset + x);
+    map_region_.push(row_begin_[y], static_cast<int>(free_cells_.size()) - row_begin_[y]);
+  }
+  row_begin_[ny_] = static_cast<int>(free_cells_.size());
+
+  // ellipse runs point into the old index
+  ellipse_region_.clear();
+  ellipse_c_best_ = -1.0;
+  valid_ = true;
+}
+
+/**
+ * @brief Next point of the configured sequence
+ * @param u first coordinate in [0, 1)
+ * @param v second coordinate in [0, 1)
+ */
+void FreeSpaceSampler::_next(double& u, double& v)
+{
+  switch (sequence_)
+  {
+    case Sequence::HALTON:
+      u = radicalInverse(seq_index_ + 1, 2);
+      v = radicalInverse(seq_index_ + 1, 3);
+      break;
+    case Sequence::SOBOL:
+      u = radicalInverse(seq_index_ + 1, 2);
+      v = sobol2(seq_index_ + 1);
+      break;
+    default:
+      u = uniform();
+      v = uniform();
+      return;
+  }
+  seq_index_++;
+
+  // Cranley-Patterson rotation
+  u += shift_u_;
+  v += shift_v_;
+  u -= std::floor(u);
+  v -= std::floor(v);
+}
+
+/**
+ * @brief Map (u, v) to a cell of the region: u selects the run, v the cell inside the run
+ * @param region sampling region
+ * @param u      first coordinate in [0, 1)
+ * @param v      second coordinate in [0, 1)
+ * @return cell index in costmap
+ */
+int FreeSpaceSampler::_pick(const Region& region, double u, double v) const
+{
+  const int target = std::min(static_cast<int>(u * region.total), region.total - 1);
+  const size_t k = std::upper_bound(region.acc.begin(), region.acc.end(), target) - region.acc.begin();
+  const int run = region.acc[k] - (k > 0 ? region.acc[k - 1] : 0);
+  const int offset = std::min(static_cast<int>(v * run), run - 1);
+  return free_cells_[region.begin[k] + offset];
+}
+
+/**
+ * @brief Build the runs of free cells inside the ellipse
+ * @param start  start node (focus)
+ * @param goal   goal node (focus)
+ * @param c_best major axis length
+ */
+void FreeSpaceSampler::_buildEllipse(const Node& start, const Node& goal, double c_best)
+{
+  ellipse_region_.clear();
+  ellipse_start_ = start.id();
+  ellipse_goal_ = goal.id();
+  ellipse_c_best_ = c_best;
+
+  // ellipse
+  const double cx = (start.x() + goal.x()) / 2.0;
+  const double cy = (start.y() + goal.y()) / 2.0;
+  const double phi = std::atan2(goal.y() - start.y(), goal.x() - start.x());
+  const double a = c_best / 2.0;
+  const double c = std::hypot(goal.x() - start.x(), goal.y() - start.y()) / 2.0;
+  const double b = std::sqrt(std::max(a * a - c * c, 1e-6));
+  const double sin_p = std::sin(phi), cos_p = std::cos(phi);
+  const double ia2 = 1.0 / (a * a), ib2 = 1.0 / (b * b);
+
+  // for each row, (x - cx) solves A * dx^2 + B * dx + C <= 0
+  const double A = cos_p * cos_p * ia2 + sin_p * sin_p * ib2;
+  const double half_h = std::sqrt(a * a * sin_p * sin_p + b * b * cos_p * cos_p);
+  const int y_min = std::max(0, static_cast<int>(std::ceil(cy - half_h)));
+  const int y_max = std::min(ny_ - 1, static_cast<int>(std::floor(cy + half_h)));
+
+  for (int y = y_min; y <= y_max; y++)
+  {
+    const double dy = y - cy;
+    const double B = 2.0 * dy * sin_p * cos_p * (ia2 - ib2);
+    const double C = dy * dy * (sin_p * sin_p * ia2 + cos_p * cos_p * ib2) - 1.0;
+    const double disc = B * B - 4.0 * A * C;
+    if (disc < 0)
+      continue;
+
+    const double sq = std::sqrt(disc);
+    const int x_lo = std::max(0, static_cast<int>(std::ceil(cx + (-B - sq) / (2.0 * A))));
+    const int x_hi = std::min(nx_ - 1, static_cast<int>(std::floor(cx + (-B + sq) / (2.0 * A))));
+    if (x_lo > x_hi)
+      continue;
+
+    // free cells of the row are sorted, so the interval is a contiguous run
+    auto row_first = free_cells_.begin() + row_begin_[y];
+    auto row_last = free_cells_.begin() + row_begin_[y + 1];
+    auto lo = std::lower_bound(row_first, row_last, y * nx_ + x_lo);
+    auto hi = std::upper_bound(lo, row_last, y * nx_ + x_hi);
+    ellipse_region_.push(static_cast<int>(lo - free_cells_.begin()), static_cast<int>(hi - lo));
+  }
+}
+}  // namespace global_planner
@@ -46,6 +46,9 @@ bool InformedRRT::plan(const Node& start, const Node& goal, std::vector<Node>& p
   expand.clear();
   sample_list_.clear();
 
+  // free-space index and footprint bitmap are only rebuilt if the costmap changed
+  _resetSampler();
+
   // initialization
   c_best_ = std::numeric_limits<double>::max();
   c_min_ = helper::dist(start, goal);
@@ -66,7 +69,10 @@ bool InformedRRT::plan(const Node& start, const Node& goal, std::vector<Node>& p
     // regular the sample node
     Node new_node = _findNearestPoint(sample_list_, sample_node);
     if (new_node.id() == -1)
+    {
+      sampler_.reject();
       continue;
+    }
     else
     {
       sample_list_.insert(std::make_pair(new_node.id(), new_node));
@@ -80,6 +86,7 @@ bool InformedRRT::plan(const Node& start, const Node& goal, std::vector<Node>& p
       double cost = dist_ + new_node.g();
       if (cost < c_best_)
       {
+        sampler_.solutionFound();
         best_parent = new_node.id();
         c_best_ = cost;
       }
@@ -109,6 +116,11 @@ Node InformedRRT::_generateRandomNode()
   // ellipse sample
   if (c_best_ < std::numeric_limits<double>::max())
   {
+    // free cells inside the ellipse only
+    Node node;
+    if (sampler_.sampleEllipse(start_, goal_, c_best_, node))
+      return node;
+
     while (true)
     {
       // unit ball sample
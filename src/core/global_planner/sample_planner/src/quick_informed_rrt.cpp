@@ -56,6 +56,10 @@ bool QuickInformedRRT::plan(const Node& start, const Node& goal, std::vector<Nod
   path.clear();
   expand.clear();
   sample_list_.clear();
+  index_.reset(costmap_->getSizeInCellsX(), costmap_->getSizeInCellsY(), r_);
+
+  // free-space index and footprint bitmap are only rebuilt if the costmap changed
+  _resetSampler();
 
   // initialization
   c_best_ = std::numeric_limits<double>::max();
@@ -64,7 +68,7 @@ bool QuickInformedRRT::plan(const Node& start, const Node& goal, std::vector<Nod
 
   // copy
   start_ = start, goal_ = goal;
-  sample_list_.insert(std::make_pair(start.id(), start));
+  _addSample(start);
   expand.push_back(start);
 
   // adaptive sampling bias
@@ -88,10 +92,13 @@ bool QuickInformedRRT::plan(const Node& start, const Node& goal, std::vector<Nod
     // regular the sample node
     Node new_node = _findNearestPoint(sample_list_, sample_node);
     if (new_node.id() == -1)
+    {
+      sampler_.reject();
       continue;
+    }
     else
     {
-      sample_list_.insert(std::make_pair(new_node.id(), new_node));
+      _addSample(new_node);
       expand.push_back(new_node);
     }
 
@@ -106,14 +113,16 @@ bool QuickInformedRRT::plan(const Node& start, const Node& goal, std::vector<Nod
       double cost = dist + new_node.g();
       if (cost < c_best_)
       {
+        sampler_.solutionFound();
         best_parent = new_node.id();
         c_best_ = cost;
 
         // update path
         Node goal_star(goal_.x(), goal_.y(), c_best_, 0, grid2Index(goal_.x(), goal_.y()), best_parent);
-        sample_list_.insert(std::make_pair(goal_star.id(), goal_star));
+        bool inserted = sample_list_.insert(std::make_pair(goal_star.id(), goal_star)).second;
         path = _convertClosedListToPath(sample_list_, start, goal);
-        sample_list_.erase(goal_star.id());
+        if (inserted)
+          sample_list_.erase(goal_star.id());
         mu = std::fmin(5, mu + 0.5);
       }
     }
@@ -163,6 +172,11 @@ Node QuickInformedRRT::_generateRandomNode(int mu, std::vector<Node> path)
   {
     if (c_best_ < std::numeric_limits<double>::max())
     {
+      // free cells inside the ellipse only
+      Node node;
+      if (sampler_.sampleEllipse(start_, goal_, c_best_, node))
+        return node;
+
       while (true)
       {
         // unit ball sample
@@ -192,25 +206,21 @@ Node QuickInformedRRT::_generateRandomNode(int mu, std::vector<Node> path)
  * @param node sample node
  * @return nearest node
  */
-Node QuickInformedRRT::_findNearestPoint(std::unordered_map<int, Node> list, Node& node)
+Node QuickInformedRRT::_findNearestPoint(std::unordered_map<int, Node>& list, Node& node)
 {
   Node nearest_node, new_node(node);
-  double min_dist = std::numeric_limits<double>::max();
+  double min_dist;
 
-  for (const auto p : list)
+  // nearest node from spatial index
+  int nearest_id = index_.nearest(new_node.x(), new_node.y(), &min_dist);
+  if (nearest_id == -1)
   {
-    // calculate distance
-    double new_dist = helper::dist(p.second, new_node);
-
-    // update nearest node
-    if (new_dist < min_dist)
-    {
-      nearest_node = p.second;
-      new_node.set_pid(nearest_node.id());
-      new_node.set_g(new_dist + p.second.g());
-      min_dist = new_dist;
-    }
+    new_node.set_id(-1);
+    return new_node;
   }
+  nearest_node = list[nearest_id];
+  new_node.set_pid(nearest_node.id());
+  new_node.set_g(min_dist + nearest_node.g());
 
   // distance longer than the threshold
   if (min_dist > max_dist_)
@@ -231,46 +241,61 @@ Node QuickInformedRRT::_findNearestPoint(std::unordered_map<int, Node> list, Nod
   {
     max_dist_ += d_extend_;
 
-    // parallel rewire optimization
-    std::vector<int> v_iters;
-    for (auto& p : sample_list_)
+    // neighbours inside the optimization circle, buffers keep their capacity between iterations
+    near_.clear();
+    index_.radius(new_node.x(), new_node.y(), r_, near_);
+    const int n_near = static_cast<int>(near_.size());
+    near_dist_.resize(n_near);
+    near_free_.resize(n_near);
+
+    // parallel candidate evaluation, read-only on the tree
+#pragma omp parallel for num_threads(n_threads_) schedule(dynamic, 8)
+    for (int i = 0; i < n_near; i++)
     {
-      v_iters.push_back(p.first);
+      const Node& p = list.find(near_[i])->second;
+      near_dist_[i] = helper::dist(p, new_node);
+      near_free_[i] = !_isAnyObstacleInPath(new_node, p);
     }
 
-#pragma omp parallel for num_threads(n_threads_)
-    for (int i = 0; i < v_iters.size(); i++)
+    // choose the best parent, ties are broken by neighbour order so the result is deterministic
+    for (int i = 0; i < n_near; i++)
     {
-      auto& p = sample_list_[v_iters[i]];
-
-      // inside the optimization circle
-      double new_dist = helper::dist(p, new_node);
-      if (new_dist >= r_ || _isAnyObstacleInPath(new_node, p))
+      if (!near_free_[i])
         continue;
-
-#pragma omp critical
-      // other thread may update new_node.g() or p.g()
+      const Node& p = list.find(near_[i])->second;
+      double cost = p.g() + near_dist_[i];
+      if (cost < new_node.g())
       {
-        double cost;
-        // update new sample node's cost and parent
-        cost = p.g() + new_dist;
-        if (new_node.g() > cost)
-        {
-          new_node.set_pid(p.id());
-          new_node.set_g(cost);
-        }
+        new_node.set_pid(p.id());
+        new_node.set_g(cost);
+      }
+    }
 
-        // update nodes' cost inside the radius
-        cost = new_node.g() + new_dist;
-        if (cost < p.g())
-        {
-          p.set_pid(new_node.id());
-          p.set_g(cost);
-        }
+    // rewire neighbours through the new node, each neighbour is written once
+    for (int i = 0; i < n_near; i++)
+    {
+      if (!near_free_[i])
+        continue;
+      Node& p = list.find(near_[i])->second;
+      double cost = new_node.g() + near_dist_[i];
+      if (cost < p.g() && p.id() != new_node.pid())
+      {
+        p.set_pid(new_node.id());
+        p.set_g(cost);
       }
     }
   }
 
   return new_node;
 }
-}  // namespace global_planner
\ No newline at end of file
+
+/**
+ * @brief Add a node to the sample list and the spatial index
+ * @param node sample node
+ */
+void QuickInformedRRT::_addSample(const Node& node)
+{
+  if (sample_list_.insert(std::make_pair(node.id(), node)).second)
+    index_.insert(node.id(), node.x(), node.y());
+}
+}  // namespace global_planner
@@ -14,8 +14,6 @@
  *
  * ********************************************************
  */
-#include <random>
-
 #include "rrt.h"
 
 namespace global_planner
@@ -27,7 +25,7 @@ namespace global_planner
  * @param max_dist   max distance between sample points
  */
 RRT::RRT(costmap_2d::Costmap2D* costmap, int sample_num, double max_dist)
-  : GlobalPlanner(costmap), sample_num_(sample_num), max_dist_(max_dist)
+  : GlobalPlanner(costmap), sample_num_(sample_num), max_dist_(max_dist), sampler_(costmap)
 {
 }
 
@@ -46,6 +44,9 @@ bool RRT::plan(const Node& start, const Node& goal, std::vector<Node>& path, std
   expand.clear();
   sample_list_.clear();
 
+  // free-space index and footprint bitmap are only rebuilt if the costmap changed
+  _resetSampler();
+
   // copy
   start_ = start, goal_ = goal;
   sample_list_.insert(std::make_pair(start.id(), start));
@@ -61,7 +62,10 @@ bool RRT::plan(const Node& start, const Node& goal, std::vector<Node>& path, std
     // regular the sample node
     Node new_node = _findNearestPoint(sample_list_, sample_node);
     if (new_node.id() == -1)
+    {
+      sampler_.reject();
       continue;
+    }
     else
     {
       sample_list_.insert(std::make_pair(new_node.id(), new_node));
@@ -71,6 +75,7 @@ bool RRT::plan(const Node& start, const Node& goal, std::vector<Node>& path, std
     // goal found
     if (_checkGoal(new_node))
     {
+      sampler_.solutionFound();
       path = _convertClosedListToPath(sample_list_, start, goal);
       return true;
     }
@@ -82,32 +87,69 @@ bool RRT::plan(const Node& start, const Node& goal, std::vector<Node>& path, std
 }
 
 /**
- * @brief Generates a random node
- * @return generated node
+ * @brief Set the source sequence of the free-space sampler
+ * @param sequence sample sequence
  */
-Node RRT::_generateRandomNode()
+void RRT::setSampleSequence(FreeSpaceSampler::Sequence sequence)
 {
-  // obtain a random number from hardware
-  std::random_device rd;
+  sampler_.setSequence(sequence);
+}
 
-  // seed the generator
-  std::mt19937 eng(rd());
+/**
+ * @brief Check collisions with the robot footprint along the edges, besides the centre cell against the inflated
+ *        costmap
+ * @param footprint footprint vertices in the robot frame in meters, empty to check the centre cell only
+ */
+void RRT::setFootprint(const std::vector<std::pair<double, double>>& footprint)
+{
+  footprint_checker_.setFootprint(footprint, costmap_->getResolution());
+}
 
-  // define the range
-  std::uniform_real_distribution<float> p(0, 1);
+/**
+ * @brief Get the sampling statistics of the last planning query
+ * @return sample statistics
+ */
+const SampleStats& RRT::getSampleStats() const
+{
+  return sampler_.stats();
+}
 
+/**
+ * @brief Generates a random node
+ * @return generated node
+ */
+Node RRT::_generateRandomNode()
+{
   // heuristic
-  if (p(eng) > opti_sample_p_)
+  if (sampler_.uniform() > opti_sample_p_)
   {
-    // generate node
-    std::uniform_int_distribution<int> distr(0, map_size_ - 1);
-    const int id = distr(eng);
+    // generate node in free space
+    Node node;
+    if (sampler_.sample(node))
+      return node;
+
+    // no free cell indexed, fall back to the whole map
+    const int id = std::min(static_cast<int>(sampler_.uniform() * map_size_), map_size_ - 1);
     int x, y;
     index2Grid(id, x, y);
     return Node(x, y, 0, 0, id, -1);
   }
   else
+  {
+    sampler_.biased();
     return Node(goal_.x(), goal_.y(), 0, 0, goal_.id(), -1);
+  }
+}
+
+/**
+ * @brief Prepare the free-space sampler and the footprint checker for a new query, both follow the costmap
+ */
+void RRT::_resetSampler()
+{
+  sampler_.setFactor(factor_);
+  sampler_.reset();
+  footprint_checker_.update(costmap_->getCharMap(), costmap_->getSizeInCellsX(), costmap_->getSizeInCellsY(),
+                            costmap_2d::LETHAL_OBSTACLE);
 }
 
 /**
@@ -182,6 +224,21 @@ bool RRT::_isAnyObstacleInPath(const Node& n1, const Node& n2)
       return true;
   }
 
+  // the footprint every half inscribed radius from n1 and at n2, facing either way as the edge is driven from
+  // whichever node joined the tree first
+  if (footprint_checker_.valid())
+  {
+    const double spacing = footprint_checker_.spacing();
+    const int n_check = static_cast<int>(std::ceil(dist / spacing));
+    for (int i = 0; i <= n_check; i++)
+    {
+      const double d = std::min(i * spacing, dist);
+      const double x = n1.x() + d * cos(theta), y = n1.y() + d * sin(theta);
+      if (footprint_checker_.collides(x, y, theta) || footprint_checker_.collides(x, y, theta + M_PI))
+        return true;
+    }
+  }
+
   return false;
 }
 
@@ -44,6 +44,9 @@ bool RRTConnect::plan(const Node& start, const Node& goal, std::vector<Node>& pa
   sample_list_f_.clear();
   sample_list_b_.clear();
 
+  // free-space index and footprint bitmap are only rebuilt if the costmap changed
+  _resetSampler();
+
   // copy
   start_ = start, goal_ = goal;
   sample_list_f_.insert(std::make_pair(start.id(), start));
@@ -61,7 +64,10 @@ bool RRTConnect::plan(const Node& start, const Node& goal, std::vector<Node>& pa
     // regular the sample node
     Node new_node_f = _findNearestPoint(sample_list_f_, sample_node);
     if (new_node_f.id() == -1)
+    {
+      sampler_.reject();
       continue;
+    }
     else
     {
       sample_list_f_.insert(std::make_pair(new_node_f.id(), new_node_f));
@@ -97,6 +103,7 @@ bool RRTConnect::plan(const Node& start, const Node& goal, std::vector<Node>& pa
         // connected -> goal found
         if (new_node_b == new_node_f)
         {
+          sampler_.solutionFound();
           path = _convertClosedListToPath(new_node_b);
           return true;
         }
@@ -44,6 +44,9 @@ bool RRTStar::plan(const Node& start, const Node& goal, std::vector<Node>& path,
   expand.clear();
   sample_list_.clear();
 
+  // free-space index and footprint bitmap are only rebuilt if the costmap changed
+  _resetSampler();
+
   // copy
   start_ = start, goal_ = goal;
   sample_list_.insert(std::make_pair(start.id(), start));
@@ -60,7 +63,10 @@ bool RRTStar::plan(const Node& start, const Node& goal, std::vector<Node>& path,
     // regular the sample node
     Node new_node = _findNearestPoint(sample_list_, sample_node);
     if (new_node.id() == -1)
+    {
+      sampler_.reject();
       continue;
+    }
     else
     {
       sample_list_.insert(std::make_pair(new_node.id(), new_node));
@@ -70,6 +76,7 @@ bool RRTStar::plan(const Node& start, const Node& goal, std::vector<Node>& path,
     // goal found
     if (_checkGoal(new_node))
     {
+      sampler_.solutionFound();
       path = _convertClosedListToPath(sample_list_, start, goal);
       optimized = true;
     }
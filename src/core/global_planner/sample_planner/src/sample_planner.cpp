@@ -22,6 +22,7 @@
 #include "rrt_connect.h"
 #include "informed_rrt.h"
 #include "quick_informed_rrt.h"
+#include "bit_star.h"
 
 PLUGINLIB_EXPORT_CLASS(sample_planner::SamplePlanner, nav_core::BaseGlobalPlanner)
 
@@ -70,6 +71,14 @@ void SamplePlanner::initialize(std::string name, costmap_2d::Costmap2DROS* costm
     private_nh.param("sample_max_d", sample_max_d, 5.0);       // max distance between sample points
     private_nh.param("optimization_r", optimization_r, 10.0);  // optimization radius
 
+    // sequence of free-space samples
+    std::string sample_sequence;
+    private_nh.param("sample_sequence", sample_sequence, std::string("uniform"));
+
+    // whether to check the robot footprint along the edges besides the inflated centre cell
+    bool use_footprint;
+    private_nh.param("use_footprint", use_footprint, false);
+
     // planner name
     private_nh.param("planner_name", planner_name_, std::string("rrt"));
 
@@ -94,11 +103,35 @@ void SamplePlanner::initialize(std::string name, costmap_2d::Costmap2DROS* costm
       g_planner_ = std::make_shared<global_planner::QuickInformedRRT>(
           costmap, sample_points, sample_max_d, optimization_r, prior_set_r, rewire_threads_n, step_ext_d, t_freedom);
     }
+    else if (planner_name_ == "bit_star")
+    {
+      int batch_size;
+      private_nh.param("batch_size", batch_size, 100);  // samples number of each batch
+      g_planner_ = std::make_shared<global_planner::BITStar>(costmap, sample_points, sample_max_d, batch_size);
+    }
     else
       ROS_ERROR("Unknown planner name: %s", planner_name_.c_str());
 
     g_planner_->setFactor(factor_);
 
+    auto rrt_planner = std::dynamic_pointer_cast<global_planner::RRT>(g_planner_);
+    if (rrt_planner)
+    {
+      global_planner::FreeSpaceSampler::Sequence sequence;
+      if (global_planner::FreeSpaceSampler::parseSequence(sample_sequence, sequence))
+        rrt_planner->setSampleSequence(sequence);
+      else
+        ROS_WARN("Unknown sample sequence: %s, using uniform instead.", sample_sequence.c_str());
+
+      if (use_footprint)
+      {
+        std::vector<std::pair<double, double>> footprint;
+        for (const auto& p : costmap_ros_->getRobotFootprint())
+          footprint.emplace_back(p.x, p.y);
+        rrt_planner->setFootprint(footprint);
+      }
+    }
+
     ROS_INFO("Using global sample planner: %s", planner_name_.c_str());
 
     // register planning publisher
@@ -183,6 +216,14 @@ bool SamplePlanner::makePlan(const geometry_msgs::PoseStamped& start, const geom
   // planning
   path_found = g_planner_->plan(start_node, goal_node, path, expand);
 
+  auto rrt_planner = std::dynamic_pointer_cast<global_planner::RRT>(g_planner_);
+  if (rrt_planner)
+  {
+    const auto& stats = rrt_planner->getSampleStats();
+    ROS_DEBUG("Samples drawn: %d, wasted: %.1f%%, time to first solution: %.3fs (%d samples)", stats.drawn,
+              100.0 * stats.wastedRatio(), stats.first_solution_t, stats.first_solution_iter);
+  }
+
   // convert path to ros plan
   if (path_found)
   {
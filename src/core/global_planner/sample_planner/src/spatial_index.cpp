@@ -0,0 +1,205 @@
+/**
+ * *********************************************************
+ *
+ * @file: spatial_index.cpp
+ * @brief: Uniform bucket grid for nearest and radius queries over sample points
+ * @author: Yang Haodong
+ * @date: 2024-09-22
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "spatial_index.h"
+
+namespace global_planner
+{
+/**
+ * @brief Construct a new Spatial Index object
+ * @param nx          costmap size in cells along x
+ * @param ny          costmap size in cells along y
+ * @param bucket_size bucket edge length in cells
+ */
+SpatialIndex::SpatialIndex(int nx, int ny, double bucket_size) : bx_(0), by_(0), bucket_size_(1.0), size_(0)
+{
+  reset(nx, ny, bucket_size);
+}
+
+/**
+ * @brief Reset the grid geometry, all entries are removed
+ * @param nx          costmap size in cells along x
+ * @param ny          costmap size in cells along y
+ * @param bucket_size bucket edge length in cells
+ */
+void SpatialIndex::reset(int nx, int ny, double bucket_size)
+{
+  bucket_size_ = std::max(bucket_size, 1.0);
+  int bx = std::max(1, static_cast<int>(std::ceil(nx / bucket_size_)));
+  int by = std::max(1, static_cast<int>(std::ceil(ny / bucket_size_)));
+
+  if (bx != bx_ || by != by_)
+  {
+    bx_ = bx;
+    by_ = by;
+    buckets_.assign(static_cast<size_t>(bx_) * by_, std::vector<Entry>());
+    used_.clear();
+    size_ = 0;
+  }
+  else
+    clear();
+}
+
+/**
+ * @brief Remove all entries while keeping the geometry and the allocated buckets
+ */
+void SpatialIndex::clear()
+{
+  for (int b : used_)
+    buckets_[b].clear();
+  used_.clear();
+  size_ = 0;
+}
+
+/**
+ * @brief Insert an entry
+ * @param handle user defined handle, e.g. the node id
+ * @param x      grid map x
+ * @param y      grid map y
+ */
+void SpatialIndex::insert(int handle, int x, int y)
+{
+  auto& bucket = buckets_[_bucketY(y) * bx_ + _bucketX(x)];
+  if (bucket.empty())
+    used_.push_back(_bucketY(y) * bx_ + _bucketX(x));
+  bucket.push_back({ handle, x, y });
+  size_++;
+}
+
+/**
+ * @brief Remove an entry
+ * @param handle handle of the entry
+ * @param x      grid map x the entry was inserted with
+ * @param y      grid map y the entry was inserted with
+ * @return true if the entry was found, else false
+ */
+bool SpatialIndex::remove(int handle, int x, int y)
+{
+  auto& bucket = buckets_[_bucketY(y) * bx_ + _bucketX(x)];
+  for (size_t i = 0; i < bucket.size(); i++)
+  {
+    if (bucket[i].handle == handle)
+    {
+      bucket[i] = bucket.back();
+      bucket.pop_back();
+      size_--;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Find the nearest entry
+ * @param x        query grid map x
+ * @param y        query grid map y
+ * @param min_dist distance to the nearest entry (optional)
+ * @return handle of the nearest entry, -1 if empty
+ */
+int SpatialIndex::nearest(int x, int y, double* min_dist) const
+{
+  int best = -1;
+  double best_d2 = std::numeric_limits<double>::max();
+  if (size_ > 0)
+  {
+    const int cx = _bucketX(x), cy = _bucketY(y);
+    const int max_ring = std::max(bx_, by_);
+
+    // visit rings of buckets until no closer entry can exist
+    for (int ring = 0; ring <= max_ring; ring++)
+    {
+      if (best != -1)
+      {
+        double reach = (ring - 1) * bucket_size_;
+        if (reach > 0 && reach * reach > best_d2)
+          break;
+      }
+
+      for (int j = cy - ring; j <= cy + ring; j++)
+      {
+        if (j < 0 || j >= by_)
+          continue;
+        const bool edge_row = (j == cy - ring || j == cy + ring);
+        const int step = edge_row ? 1 : 2 * ring;
+        for (int i = cx - ring; i <= cx + ring; i += std::max(step, 1))
+        {
+          if (i < 0 || i >= bx_)
+            continue;
+          for (const auto& e : buckets_[j * bx_ + i])
+          {
+            double d2 = static_cast<double>(e.x - x) * (e.x - x) + static_cast<double>(e.y - y) * (e.y - y);
+            if (d2 < best_d2)
+            {
+              best_d2 = d2;
+              best = e.handle;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  if (min_dist)
+    *min_dist = best == -1 ? std::numeric_limits<double>::max() : std::sqrt(best_d2);
+  return best;
+}
+
+/**
+ * @brief Find all entries inside the circle
+ * @param x       query grid map x
+ * @param y       query grid map y
+ * @param r       query radius in cells
+ * @param handles handles of the entries inside the circle, appended
+ */
+void SpatialIndex::radius(int x, int y, double r, std::vector<int>& handles) const
+{
+  const double r2 = r * r;
+  const int x0 = _bucketX(static_cast<int>(std::floor(x - r))), x1 = _bucketX(static_cast<int>(std::ceil(x + r)));
+  const int y0 = _bucketY(static_cast<int>(std::floor(y - r))), y1 = _bucketY(static_cast<int>(std::ceil(y + r)));
+
+  for (int j = y0; j <= y1; j++)
+    for (int i = x0; i <= x1; i++)
+      for (const auto& e : buckets_[j * bx_ + i])
+        if (static_cast<double>(e.x - x) * (e.x - x) + static_cast<double>(e.y - y) * (e.y - y) < r2)
+          handles.push_back(e.handle);
+}
+
+/**
+ * @brief Get the number of entries
+ * @return entries number
+ */
+int SpatialIndex::size() const
+{
+  return size_;
+}
+
+/**
+ * @brief Bucket coordinate of a cell coordinate, clamped into the grid
+ */
+int SpatialIndex::_bucketX(int x) const
+{
+  return std::min(std::max(static_cast<int>(x / bucket_size_), 0), bx_ - 1);
+}
+
+int SpatialIndex::_bucketY(int y) const
+{
+  return std::min(std::max(static_cast<int>(y / bucket_size_), 0), by_ - 1);
+}
+}  // namespace global_planner
@@ -26,6 +26,7 @@
 #include <nav_msgs/OccupancyGrid.h>
 #include <tf2/utils.h>
 
+#include "distance_field.h"
 #include "local_planner.h"
 
 namespace apf_planner
@@ -120,6 +121,8 @@ private:
 
   double inflation_radius_;  // the costmap inflation radius of obstacles
 
+  std::shared_ptr<costmap_2d::DistanceField> distance_field_;  // distances to obstacles of the local costmap
+
   std::deque<Eigen::Vector2d> hist_nf_;  // historical net forces
 
   ros::Publisher target_pose_pub_, current_pose_pub_, potential_map_pub_;
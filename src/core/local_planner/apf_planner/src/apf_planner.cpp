@@ -93,6 +93,8 @@ void APFPlanner::initialize(std::string name, tf2_ros::Buffer* tf, costmap_2d::C
 
     hist_nf_.clear();
 
+    distance_field_ = costmap_2d::DistanceField::instance(costmap_ros_);
+
     target_pose_pub_ = nh.advertise<geometry_msgs::PoseStamped>("/target_pose", 10);
     current_pose_pub_ = nh.advertise<geometry_msgs::PoseStamped>("/current_pose", 10);
     potential_map_pub_ = nh.advertise<nav_msgs::OccupancyGrid>("/potential_map", 10);
@@ -299,7 +301,6 @@ Eigen::Vector2d APFPlanner::getRepulsiveForce()
   }
 
   int nx = costmap_ros_->getCostmap()->getSizeInCellsX();
-  int ny = costmap_ros_->getCostmap()->getSizeInCellsY();
   double current_cost = costmap_ros_->getCostmap()->getCharMap()[mx + nx * my];
   if (current_cost >= cost_ub_ || current_cost < cost_lb_)
   {
@@ -310,17 +311,29 @@ Eigen::Vector2d APFPlanner::getRepulsiveForce()
     return rep_force;
   }
 
-  // obtain the distance between the robot and obstacles directly through costmap
-  // mapping from cost_ub_ to distance 0
-  // mapping from cost_lb_ to distance 1  (normalized)
-  double bound_diff = cost_ub_ - cost_lb_;
-  double dist = (cost_ub_ - current_cost) / bound_diff;
+  // obtain the distance between the robot and obstacles and its gradient from the distance field of the costmap
+  // mapping from obstacles to distance 0
+  // mapping from the inflation radius on to distance 1  (normalized)
+  distance_field_->update();
+  const std::shared_ptr<const costmap_2d::VoronoiBuffer> field = distance_field_->snapshot();
+  if (!field)
+  {
+    ROS_WARN("The distance field of the costmap is not computed yet.");
+    return Eigen::Vector2d::Zero();
+  }
+  double grad_x, grad_y;
+  double dist = std::min(field->distance(x, y, grad_x, grad_y) / inflation_radius_, 1.0);
+  if (dist <= 0.0)
+  {
+    ROS_WARN("The robot's position is within an obstacle of the distance field.");
+    return Eigen::Vector2d::Zero();
+  }
   double k = (1.0 - 1.0 / dist) / (dist * dist);
-  double next_x = costmap_ros_->getCostmap()->getCharMap()[std::min(mx + 1, nx - 1) + nx * my];
-  double prev_x = costmap_ros_->getCostmap()->getCharMap()[std::max(mx - 1, 0) + nx * my];
-  double next_y = costmap_ros_->getCostmap()->getCharMap()[mx + nx * std::min(my + 1, ny - 1)];
-  double prev_y = costmap_ros_->getCostmap()->getCharMap()[mx + nx * std::max(my - 1, 0)];
-  Eigen::Vector2d grad_dist((next_x - prev_x) / (2.0 * bound_diff), (next_y - prev_y) / (2.0 * bound_diff));
+
+  // gradient of the normalized cost per cell, i.e. the negative distance gradient pointing towards the obstacles,
+  // beyond the inflation radius it stays flat. With k < 0 the force points away from the obstacles.
+  double scale = dist < 1.0 ? costmap_ros_->getCostmap()->getResolution() / inflation_radius_ : 0.0;
+  Eigen::Vector2d grad_dist = -Eigen::Vector2d(grad_x, grad_y) * scale;
 
   rep_force = k * grad_dist;
 
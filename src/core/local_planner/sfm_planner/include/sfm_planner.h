@@ -12,6 +12,7 @@
 #include <boost/bind.hpp>
 #include <tf2/utils.h>
 
+#include "distance_field.h"
 #include "lightsfm/sfm.hpp"
 #include "local_planner.h"
 
@@ -48,9 +49,11 @@ private:
   std::vector<sfm::Agent> others_;
   std::vector<ros::Subscriber> odom_subs_;
   std::vector<nav_msgs::Odometry> other_odoms_;
+  std::shared_ptr<costmap_2d::DistanceField> distance_field_;  // clearance of the local costmap
 
   void initState();
   void handleAgents();
+  void handleObstacles();
 
   void odometryCallback(const nav_msgs::OdometryConstPtr& msg, int agent_id);
 };
@@ -82,6 +82,8 @@ void SfmPlanner::initialize(std::string name, tf2_ros::Buffer* tf, costmap_2d::C
     nh.param("/move_base/controller_frequency", controller_freqency, 10.0);
     d_t_ = 1 / controller_freqency;
 
+    distance_field_ = costmap_2d::DistanceField::instance(costmap_ros_);
+
     initState();
     ROS_INFO("SFM planner initialized!");
   }
@@ -158,8 +160,8 @@ bool SfmPlanner::computeVelocityCommands(geometry_msgs::Twist& cmd_vel)
   }
   else
   {
-    // TODO: update closest obstacle
-    // handleObstacles();
+    // update closest obstacle
+    handleObstacles();
 
     // update pedestrian around
     handleAgents();
@@ -202,6 +204,30 @@ void SfmPlanner::handleAgents()
   }
 }
 
+void SfmPlanner::handleObstacles()
+{
+  agent_.obstacles1.clear();
+
+  geometry_msgs::PoseStamped robot_pose;
+  if (!costmap_ros_->getRobotPose(robot_pose))
+    return;
+
+  distance_field_->update();
+  const std::shared_ptr<const costmap_2d::VoronoiBuffer> field = distance_field_->snapshot();
+  if (!field)
+    return;
+
+  double grad_x, grad_y;
+  const double dist = field->distance(robot_pose.pose.position.x, robot_pose.pose.position.y, grad_x, grad_y);
+  const double grad = std::hypot(grad_x, grad_y);
+  if (!std::isfinite(dist) || dist <= 0.0 || grad < 1e-6)
+    return;
+
+  // the closest obstacle lies down the gradient, placed relative to the agent
+  agent_.obstacles1.emplace_back(agent_.position.getX() - dist * grad_x / grad,
+                                 agent_.position.getY() - dist * grad_y / grad);
+}
+
 bool SfmPlanner::isGoalReached()
 {
   if (!initialized_)
@@ -0,0 +1,150 @@
+/**
+ * *********************************************************
+ *
+ * @file: footprint_checker.h
+ * @brief: Footprint collision checker with rasterised masks for discrete headings
+ * @author: Yang Haodong
+ * @date: 2024-10-07
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#ifndef FOOTPRINT_CHECKER_H
+#define FOOTPRINT_CHECKER_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace helper
+{
+/**
+ * @brief Collision checker of a polygonal footprint against a grid map.
+ *        The footprint is rasterised once per discrete heading into row bitmasks centred on the robot cell, and the
+ *        map is packed into a bitmap of obstacle cells padded with an obstacle border, so a pose check is an AND of
+ *        the mask rows with the map rows and needs no bounds checks. Most poses never reach the masks, a chessboard
+ *        clearance map decides them from the inscribed and circumscribed radius of the footprint alone.
+ */
+class FootprintChecker
+{
+public:
+  using Polygon = std::vector<std::pair<double, double>>;
+
+  /**
+   * @brief Construct a new Footprint Checker object
+   * @param headings number of discrete headings
+   */
+  explicit FootprintChecker(int headings = 72);
+
+  /**
+   * @brief Rasterise the footprint for every discrete heading
+   * @param footprint  footprint vertices in the robot frame, in meters, empty to remove the footprint
+   * @param resolution map resolution, in meters per cell
+   */
+  void setFootprint(const Polygon& footprint, double resolution);
+
+  /**
+   * @brief Rebuild the obstacle bitmap and the clearance map if the map changed since the last update, so it may be
+   *        called before every query
+   * @param charmap   map costs, nx * ny cells
+   * @param nx        map size in cells along x
+   * @param ny        map size in cells along y
+   * @param threshold cells with a cost greater or equal to it are obstacles. Planners which check the centre cell
+   *                  against the inflated costmap pass the lethal cost, the footprint only collides with obstacles
+   * @return true if rebuilt, false if the map is unchanged or no footprint is set
+   */
+  bool update(const unsigned char* charmap, int nx, int ny, unsigned char threshold);
+
+  /**
+   * @brief Check whether the footprint at a pose overlaps an obstacle or leaves the map
+   * @param mx    map x of the robot, in cells
+   * @param my    map y of the robot, in cells
+   * @param theta heading of the robot, in radians
+   * @return true if the pose collides, else false
+   */
+  bool collides(double mx, double my, double theta) const;
+
+  /**
+   * @brief Check the footprint facing along a segment of a path every spacing(), a path is checked segment by
+   *        segment with the offset carried over so that the checks keep their spacing across the vertices
+   * @param x0     map x of the segment start, in cells
+   * @param y0     map y of the segment start, in cells
+   * @param x1     map x of the segment end, in cells
+   * @param y1     map y of the segment end, in cells
+   * @param offset distance from the segment start to the first check, on return the one of the next segment,
+   *               0 for the first segment of a path
+   * @return true if a check collides, false if none does or no footprint is set
+   */
+  bool sweep(double x0, double y0, double x1, double y1, double& offset) const;
+
+  /**
+   * @brief Discrete heading of an angle, the one whose mask is used for it
+   * @param theta angle in radians
+   * @return heading index in [0, headings)
+   */
+  int heading(double theta) const;
+
+  /**
+   * @brief Whether a footprint has been set
+   */
+  bool valid() const;
+
+  /**
+   * @brief Get the inscribed and circumscribed radius of the footprint, in cells
+   */
+  double inscribedRadius() const;
+  double circumscribedRadius() const;
+
+  /**
+   * @brief Get the longest step between two footprint checks along a path, half the inscribed radius so that no
+   *        obstacle cell slips between them, but at least a cell as the masks are rasterised per cell
+   * @return step in cells
+   */
+  double spacing() const;
+
+protected:
+  /**
+   * @brief Rasterise the footprint rotated by an angle into the masks of a heading
+   * @param footprint  footprint vertices in cells
+   * @param theta      rotation in radians
+   * @param mask       mask rows of the heading, rows_ * words_ words
+   */
+  void _rasterise(const Polygon& footprint, double theta, std::uint64_t* mask) const;
+
+  /**
+   * @brief Chessboard distance transform of the obstacle cells, the map border counts as an obstacle
+   * @param charmap   map costs, nx * ny cells
+   * @param threshold cells with a cost greater or equal to it are obstacles
+   */
+  void _updateClearance(const unsigned char* charmap, unsigned char threshold);
+
+  /**
+   * @brief FNV-1a hash of the map, its size and the obstacle threshold
+   * @param charmap   map costs, nx * ny cells
+   * @param nx        map size in cells along x
+   * @param ny        map size in cells along y
+   * @param threshold cells with a cost greater or equal to it are obstacles
+   * @return hash, never 0
+   */
+  static std::uint64_t _hash(const unsigned char* charmap, int nx, int ny, unsigned char threshold);
+
+protected:
+  int headings_;                      // number of discrete headings
+  int radius_;                        // mask half size in cells, also the padding of the bitmap
+  int rows_, words_;                  // rows of a mask and words of a mask row
+  double r_in_, r_out_;               // inscribed and circumscribed radius in cells
+  std::vector<std::uint64_t> masks_;  // headings * rows_ * words_ footprint bits, bit i of a row is column i - radius_
+  int nx_, ny_;                       // map size in cells
+  int stride_;                        // words of a padded bitmap row
+  std::vector<std::uint64_t> map_;    // obstacle bits of the map padded by radius_ cells of obstacles on every side
+  std::vector<std::uint8_t> clear_;   // chessboard distance to the closest obstacle, capped, padded by one cell
+  std::uint64_t hash_;                // hash of the map the bitmap was built for, 0 if none
+};
+}  // namespace helper
+
+#endif  // FOOTPRINT_CHECKER_H
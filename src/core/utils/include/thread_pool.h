@@ -0,0 +1,123 @@
+/**
+ * *********************************************************
+ *
+ * @file: thread_pool.h
+ * @brief: Persistent work-stealing thread pool for data parallel batches
+ * @author: Yang Haodong
+ * @date: 2024-09-25
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace helper
+{
+/**
+ * @brief Persistent pool of worker threads executing batches of indexed tasks.
+ *        Each batch [0, n) is split into one contiguous range per worker, a worker which runs out of
+ *        tasks steals half of the remaining range of another worker. The calling thread takes part in
+ *        the batch as worker 0, so a pool of size 1 runs everything inline without any synchronisation.
+ */
+class ThreadPool
+{
+public:
+  /**
+   * @brief Batch task, called as task(index, worker) with worker in [0, size())
+   */
+  using Task = std::function<void(int, int)>;
+
+  /**
+   * @brief Construct a new Thread Pool object
+   * @param n_threads number of workers including the calling thread, 0 for the hardware concurrency
+   */
+  explicit ThreadPool(int n_threads = 0);
+
+  /**
+   * @brief Destroy the Thread Pool object, joining all workers
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * @brief Process-wide pool shared by the planners
+   * @return the shared pool
+   */
+  static ThreadPool& instance();
+
+  /**
+   * @brief Get the number of workers including the calling thread
+   * @return workers number
+   */
+  int size() const;
+
+  /**
+   * @brief Run task(i, worker) for every i in [0, n) and block until all tasks finished.
+   *        Calls from inside a task run serially on the calling worker.
+   * @param n    number of tasks
+   * @param task task to run
+   */
+  void parallelFor(int n, const Task& task);
+
+protected:
+  /**
+   * @brief Remaining task range of a worker
+   */
+  struct Range
+  {
+    std::mutex lock;
+    int begin = 0, end = 0;
+  };
+
+  /**
+   * @brief Worker thread main loop
+   * @param worker worker index
+   */
+  void _workerLoop(int worker);
+
+  /**
+   * @brief Execute tasks of the current batch until no range has work left
+   * @param worker worker index
+   */
+  void _runBatch(int worker);
+
+  /**
+   * @brief Take the next task of a worker, stealing from the others if its own range is empty
+   * @param worker worker index
+   * @param index  task index
+   * @return true if a task was taken, else false
+   */
+  bool _takeTask(int worker, int& index);
+
+protected:
+  int n_threads_;                               // workers number including the caller
+  std::vector<std::thread> threads_;            // background workers 1 ... n_threads_ - 1
+  std::vector<std::unique_ptr<Range>> ranges_;  // remaining task range of each worker
+  const Task* task_;                            // task of the current batch
+  std::atomic<int> active_;                     // background workers still inside the current batch
+  unsigned int generation_;                     // batch counter, wakes the workers up
+  bool stop_;                                   // pool is shutting down
+  std::mutex mutex_;                            // protects generation_, stop_ and task_
+  std::condition_variable start_cv_;            // signals a new batch
+  std::condition_variable done_cv_;             // signals the end of a batch
+  std::mutex submit_;                           // serialises batches from different callers
+};
+}  // namespace helper
+
+#endif  // THREAD_POOL_H
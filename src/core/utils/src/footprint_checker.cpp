@@ -0,0 +1,380 @@
+/**
+ * *********************************************************
+ *
+ * @file: footprint_checker.cpp
+ * @brief: Footprint collision checker with rasterised masks for discrete headings
+ * @author: Yang Haodong
+ * @date: 2024-10-07
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "footprint_checker.h"
+
+namespace helper
+{
+/**
+ * @brief Construct a new Footprint Checker object
+ * @param headings number of discrete headings
+ */
+FootprintChecker::FootprintChecker(int headings)
+  : headings_(headings)
+  , radius_(0)
+  , rows_(0)
+  , words_(0)
+  , r_in_(0.0)
+  , r_out_(0.0)
+  , nx_(0)
+  , ny_(0)
+  , stride_(0)
+  , hash_(0)
+{
+}
+
+/**
+ * @brief Rasterise the footprint for every discrete heading
+ * @param footprint  footprint vertices in the robot frame, in meters, empty to remove the footprint
+ * @param resolution map resolution, in meters per cell
+ */
+void FootprintChecker::setFootprint(const Polygon& footprint, double resolution)
+{
+  if (footprint.empty())
+  {
+    *this = FootprintChecker(headings_);
+    return;
+  }
+
+  Polygon cells;
+  for (const auto& p : footprint)
+    cells.emplace_back(p.first / resolution, p.second / resolution);
+
+  // circumscribed radius from the farthest vertex, inscribed radius from the closest edge
+  r_out_ = 0.0;
+  r_in_ = cells.size() < 3 ? 0.0 : std::numeric_limits<double>::max();
+  for (size_t i = 0; i < cells.size(); i++)
+  {
+    const auto& a = cells[i];
+    const auto& b = cells[(i + 1) % cells.size()];
+    r_out_ = std::max(r_out_, std::hypot(a.first, a.second));
+
+    const double ex = b.first - a.first, ey = b.second - a.second;
+    const double len2 = ex * ex + ey * ey;
+    const double s = len2 > 0 ? std::min(1.0, std::max(0.0, -(a.first * ex + a.second * ey) / len2)) : 0.0;
+    if (cells.size() >= 3)
+      r_in_ = std::min(r_in_, std::hypot(a.first + s * ex, a.second + s * ey));
+  }
+
+  radius_ = static_cast<int>(std::ceil(r_out_));
+  rows_ = 2 * radius_ + 1;
+  words_ = (rows_ + 63) / 64;
+  masks_.assign(static_cast<size_t>(headings_) * rows_ * words_, 0);
+  for (int h = 0; h < headings_; h++)
+    _rasterise(cells, 2.0 * M_PI * h / headings_, &masks_[static_cast<size_t>(h) * rows_ * words_]);
+
+  // the padding of the bitmap follows the mask size
+  nx_ = ny_ = 0;
+  map_.clear();
+  clear_.clear();
+  hash_ = 0;
+}
+
+/**
+ * @brief Rebuild the obstacle bitmap and the clearance map if the map changed since the last update, so it may be
+ *        called before every query
+ * @param charmap   map costs, nx * ny cells
+ * @param nx        map size in cells along x
+ * @param ny        map size in cells along y
+ * @param threshold cells with a cost greater or equal to it are obstacles. Planners which check the centre cell
+ *                  against the inflated costmap pass the lethal cost, the footprint only collides with obstacles
+ * @return true if rebuilt, false if the map is unchanged or no footprint is set
+ */
+bool FootprintChecker::update(const unsigned char* charmap, int nx, int ny, unsigned char threshold)
+{
+  if (!valid())
+    return false;
+
+  // hashing the map is a single pass without writes, far cheaper than the bitmap and the distance transform
+  const std::uint64_t hash = _hash(charmap, nx, ny, threshold);
+  if (hash == hash_)
+    return false;
+  hash_ = hash;
+
+  nx_ = nx;
+  ny_ = ny;
+  stride_ = (nx + 2 * radius_ + 63) / 64 + 1;
+
+  // padding rows are obstacles, padding columns are set below together with the obstacles of each row
+  map_.assign(static_cast<size_t>(ny + 2 * radius_) * stride_, ~0ULL);
+  for (int y = 0; y < ny; y++)
+  {
+    std::uint64_t* row = &map_[static_cast<size_t>(y + radius_) * stride_];
+    std::fill(row, row + stride_, 0ULL);
+    for (int b = 0; b < radius_; b++)
+      row[b >> 6] |= 1ULL << (b & 63);
+    for (int b = nx + radius_; b < 64 * stride_; b++)
+      row[b >> 6] |= 1ULL << (b & 63);
+
+    const unsigned char* costs = charmap + static_cast<size_t>(y) * nx;
+    for (int x = 0; x < nx; x++)
+    {
+      if (costs[x] >= threshold)
+      {
+        const int b = x + radius_;
+        row[b >> 6] |= 1ULL << (b & 63);
+      }
+    }
+  }
+
+  _updateClearance(charmap, threshold);
+  return true;
+}
+
+/**
+ * @brief Check whether the footprint at a pose overlaps an obstacle or leaves the map
+ * @param mx    map x of the robot, in cells
+ * @param my    map y of the robot, in cells
+ * @param theta heading of the robot, in radians
+ * @return true if the pose collides, else false
+ */
+bool FootprintChecker::collides(double mx, double my, double theta) const
+{
+  if ((mx < 0) || (my < 0) || (mx >= nx_) || (my >= ny_))
+    return true;
+  const int cx = static_cast<int>(mx), cy = static_cast<int>(my);
+
+  // no obstacle in the square of the masks, or one inside the inscribed circle
+  const int clearance = clear_[static_cast<size_t>(cy + 1) * (nx_ + 2) + cx + 1];
+  if (clearance > radius_)
+    return false;
+  if (clearance * M_SQRT2 < r_in_)
+    return true;
+
+  // mask row i covers map row cy - radius_ + i, which is padded row cy + i, starting at padded column cx
+  const std::uint64_t* mask = &masks_[static_cast<size_t>(heading(theta)) * rows_ * words_];
+  const std::uint64_t* row = &map_[static_cast<size_t>(cy) * stride_];
+  for (int i = 0; i < rows_; i++, row += stride_, mask += words_)
+  {
+    for (int w = 0; w < words_; w++)
+    {
+      const int b = cx + 64 * w, s = b & 63;
+      std::uint64_t bits = row[b >> 6] >> s;
+      if (s)
+        bits |= row[(b >> 6) + 1] << (64 - s);
+      if (bits & mask[w])
+        return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Check the footprint facing along a segment of a path every spacing(), a path is checked segment by
+ *        segment with the offset carried over so that the checks keep their spacing across the vertices
+ * @param x0     map x of the segment start, in cells
+ * @param y0     map y of the segment start, in cells
+ * @param x1     map x of the segment end, in cells
+ * @param y1     map y of the segment end, in cells
+ * @param offset distance from the segment start to the first check, on return the one of the next segment,
+ *               0 for the first segment of a path
+ * @return true if a check collides, false if none does or no footprint is set
+ */
+bool FootprintChecker::sweep(double x0, double y0, double x1, double y1, double& offset) const
+{
+  const double dx = x1 - x0, dy = y1 - y0;
+  const double length = std::hypot(dx, dy);
+  if (!valid() || (length <= 0))
+    return false;
+
+  // the offset keeps advancing after a collision, the following segments stay on the spacing
+  const double theta = std::atan2(dy, dx), step = spacing();
+  bool collision = false;
+  for (; offset <= length; offset += step)
+    collision = collision || collides(x0 + offset / length * dx, y0 + offset / length * dy, theta);
+  offset -= length;
+  return collision;
+}
+
+/**
+ * @brief Discrete heading of an angle, the one whose mask is used for it
+ * @param theta angle in radians
+ * @return heading index in [0, headings)
+ */
+int FootprintChecker::heading(double theta) const
+{
+  // nearest discrete heading
+  const double two_pi = 2.0 * M_PI;
+  double r = std::fmod(theta + M_PI / headings_, two_pi);
+  if (r < 0)
+    r += two_pi;
+  int h = static_cast<int>(r * headings_ / two_pi);
+  return h < headings_ ? h : 0;
+}
+
+/**
+ * @brief Whether a footprint has been set
+ */
+bool FootprintChecker::valid() const
+{
+  return !masks_.empty();
+}
+
+/**
+ * @brief Get the inscribed and circumscribed radius of the footprint, in cells
+ */
+double FootprintChecker::inscribedRadius() const
+{
+  return r_in_;
+}
+
+double FootprintChecker::circumscribedRadius() const
+{
+  return r_out_;
+}
+
+/**
+ * @brief Get the longest step between two footprint checks along a path, half the inscribed radius so that no
+ *        obstacle cell slips between them, but at least a cell as the masks are rasterised per cell
+ * @return step in cells
+ */
+double FootprintChecker::spacing() const
+{
+  return std::max(1.0, 0.5 * r_in_);
+}
+
+/**
+ * @brief Rasterise the footprint rotated by an angle into the masks of a heading
+ * @param footprint  footprint vertices in cells
+ * @param theta      rotation in radians
+ * @param mask       mask rows of the heading, rows_ * words_ words
+ */
+void FootprintChecker::_rasterise(const Polygon& footprint, double theta, std::uint64_t* mask) const
+{
+  auto set = [&](int dx, int dy) {
+    if ((std::abs(dx) > radius_) || (std::abs(dy) > radius_))
+      return;
+    const int col = dx + radius_;
+    mask[(dy + radius_) * words_ + (col >> 6)] |= 1ULL << (col & 63);
+  };
+
+  Polygon rotated;
+  const double c = std::cos(theta), s = std::sin(theta);
+  for (const auto& p : footprint)
+    rotated.emplace_back(c * p.first - s * p.second, s * p.first + c * p.second);
+
+  // the robot cell and every cell whose centre lies inside the polygon
+  set(0, 0);
+  const size_t n = rotated.size();
+  for (int dy = -radius_; dy <= radius_; dy++)
+  {
+    for (int dx = -radius_; dx <= radius_; dx++)
+    {
+      bool inside = false;
+      for (size_t i = 0, j = n - 1; (n >= 3) && (i < n); j = i++)
+      {
+        const auto& a = rotated[i];
+        const auto& b = rotated[j];
+        if (((a.second > dy) != (b.second > dy)) &&
+            (dx < (b.first - a.first) * (dy - a.second) / (b.second - a.second) + a.first))
+          inside = !inside;
+      }
+      if (inside)
+        set(dx, dy);
+    }
+  }
+
+  // every cell the outline passes through, so that thin footprints keep their edges
+  for (size_t i = 0; i < n; i++)
+  {
+    const auto& a = rotated[i];
+    const auto& b = rotated[(i + 1) % n];
+    const double length = std::hypot(b.first - a.first, b.second - a.second);
+    const int steps = std::max(1, static_cast<int>(std::ceil(4.0 * length)));
+    for (int k = 0; k <= steps; k++)
+    {
+      const double x = a.first + (b.first - a.first) * k / steps, y = a.second + (b.second - a.second) * k / steps;
+      set(static_cast<int>(std::lround(x)), static_cast<int>(std::lround(y)));
+    }
+  }
+}
+
+/**
+ * @brief Chessboard distance transform of the obstacle cells, the map border counts as an obstacle
+ * @param charmap   map costs, nx * ny cells
+ * @param threshold cells with a cost greater or equal to it are obstacles
+ */
+void FootprintChecker::_updateClearance(const unsigned char* charmap, unsigned char threshold)
+{
+  // a ring of zero cells around the map stands for the border, distances beyond the mask size are never looked at
+  const int w = nx_ + 2;
+  const std::uint8_t cap = static_cast<std::uint8_t>(std::min(255, radius_ + 1));
+  clear_.assign(static_cast<size_t>(w) * (ny_ + 2), 0);
+
+  // forward pass from the neighbours above and to the left
+  for (int y = 0; y < ny_; y++)
+  {
+    const unsigned char* costs = charmap + static_cast<size_t>(y) * nx_;
+    std::uint8_t* row = &clear_[static_cast<size_t>(y + 1) * w + 1];
+    const std::uint8_t* up = row - w;
+    for (int x = 0; x < nx_; x++)
+    {
+      if (costs[x] >= threshold)
+        continue;
+      const int d = std::min({ row[x - 1], up[x - 1], up[x], up[x + 1] }) + 1;
+      row[x] = std::min(static_cast<std::uint8_t>(d), cap);
+    }
+  }
+
+  // backward pass from the neighbours below and to the right
+  for (int y = ny_ - 1; y >= 0; y--)
+  {
+    std::uint8_t* row = &clear_[static_cast<size_t>(y + 1) * w + 1];
+    const std::uint8_t* down = row + w;
+    for (int x = nx_ - 1; x >= 0; x--)
+    {
+      const int d = std::min({ row[x + 1], down[x - 1], down[x], down[x + 1] }) + 1;
+      if (d < row[x])
+        row[x] = static_cast<std::uint8_t>(d);
+    }
+  }
+}
+
+/**
+ * @brief FNV-1a hash of the map, its size and the obstacle threshold
+ * @param charmap   map costs, nx * ny cells
+ * @param nx        map size in cells along x
+ * @param ny        map size in cells along y
+ * @param threshold cells with a cost greater or equal to it are obstacles
+ * @return hash, never 0
+ */
+std::uint64_t FootprintChecker::_hash(const unsigned char* charmap, int nx, int ny, unsigned char threshold)
+{
+  // eight cells at a time
+  std::uint64_t h = 0xcbf29ce484222325ULL;
+  auto mix = [&h](std::uint64_t word) { h = (h ^ word) * 0x100000001b3ULL; };
+  mix(static_cast<std::uint64_t>(nx));
+  mix(static_cast<std::uint64_t>(ny));
+  mix(threshold);
+
+  const size_t size = static_cast<size_t>(nx) * ny;
+  size_t i = 0;
+  for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t))
+  {
+    std::uint64_t word;
+    std::memcpy(&word, charmap + i, sizeof(word));
+    mix(word);
+  }
+  for (; i < size; i++)
+    mix(charmap[i]);
+  return h ? h : 1;
+}
+}  // namespace helper
@@ -0,0 +1,210 @@
+/**
+ * *********************************************************
+ *
+ * @file: thread_pool.cpp
+ * @brief: Persistent work-stealing thread pool for data parallel batches
+ * @author: Yang Haodong
+ * @date: 2024-09-25
+ * @version: 1.0
+ *
+ * Copyright (c) 2024, Yang Haodong.
+ * All rights reserved.
+ *
+ * --------------------------------------------------------
+ *
+ * ********************************************************
+ */
+#include <algorithm>
+
+#include "thread_pool.h"
+
+namespace helper
+{
+namespace
+{
+// worker index of the current thread inside a batch, -1 outside
+thread_local int current_worker = -1;
+}  // namespace
+
+/**
+ * @brief Construct a new Thread Pool object
+ * @param n_threads number of workers including the calling thread, 0 for the hardware concurrency
+ */
+ThreadPool::ThreadPool(int n_threads) : task_(nullptr), active_(0), generation_(0), stop_(false)
+{
+  if (n_threads <= 0)
+    n_threads = static_cast<int>(std::thread::hardware_concurrency());
+  n_threads_ = std::max(n_threads, 1);
+
+  for (int i = 0; i < n_threads_; i++)
+    ranges_.emplace_back(new Range());
+  for (int i = 1; i < n_threads_; i++)
+    threads_.emplace_back(&ThreadPool::_workerLoop, this, i);
+}
+
+/**
+ * @brief Destroy the Thread Pool object, joining all workers
+ */
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_cv_.notify_all();
+  for (auto& t : threads_)
+    t.join();
+}
+
+/**
+ * @brief Process-wide pool shared by the planners
+ * @return the shared pool
+ */
+ThreadPool& ThreadPool::instance()
+{
+  static ThreadPool pool;
+  return pool;
+}
+
+/**
+ * @brief Get the number of workers including the calling thread
+ * @return workers number
+ */
+int ThreadPool::size() const
+{
+  return n_threads_;
+}
+
+/**
+ * @brief Run task(i, worker) for every i in [0, n) and block until all tasks finished.
+ *        Calls from inside a task run serially on the calling worker.
+ * @param n    number of tasks
+ * @param task task to run
+ */
+void ThreadPool::parallelFor(int n, const Task& task)
+{
+  if (n <= 0)
+    return;
+
+  // nested batch or nothing to share
+  if (current_worker >= 0 || n_threads_ == 1 || n == 1)
+  {
+    const int outer = current_worker;
+    current_worker = std::max(outer, 0);
+    for (int i = 0; i < n; i++)
+      task(i, current_worker);
+    current_worker = outer;
+    return;
+  }
+
+  std::lock_guard<std::mutex> submit(submit_);
+
+  // contiguous initial partition, the tail is balanced by stealing
+  for (int w = 0; w < n_threads_; w++)
+  {
+    std::lock_guard<std::mutex> lock(ranges_[w]->lock);
+    ranges_[w]->begin = static_cast<int>(static_cast<long>(n) * w / n_threads_);
+    ranges_[w]->end = static_cast<int>(static_cast<long>(n) * (w + 1) / n_threads_);
+  }
+
+  active_ = n_threads_ - 1;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    generation_++;
+  }
+  start_cv_.notify_all();
+
+  current_worker = 0;
+  _runBatch(0);
+  current_worker = -1;
+
+  // every worker has to leave the batch before task_ and ranges_ can be reused
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [this] { return active_ == 0; });
+  task_ = nullptr;
+}
+
+/**
+ * @brief Worker thread main loop
+ * @param worker worker index
+ */
+void ThreadPool::_workerLoop(int worker)
+{
+  unsigned int seen = 0;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+      if (stop_)
+        return;
+      seen = generation_;
+    }
+
+    current_worker = worker;
+    _runBatch(worker);
+    current_worker = -1;
+
+    if (--active_ == 0)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_cv_.notify_all();
+    }
+  }
+}
+
+/**
+ * @brief Execute tasks of the current batch until no range has work left
+ * @param worker worker index
+ */
+void ThreadPool::_runBatch(int worker)
+{
+  int index;
+  while (_takeTask(worker, index))
+    (*task_)(index, worker);
+}
+
+/**
+ * @brief Take the next task of a worker, stealing from the others if its own range is empty
+ * @param worker worker index
+ * @param index  task index
+ * @return true if a task was taken, else false
+ */
+bool ThreadPool::_takeTask(int worker, int& index)
+{
+  Range& own = *ranges_[worker];
+  {
+    std::lock_guard<std::mutex> lock(own.lock);
+    if (own.begin < own.end)
+    {
+      index = own.begin++;
+      return true;
+    }
+  }
+
+  // steal the back half of another worker's range
+  for (int k = 1; k < n_threads_; k++)
+  {
+    Range& victim = *ranges_[(worker + k) % n_threads_];
+    int begin, end;
+    {
+      std::lock_guard<std::mutex> lock(victim.lock);
+      const int left = victim.end - victim.begin;
+      if (left <= 0)
+        continue;
+      end = victim.end;
+      begin = end - (left + 1) / 2;
+      victim.end = begin;
+    }
+
+    std::lock_guard<std::mutex> lock(own.lock);
+    own.begin = begin + 1;
+    own.end = end;
+    index = begin;
+    return true;
+  }
+
+  return false;
+}
+}  // namespace helper
@@ -1,18 +1,22 @@
 #ifndef _PRIORITYQUEUE2_H_
 #define _PRIORITYQUEUE2_H_
 
+#include <limits.h>
+#include <stddef.h>
+#include <map>
 #include <vector>
-#include <set>
-#include <queue>
 #include <assert.h>
 #include "point.h"
-#include <map>
 
 //! Priority queue for integer coordinates with squared distances as priority.
 /** A priority queue that uses buckets to group elements with the same priority.
  *  The individual buckets are unsorted, which increases efficiency if these groups are large.
  *  The elements are assumed to be integer coordinates, and the priorities are assumed
  *  to be squared Euclidean distances (integers).
+ *  The buckets of the low priorities are a flat array indexed by the priority, each a FIFO over a vector
+ *  which keeps its capacity once emptied, so a warmed-up queue pushes and pops without allocating. The
+ *  array grows to the largest priority pushed, but squared obstacle distances reach sizeX^2 + sizeY^2 on
+ *  an open map, so it stops at DENSE_PRIORITIES and the higher priorities go to sparse buckets in a map.
  */
 
 template <typename T>
@@ -20,16 +24,21 @@ class BucketPrioQueue
 {
 public:
   //! Standard constructor
-  /** Standard constructor. When called for the first time it creates a look up table
-   *  that maps square distances to bucket numbers, which might take some time...
-   */
   BucketPrioQueue();
 
+  //! priorities below it are kept in the flat array, 2 MB of buckets at most
+  static const int DENSE_PRIORITIES = 1 << 16;
+
   void clear()
   {
-    buckets.clear();
+    for (size_t i = 0; i < buckets.size(); i++)
+    {
+      buckets[i].items.clear();
+      buckets[i].head = 0;
+    }
+    sparse.clear();
     count = 0;
-    nextPop = buckets.end();
+    nextPop = INT_MAX;
   }
 
   //! Checks whether the Queue is empty
@@ -45,20 +54,23 @@ public:
   }
   int getNumBuckets()
   {
-    return buckets.size();
+    return buckets.size() + sparse.size();
   }
 
-  int getTopPriority()
-  {
-    return nextPop->first;
-  }
+  //! lowest priority in the queue, which must not be empty
+  int getTopPriority();
 
 private:
-  int count;
+  struct Bucket
+  {
+    std::vector<T> items;  // elements in push order, the ones from head on are queued
+    size_t head = 0;
+  };
 
-  typedef std::map<int, std::queue<T> > BucketType;
-  BucketType buckets;
-  typename BucketType::iterator nextPop;
+  int count;
+  std::vector<Bucket> buckets;   // indexed by priority, below DENSE_PRIORITIES
+  std::map<int, Bucket> sparse;  // non-empty buckets of the priorities from DENSE_PRIORITIES on
+  int nextPop;                   // no bucket below holds an element, INT_MAX if the queue is empty
 };
 
 #include "bucketedqueue.hxx"
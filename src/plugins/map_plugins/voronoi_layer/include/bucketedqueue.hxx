@@ -19,26 +19,55 @@ bool BucketPrioQueue<T>::empty()
 template <class T>
 void BucketPrioQueue<T>::push(int prio, T t)
 {
-  buckets[prio].push(t);
-  if (nextPop == buckets.end() || prio < nextPop->first)
-    nextPop = buckets.find(prio);
+  assert(prio >= 0);
+  if (prio >= DENSE_PRIORITIES)
+    sparse[prio].items.push_back(t);
+  else
+  {
+    if (prio >= static_cast<int>(buckets.size()))
+      buckets.resize(prio + 1);
+    buckets[prio].items.push_back(t);
+  }
+  if (prio < nextPop)
+    nextPop = prio;
   count++;
 }
 
 template <class T>
 T BucketPrioQueue<T>::pop()
 {
-  while (nextPop != buckets.end() && nextPop->second.empty())
-    ++nextPop;
-
-  T p = nextPop->second.front();
-  nextPop->second.pop();
-  if (nextPop->second.empty())
+  int prio = getTopPriority();
+  T p;
+  if (prio < DENSE_PRIORITIES)
+  {
+    Bucket& b = buckets[prio];
+    p = b.items[b.head++];
+    if (b.head == b.items.size())
+    {
+      b.items.clear();
+      b.head = 0;
+    }
+  }
+  else
   {
-    typename BucketType::iterator it = nextPop;
-    nextPop++;
-    buckets.erase(it);
+    // a sparse bucket is dropped once empty, the first one left holds the lowest priority
+    auto it = sparse.begin();
+    p = it->second.items[it->second.head++];
+    if (it->second.head == it->second.items.size())
+      sparse.erase(it);
   }
   count--;
+  if (count == 0)
+    nextPop = INT_MAX;
   return p;
 }
+
+template <class T>
+int BucketPrioQueue<T>::getTopPriority()
+{
+  while (nextPop < static_cast<int>(buckets.size()) && buckets[nextPop].head == buckets[nextPop].items.size())
+    ++nextPop;
+  if (nextPop >= static_cast<int>(buckets.size()))
+    nextPop = sparse.begin()->first;
+  return nextPop;
+}
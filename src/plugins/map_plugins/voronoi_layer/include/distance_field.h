@@ -0,0 +1,83 @@
+/******************************************************************************
+ * Copyright (c) 2023, NKU Mobile & Flying Robotics Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "costmap_2d/costmap_2d_ros.h"
+#include "voronoi_buffers.h"
+#include "voronoi_layer.h"
+
+namespace costmap_2d
+{
+//! Euclidean distance field of a costmap, shared by the planners and controllers working on it. It follows the
+//! diagram of the Voronoi layer of the costmap if one is loaded, else it keeps an incremental distance transform of
+//! its own over the lethal cells, brought in step with the costmap by update(). Distances and their gradients are
+//! queried from a snapshot, taken without locking and unchanged while held.
+class DistanceField
+{
+public:
+  explicit DistanceField(costmap_2d::Costmap2DROS* costmap_ros);
+
+  //! field shared by all users of a costmap, created on first use
+  static std::shared_ptr<DistanceField> instance(costmap_2d::Costmap2DROS* costmap_ros);
+
+  //! bring the own transform in step with the costmap, nothing to do when following the Voronoi layer. Snapshots
+  //! older than the latest one are waited for to be released. Returns the version of the latest snapshot
+  std::uint64_t update();
+  //! latest snapshot, nullptr before the first one
+  std::shared_ptr<const VoronoiBuffer> snapshot() const;
+  //! whether the field follows the Voronoi layer
+  bool followsLayer() const
+  {
+    return static_cast<bool>(layer_);
+  }
+
+private:
+  costmap_2d::Costmap2DROS* costmap_ros_;
+  boost::shared_ptr<VoronoiLayer> layer_;  // layer followed if loaded
+
+  // own transform, guarded by mutex_ between its users
+  std::mutex mutex_;
+  VoronoiBuffers buffers_;
+  std::vector<unsigned char> map_;  // char map as of the latest snapshot
+  std::vector<CellChange> changes_;
+  unsigned int size_x_ = 0;
+  unsigned int size_y_ = 0;
+};
+
+}  // namespace costmap_2d
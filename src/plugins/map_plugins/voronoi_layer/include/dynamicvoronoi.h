@@ -51,6 +51,9 @@ public:
   int getObstacleY(int x, int y) const;
   //! returns whether the specified cell is part of the (pruned) Voronoi graph
   bool isVoronoi(int x, int y) const;
+  //! bounding box of the cells whose distance or Voronoi state may have changed by initialization, update() or
+  //! prune() since the last call, which starts a new box. The box is empty (minX > maxX) if nothing changed
+  void takeChangedArea(int& minX, int& minY, int& maxX, int& maxY);
   //! checks whether the specficied location is occupied
   bool isOccupied(int x, int y) const;
   //! write the current distance map and voronoi diagram as ppm file
@@ -68,15 +71,16 @@ public:
   }
 
 private:
+  //! 16 bytes, obstacle coordinates fit in a short as they stay below invalidObstData
   struct dataCell
   {
     float dist;
+    int sqdist;
+    short obstX;
+    short obstY;
     char voronoi;
     char queueing;
-    int obstX;
-    int obstY;
     bool needsRaise;
-    int sqdist;
   };
 
   typedef enum
@@ -114,8 +118,9 @@ private:
   void recheckVoro();
   void commitAndColorize(bool updateRealDist = true);
   inline void reviveVoroNeighbors(int& x, int& y);
+  inline void markChanged(int x, int y, int margin);
 
-  inline bool isOccupied(int& x, int& y, dataCell& c);
+  inline bool isOccupied(int x, int y, const dataCell& c) const;
   inline markerMatchResult markerMatch(int x, int y);
   inline bool markerMatchAlternative(int x, int y);
   inline int getVoronoiPruneValence(int x, int y);
@@ -130,12 +135,12 @@ private:
   std::vector<INTPOINT> addList;
   std::vector<INTPOINT> lastObstacles;
 
-  // maps
+  // maps, row-major: cell (x, y) at x + y * sizeX
   int sizeY;
   int sizeX;
-  dataCell** data;
-  bool** gridMap;
-  bool allocatedGridMap;
+  dataCell* data;
+  bool* gridMap;
+  int changedMinX, changedMinY, changedMaxX, changedMaxY;
 
   // parameters
   int padding;
@@ -0,0 +1,110 @@
+/******************************************************************************
+ * Copyright (c) 2023, NKU Mobile & Flying Robotics Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "dynamicvoronoi.h"
+#include "voronoi_skeleton.h"
+
+namespace costmap_2d
+{
+//! A completed Voronoi diagram and its skeleton graph. It is never written while a reader holds it.
+struct VoronoiBuffer
+{
+  DynamicVoronoi voronoi;
+  VoronoiSkeleton skeleton;
+  std::uint64_t version = 0;  // number of occupancy batches computed up to this diagram
+  double resolution = 0.0;    // geometry of the map the diagram was computed for
+  double origin_x = 0.0;
+  double origin_y = 0.0;
+
+  //! distance to the closest obstacle in meters at a world point, bilinear between cell centres. It is 0 within
+  //! obstacles and infinite on a map without any, points off the map take the distance next to its border
+  double distance(double wx, double wy) const;
+  //! same, with the gradient of the distance, zero where the distance is infinite
+  double distance(double wx, double wy, double& grad_x, double& grad_y) const;
+};
+
+//! occupancy change of one cell, index x + y * size_x
+struct CellChange
+{
+  int index;
+  bool occupied;
+};
+
+//! Two diagram buffers written in turn. apply() brings the back buffer up to date with a batch of changes and
+//! publishes it, readers take the published one without locking and may hold it as long as they need.
+class VoronoiBuffers
+{
+public:
+  //! with_skeleton: keep the pruned diagram and its skeleton graph as well, else the distances only
+  explicit VoronoiBuffers(bool with_skeleton = true);
+
+  //! start over with empty buffers of a map size, readers keep the old ones
+  void reset(int size_x, int size_y);
+  //! bring the back buffer up to date with a batch and publish it, after a reset() to the size of the changes.
+  //! The area whose distances or diagram changed is returned, empty (min_x > max_x) if none did
+  void apply(const std::vector<CellChange>& changes, double resolution, double origin_x, double origin_y, int& min_x,
+             int& min_y, int& max_x, int& max_y);
+
+  //! latest published buffer, nullptr before the first one
+  std::shared_ptr<const VoronoiBuffer> front() const;
+  //! version of the latest published buffer, 0 before the first one
+  std::uint64_t version() const;
+
+private:
+  //! buffer released once no reader holds its last publication any more
+  struct BufferSlot
+  {
+    VoronoiBuffer buffer;
+    std::atomic<bool> released{ true };
+  };
+
+  bool with_skeleton_;
+  int size_x_ = 0;
+  int size_y_ = 0;
+
+  // slots_[back_] is the one written next, the other one is published unless no diagram is done yet
+  std::shared_ptr<BufferSlot> slots_[2];
+  std::vector<CellChange> lag_[2];              // changes the other buffer got since this one was last written
+  std::vector<unsigned char> target_;           // state a cell is set to by the batch, 0 untouched, 1 free, 2 occupied
+  std::vector<int> touched_;                    // cells touched by the batch
+  int back_ = 0;
+  std::uint64_t version_ = 0;
+  std::shared_ptr<const VoronoiBuffer> front_;  // only accessed through std::atomic_load and std::atomic_store
+};
+
+}  // namespace costmap_2d
@@ -31,7 +31,10 @@
 
 #pragma once
 
+#include <climits>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 #include <boost/thread.hpp>
 
@@ -40,37 +43,70 @@
 #include "costmap_2d/layer.h"
 #include "costmap_2d/layered_costmap.h"
 #include "dynamic_reconfigure/server.h"
-#include "dynamicvoronoi.h"
+#include "voronoi_buffers.h"
 #include "nav_msgs/OccupancyGrid.h"
 #include "ros/ros.h"
 
 namespace costmap_2d
 {
+//! Keeps the Voronoi diagram of the master grid. The costmap update only extracts the occupancy changes within its
+//! bounds and hands them to a worker thread, which brings the diagram buffers up to date.
 class VoronoiLayer : public Layer
 {
 public:
   VoronoiLayer() = default;
-  virtual ~VoronoiLayer() = default;
+  virtual ~VoronoiLayer();
 
   void onInitialize() override;
   void updateBounds(double robot_x, double robot_y, double robot_yaw, double* min_x, double* min_y, double* max_x,
                     double* max_y) override;
   void updateCosts(costmap_2d::Costmap2D& master_grid, int min_i, int min_j, int max_i, int max_j) override;
-  const DynamicVoronoi& getVoronoi() const;
-  boost::mutex& getMutex();
+  //! latest completed diagram without locking, nullptr before the first one. It stays unchanged while held
+  std::shared_ptr<const VoronoiBuffer> getVoronoiBuffer() const;
+  //! version of the latest completed diagram, 0 before the first one
+  std::uint64_t getVersion() const;
 
 private:
-  void publishVoronoiGrid(const costmap_2d::Costmap2D& master_grid);
+  void workerLoop();
+  void publishVoronoiGrid(const VoronoiBuffer& buffer, int min_x, int min_y, int max_x, int max_y);
   void outlineMap(unsigned char* costarr, int nx, int ny, unsigned char value);
 
   void reconfigureCB(const costmap_2d::GenericPluginConfig& config, uint32_t level);
   std::unique_ptr<dynamic_reconfigure::Server<costmap_2d::GenericPluginConfig>> dsrv_ = nullptr;
   ros::Publisher voronoi_grid_pub_;
 
-  DynamicVoronoi voronoi_;
+  // costmap side
+  std::vector<unsigned char> occupied_;  // occupancy handed to the worker so far
+  std::vector<CellChange> changes_;      // changes extracted in one update
   unsigned int last_size_x_ = 0;
   unsigned int last_size_y_ = 0;
-  boost::mutex mutex_;
+  double last_origin_x_ = 0.0;
+  double last_origin_y_ = 0.0;
+  //! the whole master grid is diffed on the next update, after initialization, resizing, moving or re-enabling
+  bool full_update_ = true;
+
+  // hand-over to the worker, guarded by queue_mutex_
+  boost::mutex queue_mutex_;
+  boost::condition_variable queue_cond_;
+  std::vector<CellChange> queued_;  // changes not yet taken by the worker
+  bool queued_reset_ = false;       // the worker starts over with empty diagrams of the queued size
+  int queued_size_x_ = 0;
+  int queued_size_y_ = 0;
+  double queued_resolution_ = 0.0;
+  double queued_origin_x_ = 0.0;
+  double queued_origin_y_ = 0.0;
+  bool stop_ = false;
+  boost::thread worker_;
+
+  // worker side
+  VoronoiBuffers buffers_;
+
+  //! the published grid is refreshed within the changed area only, and sent at most publish_frequency_ times a second
+  nav_msgs::OccupancyGrid voronoi_grid_;
+  double publish_frequency_ = 1.0;
+  ros::WallTime last_publish_time_;
+  unsigned int last_subscribers_ = 0;
+  int pending_min_x_ = INT_MAX, pending_min_y_ = INT_MAX, pending_max_x_ = INT_MIN, pending_max_y_ = INT_MIN;
 };
 
 }  // namespace costmap_2d
@@ -0,0 +1,135 @@
+/******************************************************************************
+ * Copyright (c) 2023, NKU Mobile & Flying Robotics Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "dynamicvoronoi.h"
+
+namespace costmap_2d
+{
+//! Sparse graph of a pruned Voronoi diagram. A cell of the diagram whose ring of eight neighbours holds other than
+//! two runs of diagram cells, or more than three of them, is a node (a junction, an end point or part of a clump).
+//! The chains of cells between two nodes are edges. The graph is kept in step with the diagram by re-tracing only the
+//! edges around cells which joined or left it.
+class VoronoiSkeleton
+{
+public:
+  struct Node
+  {
+    int x, y;                // cell of the node
+    std::vector<int> edges;  // incident edges, a self loop once
+    bool alive;              // false if the slot is free
+  };
+
+  struct Edge
+  {
+    int from, to;            // end nodes
+    std::vector<int> cells;  // cell indices between the end nodes, ordered from `from` to `to`
+    double length;           // length from `from` to `to` in cells, staircase corners cut
+    float clearance;         // smallest obstacle distance along the edge and its end nodes in cells
+    bool alive;              // false if the slot is free
+  };
+
+  VoronoiSkeleton() = default;
+
+  //! bring the graph in step with the diagram, rebuilding it from scratch if the map size changed
+  void update(const DynamicVoronoi& voronoi);
+  //! same, for a diagram which may only have changed within the box [min_x, max_x] x [min_y, max_y]
+  void update(const DynamicVoronoi& voronoi, int min_x, int min_y, int max_x, int max_y);
+
+  //! node at a cell, -1 if the cell is no node
+  int nodeAt(int x, int y) const;
+  //! edge through a cell, -1 if the cell is no inner cell of an edge
+  int edgeAt(int x, int y) const;
+
+  const std::vector<Node>& nodes() const
+  {
+    return nodes_;
+  }
+  const std::vector<Edge>& edges() const
+  {
+    return edges_;
+  }
+  //! number of live nodes and edges
+  int numNodes() const;
+  int numEdges() const;
+  //! number of cells re-traced by the last update
+  int lastUpdateCells() const
+  {
+    return last_update_cells_;
+  }
+
+  int getSizeX() const
+  {
+    return size_x_;
+  }
+  int getSizeY() const
+  {
+    return size_y_;
+  }
+
+private:
+  void addCandidate(int c);
+  void removeEdge(int e);
+  void removeNode(int n);
+  int addNode(int c);
+  void traceFrom(int n);
+  void refreshClearance(int e);
+  //! membership of the eight neighbours in ring order, returns whether the cell is an inner cell of a chain
+  bool chain(int c, bool* in) const;
+  //! next cell of a chain cell coming from prev, -1 if the cell is no chain cell
+  int forward(int c, int prev) const;
+
+  int size_x_ = 0;
+  int size_y_ = 0;
+  std::vector<unsigned char> member_;  // whether a cell is part of the diagram
+  std::vector<int> owner_;             // -1 none, >= 0 edge through the cell, <= -2 node -(id + 2) at the cell
+  std::vector<Node> nodes_;
+  std::vector<Edge> edges_;
+  std::vector<int> free_nodes_;
+  std::vector<int> free_edges_;
+  int num_nodes_ = 0;
+  int num_edges_ = 0;
+
+  // scratch of an update
+  const DynamicVoronoi* voronoi_ = nullptr;
+  std::vector<int> candidates_;      // cells whose membership, degree or edge changed
+  std::vector<std::uint32_t> mark_;  // update which last listed a cell as candidate
+  std::uint32_t epoch_ = 0;
+  std::vector<int> seeds_;    // nodes which lost edges
+  std::vector<int> refresh_;  // edges through the box whose cells may have a new obstacle distance
+  int last_update_cells_ = 0;
+};
+
+}  // namespace costmap_2d
@@ -0,0 +1,142 @@
+/******************************************************************************
+ * Copyright (c) 2023, NKU Mobile & Flying Robotics Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+
+#include "distance_field.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+namespace costmap_2d
+{
+namespace
+{
+constexpr int kDiffBlock = 64;  // bytes compared at once when diffing the char map
+}  // namespace
+
+DistanceField::DistanceField(costmap_2d::Costmap2DROS* costmap_ros) : costmap_ros_(costmap_ros), buffers_(false)
+{
+  std::vector<boost::shared_ptr<Layer>>* plugins = costmap_ros_->getLayeredCostmap()->getPlugins();
+  for (auto layer = plugins->begin(); layer != plugins->end(); ++layer)
+  {
+    layer_ = boost::dynamic_pointer_cast<VoronoiLayer>(*layer);
+    if (layer_)
+    {
+      break;
+    }
+  }
+}
+
+std::shared_ptr<DistanceField> DistanceField::instance(costmap_2d::Costmap2DROS* costmap_ros)
+{
+  static std::mutex registry_mutex;
+  static std::map<costmap_2d::Costmap2DROS*, std::weak_ptr<DistanceField>> registry;
+
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  std::shared_ptr<DistanceField> field = registry[costmap_ros].lock();
+  if (!field)
+  {
+    field = std::make_shared<DistanceField>(costmap_ros);
+    registry[costmap_ros] = field;
+  }
+  return field;
+}
+
+std::uint64_t DistanceField::update()
+{
+  if (layer_)
+  {
+    return layer_->getVersion();
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  Costmap2D* costmap = costmap_ros_->getCostmap();
+  std::unique_lock<Costmap2D::mutex_t> costmap_lock(*costmap->getMutex());
+
+  // a new size starts over, every lethal cell is a change
+  const unsigned int size_x = costmap->getSizeInCellsX();
+  const unsigned int size_y = costmap->getSizeInCellsY();
+  const bool reset = size_x != size_x_ || size_y != size_y_;
+  if (reset)
+  {
+    size_x_ = size_x;
+    size_y_ = size_y;
+    map_.assign(size_x * size_y, FREE_SPACE);
+    buffers_.reset(size_x, size_y);
+  }
+
+  // a cell changes if it became lethal or stopped being lethal, blocks without any changed byte are skipped
+  const unsigned char* costs = costmap->getCharMap();
+  unsigned char* map = map_.data();
+  const int size = static_cast<int>(size_x * size_y);
+  changes_.clear();
+  for (int i = 0; i < size; i += kDiffBlock)
+  {
+    const int end = std::min(i + kDiffBlock, size);
+    if (end - i == kDiffBlock && std::memcmp(costs + i, map + i, kDiffBlock) == 0)
+    {
+      continue;
+    }
+    for (int j = i; j < end; j++)
+    {
+      if (costs[j] != map[j])
+      {
+        if ((costs[j] == LETHAL_OBSTACLE) != (map[j] == LETHAL_OBSTACLE))
+        {
+          changes_.push_back({ j, costs[j] == LETHAL_OBSTACLE });
+        }
+        map[j] = costs[j];
+      }
+    }
+  }
+  const double resolution = costmap->getResolution();
+  const double origin_x = costmap->getOriginX();
+  const double origin_y = costmap->getOriginY();
+  costmap_lock.unlock();
+
+  // a moved map without changed cells only needs its new geometry
+  const std::shared_ptr<const VoronoiBuffer> front = buffers_.front();
+  if (reset || !changes_.empty() || front->resolution != resolution || front->origin_x != origin_x ||
+      front->origin_y != origin_y)
+  {
+    int min_x, min_y, max_x, max_y;
+    buffers_.apply(changes_, resolution, origin_x, origin_y, min_x, min_y, max_x, max_y);
+  }
+  return buffers_.version();
+}
+
+std::shared_ptr<const VoronoiBuffer> DistanceField::snapshot() const
+{
+  return layer_ ? layer_->getVoronoiBuffer() : buffers_.front();
+}
+
+}  // namespace costmap_2d
@@ -1,42 +1,34 @@
 #include "dynamicvoronoi.h"
 
 #include <math.h>
+#include <algorithm>
 #include <iostream>
 
 DynamicVoronoi::DynamicVoronoi()
 {
   sqrt2 = sqrt(2.0);
+  sizeX = sizeY = 0;
   data = NULL;
   gridMap = NULL;
   alternativeDiagram = NULL;
-  allocatedGridMap = false;
+  changedMinX = changedMinY = INT_MAX;
+  changedMaxX = changedMaxY = INT_MIN;
 }
 
 DynamicVoronoi::~DynamicVoronoi()
 {
-  if (data)
-  {
-    for (int x = 0; x < sizeX; x++)
-      delete[] data[x];
-    delete[] data;
-  }
-  if (allocatedGridMap && gridMap)
+  delete[] data;
+  delete[] gridMap;
+  if (alternativeDiagram)
   {
     for (int x = 0; x < sizeX; x++)
-      delete[] gridMap[x];
-    delete[] gridMap;
+      delete[] alternativeDiagram[x];
+    delete[] alternativeDiagram;
   }
 }
 
 void DynamicVoronoi::initializeEmpty(int _sizeX, int _sizeY, bool initGridMap)
 {
-  if (data)
-  {
-    for (int x = 0; x < sizeX; x++)
-      delete[] data[x];
-    delete[] data;
-    data = NULL;
-  }
   if (alternativeDiagram)
   {
     for (int x = 0; x < sizeX; x++)
@@ -44,31 +36,22 @@ void DynamicVoronoi::initializeEmpty(int _sizeX, int _sizeY, bool initGridMap)
     delete[] alternativeDiagram;
     alternativeDiagram = NULL;
   }
-  if (initGridMap)
+
+  // one contiguous row-major block each, reallocated only when the number of cells changes
+  if (!data || _sizeX * _sizeY != sizeX * sizeY)
   {
-    if (allocatedGridMap && gridMap)
-    {
-      for (int x = 0; x < sizeX; x++)
-        delete[] gridMap[x];
-      delete[] gridMap;
-      gridMap = NULL;
-      allocatedGridMap = false;
-    }
+    delete[] data;
+    delete[] gridMap;
+    data = new dataCell[_sizeX * _sizeY];
+    gridMap = new bool[_sizeX * _sizeY];
+    initGridMap = true;
   }
 
   sizeX = _sizeX;
   sizeY = _sizeY;
-  data = new dataCell*[sizeX];
-  for (int x = 0; x < sizeX; x++)
-    data[x] = new dataCell[sizeY];
-
-  if (initGridMap)
-  {
-    gridMap = new bool*[sizeX];
-    for (int x = 0; x < sizeX; x++)
-      gridMap[x] = new bool[sizeY];
-    allocatedGridMap = true;
-  }
+  changedMinX = changedMinY = 0;
+  changedMaxX = sizeX - 1;
+  changedMaxY = sizeY - 1;
 
   dataCell c;
   c.dist = INFINITY;
@@ -78,31 +61,26 @@ void DynamicVoronoi::initializeEmpty(int _sizeX, int _sizeY, bool initGridMap)
   c.voronoi = free;
   c.queueing = fwNotQueued;
   c.needsRaise = false;
-
-  for (int x = 0; x < sizeX; x++)
-    for (int y = 0; y < sizeY; y++)
-      data[x][y] = c;
+  std::fill(data, data + sizeX * sizeY, c);
 
   if (initGridMap)
-  {
-    for (int x = 0; x < sizeX; x++)
-      for (int y = 0; y < sizeY; y++)
-        gridMap[x][y] = 0;
-  }
+    std::fill(gridMap, gridMap + sizeX * sizeY, false);
 }
 
 void DynamicVoronoi::initializeMap(int _sizeX, int _sizeY, bool** _gridMap)
 {
-  gridMap = _gridMap;
   initializeEmpty(_sizeX, _sizeY, false);
+  for (int x = 0; x < sizeX; x++)
+    for (int y = 0; y < sizeY; y++)
+      gridMap[x + y * sizeX] = _gridMap[x][y];
 
   for (int x = 0; x < sizeX; x++)
   {
     for (int y = 0; y < sizeY; y++)
     {
-      if (gridMap[x][y])
+      if (gridMap[x + y * sizeX])
       {
-        dataCell c = data[x][y];
+        dataCell c = data[x + y * sizeX];
         if (!isOccupied(x, y, c))
         {
           bool isSurrounded = true;
@@ -119,7 +97,7 @@ void DynamicVoronoi::initializeMap(int _sizeX, int _sizeY, bool** _gridMap)
               if (ny <= 0 || ny >= sizeY - 1)
                 continue;
 
-              if (!gridMap[nx][ny])
+              if (!gridMap[nx + ny * sizeX])
               {
                 isSurrounded = false;
                 break;
@@ -134,7 +112,7 @@ void DynamicVoronoi::initializeMap(int _sizeX, int _sizeY, bool** _gridMap)
             c.dist = 0;
             c.voronoi = occupied;
             c.queueing = fwProcessed;
-            data[x][y] = c;
+            data[x + y * sizeX] = c;
           }
           else
             setObstacle(x, y);
@@ -146,30 +124,30 @@ void DynamicVoronoi::initializeMap(int _sizeX, int _sizeY, bool** _gridMap)
 
 void DynamicVoronoi::occupyCell(int x, int y)
 {
-  gridMap[x][y] = 1;
+  gridMap[x + y * sizeX] = 1;
   setObstacle(x, y);
 }
 void DynamicVoronoi::clearCell(int x, int y)
 {
-  gridMap[x][y] = 0;
+  gridMap[x + y * sizeX] = 0;
   removeObstacle(x, y);
 }
 
 void DynamicVoronoi::setObstacle(int x, int y)
 {
-  dataCell c = data[x][y];
+  dataCell c = data[x + y * sizeX];
   if (isOccupied(x, y, c))
     return;
 
   addList.push_back(INTPOINT(x, y));
   c.obstX = x;
   c.obstY = y;
-  data[x][y] = c;
+  data[x + y * sizeX] = c;
 }
 
 void DynamicVoronoi::removeObstacle(int x, int y)
 {
-  dataCell c = data[x][y];
+  dataCell c = data[x + y * sizeX];
   if (isOccupied(x, y, c) == false)
     return;
 
@@ -177,7 +155,7 @@ void DynamicVoronoi::removeObstacle(int x, int y)
   c.obstX = invalidObstData;
   c.obstY = invalidObstData;
   c.queueing = bwQueued;
-  data[x][y] = c;
+  data[x + y * sizeX] = c;
 }
 
 void DynamicVoronoi::exchangeObstacles(std::vector<INTPOINT>& points)
@@ -187,7 +165,7 @@ void DynamicVoronoi::exchangeObstacles(std::vector<INTPOINT>& points)
     int x = lastObstacles[i].x;
     int y = lastObstacles[i].y;
 
-    bool v = gridMap[x][y];
+    bool v = gridMap[x + y * sizeX];
     if (v)
       continue;
     removeObstacle(x, y);
@@ -199,7 +177,7 @@ void DynamicVoronoi::exchangeObstacles(std::vector<INTPOINT>& points)
   {
     int x = points[i].x;
     int y = points[i].y;
-    bool v = gridMap[x][y];
+    bool v = gridMap[x + y * sizeX];
     if (v)
       continue;
     setObstacle(x, y);
@@ -216,7 +194,9 @@ void DynamicVoronoi::update(bool updateRealDist)
     INTPOINT p = open.pop();
     int x = p.x;
     int y = p.y;
-    dataCell c = data[x][y];
+    dataCell c = data[x + y * sizeX];
+    // the cell and its neighbours are written, reviving Voronoi neighbours reaches one cell further
+    markChanged(x, y, 2);
 
     if (c.queueing == fwProcessed)
       continue;
@@ -236,10 +216,10 @@ void DynamicVoronoi::update(bool updateRealDist)
           int ny = y + dy;
           if (ny <= 0 || ny >= sizeY - 1)
             continue;
-          dataCell nc = data[nx][ny];
+          dataCell nc = data[nx + ny * sizeX];
           if (nc.obstX != invalidObstData && !nc.needsRaise)
           {
-            if (!isOccupied(nc.obstX, nc.obstY, data[nc.obstX][nc.obstY]))
+            if (!isOccupied(nc.obstX, nc.obstY, data[nc.obstX + nc.obstY * sizeX]))
             {
               open.push(nc.sqdist, INTPOINT(nx, ny));
               nc.queueing = fwQueued;
@@ -249,7 +229,7 @@ void DynamicVoronoi::update(bool updateRealDist)
               if (updateRealDist)
                 nc.dist = INFINITY;
               nc.sqdist = INT_MAX;
-              data[nx][ny] = nc;
+              data[nx + ny * sizeX] = nc;
             }
             else
             {
@@ -257,7 +237,7 @@ void DynamicVoronoi::update(bool updateRealDist)
               {
                 open.push(nc.sqdist, INTPOINT(nx, ny));
                 nc.queueing = fwQueued;
-                data[nx][ny] = nc;
+                data[nx + ny * sizeX] = nc;
               }
             }
           }
@@ -265,9 +245,9 @@ void DynamicVoronoi::update(bool updateRealDist)
       }
       c.needsRaise = false;
       c.queueing = bwProcessed;
-      data[x][y] = c;
+      data[x + y * sizeX] = c;
     }
-    else if (c.obstX != invalidObstData && isOccupied(c.obstX, c.obstY, data[c.obstX][c.obstY]))
+    else if (c.obstX != invalidObstData && isOccupied(c.obstX, c.obstY, data[c.obstX + c.obstY * sizeX]))
     {
       // LOWER
       c.queueing = fwProcessed;
@@ -285,7 +265,7 @@ void DynamicVoronoi::update(bool updateRealDist)
           int ny = y + dy;
           if (ny <= 0 || ny >= sizeY - 1)
             continue;
-          dataCell nc = data[nx][ny];
+          dataCell nc = data[nx + ny * sizeX];
           if (!nc.needsRaise)
           {
             int distx = nx - c.obstX;
@@ -294,7 +274,8 @@ void DynamicVoronoi::update(bool updateRealDist)
             bool overwrite = (newSqDistance < nc.sqdist);
             if (!overwrite && newSqDistance == nc.sqdist)
             {
-              if (nc.obstX == invalidObstData || isOccupied(nc.obstX, nc.obstY, data[nc.obstX][nc.obstY]) == false)
+              if (nc.obstX == invalidObstData ||
+                  isOccupied(nc.obstX, nc.obstY, data[nc.obstX + nc.obstY * sizeX]) == false)
                 overwrite = true;
             }
             if (overwrite)
@@ -313,19 +294,19 @@ void DynamicVoronoi::update(bool updateRealDist)
             {
               checkVoro(x, y, nx, ny, c, nc);
             }
-            data[nx][ny] = nc;
+            data[nx + ny * sizeX] = nc;
           }
         }
       }
     }
-    data[x][y] = c;
+    data[x + y * sizeX] = c;
   }
 }
 
 float DynamicVoronoi::getDistance(int x, int y) const
 {
   if ((x > 0) && (x < sizeX) && (y > 0) && (y < sizeY))
-    return data[x][y].dist;
+    return data[x + y * sizeX].dist;
   else
     return -INFINITY;
 }
@@ -333,7 +314,7 @@ float DynamicVoronoi::getDistance(int x, int y) const
 int DynamicVoronoi::getObstacleX(int x, int y) const
 {
   if ((x > 0) && (x < sizeX) && (y > 0) && (y < sizeY))
-    return data[x][y].obstX;
+    return data[x + y * sizeX].obstX;
   else
     return -1;
 }
@@ -341,17 +322,35 @@ int DynamicVoronoi::getObstacleX(int x, int y) const
 int DynamicVoronoi::getObstacleY(int x, int y) const
 {
   if ((x > 0) && (x < sizeX) && (y > 0) && (y < sizeY))
-    return data[x][y].obstY;
+    return data[x + y * sizeX].obstY;
   else
     return -1;
 }
 
 bool DynamicVoronoi::isVoronoi(int x, int y) const
 {
-  dataCell c = data[x][y];
+  dataCell c = data[x + y * sizeX];
   return (c.voronoi == free || c.voronoi == voronoiKeep);
 }
 
+void DynamicVoronoi::takeChangedArea(int& minX, int& minY, int& maxX, int& maxY)
+{
+  minX = changedMinX;
+  minY = changedMinY;
+  maxX = changedMaxX;
+  maxY = changedMaxY;
+  changedMinX = changedMinY = INT_MAX;
+  changedMaxX = changedMaxY = INT_MIN;
+}
+
+void DynamicVoronoi::markChanged(int x, int y, int margin)
+{
+  changedMinX = std::max(0, std::min(changedMinX, x - margin));
+  changedMinY = std::max(0, std::min(changedMinY, y - margin));
+  changedMaxX = std::min(sizeX - 1, std::max(changedMaxX, x + margin));
+  changedMaxY = std::min(sizeY - 1, std::max(changedMaxY, y + margin));
+}
+
 bool DynamicVoronoi::isVoronoiAlternative(int x, int y) const
 {
   int v = alternativeDiagram[x][y];
@@ -366,7 +365,7 @@ void DynamicVoronoi::commitAndColorize(bool updateRealDist)
     INTPOINT p = addList[i];
     int x = p.x;
     int y = p.y;
-    dataCell c = data[x][y];
+    dataCell c = data[x + y * sizeX];
 
     if (c.queueing != fwQueued)
     {
@@ -377,7 +376,7 @@ void DynamicVoronoi::commitAndColorize(bool updateRealDist)
       c.obstY = y;
       c.queueing = fwQueued;
       c.voronoi = occupied;
-      data[x][y] = c;
+      data[x + y * sizeX] = c;
       open.push(0, INTPOINT(x, y));
     }
   }
@@ -388,7 +387,7 @@ void DynamicVoronoi::commitAndColorize(bool updateRealDist)
     INTPOINT p = removeList[i];
     int x = p.x;
     int y = p.y;
-    dataCell c = data[x][y];
+    dataCell c = data[x + y * sizeX];
 
     if (isOccupied(x, y, c) == true)
       continue;  // obstacle was removed and reinserted
@@ -397,7 +396,7 @@ void DynamicVoronoi::commitAndColorize(bool updateRealDist)
       c.dist = INFINITY;
     c.sqdist = INT_MAX;
     c.needsRaise = true;
-    data[x][y] = c;
+    data[x + y * sizeX] = c;
   }
   removeList.clear();
   addList.clear();
@@ -462,11 +461,11 @@ void DynamicVoronoi::reviveVoroNeighbors(int& x, int& y)
       int ny = y + dy;
       if (ny <= 0 || ny >= sizeY - 1)
         continue;
-      dataCell nc = data[nx][ny];
+      dataCell nc = data[nx + ny * sizeX];
       if (nc.sqdist != INT_MAX && !nc.needsRaise && (nc.voronoi == voronoiKeep || nc.voronoi == voronoiPrune))
       {
         nc.voronoi = free;
-        data[nx][ny] = nc;
+        data[nx + ny * sizeX] = nc;
         pruneQueue.push(INTPOINT(nx, ny));
       }
     }
@@ -475,11 +474,11 @@ void DynamicVoronoi::reviveVoroNeighbors(int& x, int& y)
 
 bool DynamicVoronoi::isOccupied(int x, int y) const
 {
-  dataCell c = data[x][y];
+  dataCell c = data[x + y * sizeX];
   return (c.obstX == x && c.obstY == y);
 }
 
-bool DynamicVoronoi::isOccupied(int& x, int& y, dataCell& c)
+bool DynamicVoronoi::isOccupied(int x, int y, const dataCell& c) const
 {
   return (c.obstX == x && c.obstY == y);
 }
@@ -514,7 +513,7 @@ void DynamicVoronoi::visualize(const char* filename)
         fputc(0, F);
         fputc(255, F);
       }
-      else if (data[x][y].sqdist == 0)
+      else if (data[x + y * sizeX].sqdist == 0)
       {
         fputc(0, F);
         fputc(0, F);
@@ -522,7 +521,7 @@ void DynamicVoronoi::visualize(const char* filename)
       }
       else
       {
-        float f = 80 + (sqrt(data[x][y].sqdist) * 10);
+        float f = 80 + (sqrt(data[x + y * sizeX].sqdist) * 10);
         if (f > 255)
           f = 255;
         if (f < 0)
@@ -546,69 +545,71 @@ void DynamicVoronoi::prune()
     pruneQueue.pop();
     int x = p.x;
     int y = p.y;
+    // the filler writes the cell and its 4-neighbours
+    markChanged(x, y, 1);
 
-    if (data[x][y].voronoi == occupied)
+    if (data[x + y * sizeX].voronoi == occupied)
       continue;
-    if (data[x][y].voronoi == freeQueued)
+    if (data[x + y * sizeX].voronoi == freeQueued)
       continue;
 
-    data[x][y].voronoi = freeQueued;
-    sortedPruneQueue.push(data[x][y].sqdist, p);
+    data[x + y * sizeX].voronoi = freeQueued;
+    sortedPruneQueue.push(data[x + y * sizeX].sqdist, p);
 
     /* tl t tr
        l c r
        bl b br */
 
     dataCell tr, tl, br, bl;
-    tr = data[x + 1][y + 1];
-    tl = data[x - 1][y + 1];
-    br = data[x + 1][y - 1];
-    bl = data[x - 1][y - 1];
+    tr = data[x + 1 + (y + 1) * sizeX];
+    tl = data[x - 1 + (y + 1) * sizeX];
+    br = data[x + 1 + (y - 1) * sizeX];
+    bl = data[x - 1 + (y - 1) * sizeX];
 
     dataCell r, b, t, l;
-    r = data[x + 1][y];
-    l = data[x - 1][y];
-    t = data[x][y + 1];
-    b = data[x][y - 1];
+    r = data[x + 1 + y * sizeX];
+    l = data[x - 1 + y * sizeX];
+    t = data[x + (y + 1) * sizeX];
+    b = data[x + (y - 1) * sizeX];
 
     if (x + 2 < sizeX && r.voronoi == occupied)
     {
       // fill to the right
-      if (tr.voronoi != occupied && br.voronoi != occupied && data[x + 2][y].voronoi != occupied)
+      if (tr.voronoi != occupied && br.voronoi != occupied && data[x + 2 + y * sizeX].voronoi != occupied)
       {
         r.voronoi = freeQueued;
         sortedPruneQueue.push(r.sqdist, INTPOINT(x + 1, y));
-        data[x + 1][y] = r;
+        data[x + 1 + y * sizeX] = r;
       }
     }
     if (x - 2 >= 0 && l.voronoi == occupied)
     {
       // fill to the left
-      if (tl.voronoi != occupied && bl.voronoi != occupied && data[x - 2][y].voronoi != occupied)
+      if (tl.voronoi != occupied && bl.voronoi != occupied && data[x - 2 + y * sizeX].voronoi != occupied)
       {
         l.voronoi = freeQueued;
         sortedPruneQueue.push(l.sqdist, INTPOINT(x - 1, y));
-        data[x - 1][y] = l;
+        data[x - 1 + y * sizeX] = l;
       }
     }
     if (y + 2 < sizeY && t.voronoi == occupied)
     {
       // fill to the top
-      if (tr.voronoi != occupied && tl.voronoi != occupied && data[x][y + 2].voronoi != occupied)
+      if (tr.voronoi != occupied && tl.voronoi != occupied && data[x + (y + 2) * sizeX].voronoi != occupied)
       {
         t.voronoi = freeQueued;
         sortedPruneQueue.push(t.sqdist, INTPOINT(x, y + 1));
-        data[x][y + 1] = t;
+        data[x + (y + 1) * sizeX] = t;
       }
     }
     if (y - 2 >= 0 && b.voronoi == occupied)
     {
       // fill to the bottom
-      if (br.voronoi != occupied && bl.voronoi != occupied && data[x][y - 2].voronoi != occupied)
+      if (br.voronoi != occupied && bl.voronoi != occupied && data[x + (y - 2) * sizeX].voronoi != occupied)
       {
         b.voronoi = freeQueued;
         sortedPruneQueue.push(b.sqdist, INTPOINT(x, y - 1));
-        data[x][y - 1] = b;
+        data[x + (y - 1) * sizeX] = b;
       }
     }
   }
@@ -616,7 +617,7 @@ void DynamicVoronoi::prune()
   while (!sortedPruneQueue.empty())
   {
     INTPOINT p = sortedPruneQueue.pop();
-    dataCell c = data[p.x][p.y];
+    dataCell c = data[p.x + p.y * sizeX];
     int v = c.voronoi;
     if (v != freeQueued && v != voronoiRetry)
     {  // || v>free || v==voronoiPrune || v==voronoiKeep) {
@@ -635,7 +636,7 @@ void DynamicVoronoi::prune()
       //      printf("RETRY %d %d\n", x, sizeY-1-y);
       pruneQueue.push(p);
     }
-    data[p.x][p.y] = c;
+    data[p.x + p.y * sizeX] = c;
 
     if (sortedPruneQueue.empty())
     {
@@ -643,7 +644,7 @@ void DynamicVoronoi::prune()
       {
         INTPOINT p = pruneQueue.front();
         pruneQueue.pop();
-        sortedPruneQueue.push(data[p.x][p.y].sqdist, p);
+        sortedPruneQueue.push(data[p.x + p.y * sizeX].sqdist, p);
       }
     }
   }
@@ -667,9 +668,10 @@ void DynamicVoronoi::updateAlternativePrunedDiagram()
   {
     for (int y = 1; y < sizeY - 1; y++)
     {
-      dataCell& c = data[x][y];
+      dataCell& c = data[x + y * sizeX];
       alternativeDiagram[x][y] = c.voronoi;
-      if (c.voronoi <= free)
+      // cells no obstacle reached have no distance to sort by
+      if (c.voronoi <= free && c.sqdist != INT_MAX)
       {
         sortedPruneQueue.push(c.sqdist, INTPOINT(x, y));
         end_cells.push(INTPOINT(x, y));
@@ -681,10 +683,10 @@ void DynamicVoronoi::updateAlternativePrunedDiagram()
   {
     for (int y = 1; y < sizeY - 1; y++)
     {
-      if (getNumVoronoiNeighborsAlternative(x, y) >= 3)
+      if (getNumVoronoiNeighborsAlternative(x, y) >= 3 && data[x + y * sizeX].sqdist != INT_MAX)
       {
         alternativeDiagram[x][y] = voronoiKeep;
-        sortedPruneQueue.push(data[x][y].sqdist, INTPOINT(x, y));
+        sortedPruneQueue.push(data[x + y * sizeX].sqdist, INTPOINT(x, y));
         end_cells.push(INTPOINT(x, y));
       }
     }
@@ -694,10 +696,10 @@ void DynamicVoronoi::updateAlternativePrunedDiagram()
   {
     for (int y = 1; y < sizeY - 1; y++)
     {
-      if (getNumVoronoiNeighborsAlternative(x, y) >= 3)
+      if (getNumVoronoiNeighborsAlternative(x, y) >= 3 && data[x + y * sizeX].sqdist != INT_MAX)
       {
         alternativeDiagram[x][y] = voronoiKeep;
-        sortedPruneQueue.push(data[x][y].sqdist, INTPOINT(x, y));
+        sortedPruneQueue.push(data[x + y * sizeX].sqdist, INTPOINT(x, y));
         end_cells.push(INTPOINT(x, y));
       }
     }
@@ -857,7 +859,7 @@ DynamicVoronoi::markerMatchResult DynamicVoronoi::markerMatch(int x, int y)
       if (dx || dy)
       {
         nx = x + dx;
-        dataCell nc = data[nx][ny];
+        dataCell nc = data[nx + ny * sizeX];
         int v = nc.voronoi;
         bool b = (v <= free && v != voronoiPrune);
         //	if (v==occupied) obstacleCount++;
@@ -889,7 +891,7 @@ DynamicVoronoi::markerMatchResult DynamicVoronoi::markerMatch(int x, int y)
     return keep;
 
   // keep voro cells inside of blocks and retry later
-  if (voroCount >= 5 && voroCountFour >= 3 && data[x][y].voronoi != voronoiRetry)
+  if (voroCount >= 5 && voroCountFour >= 3 && data[x + y * sizeX].voronoi != voronoiRetry)
   {
     return retry;
   }
@@ -0,0 +1,179 @@
+/******************************************************************************
+ * Copyright (c) 2023, NKU Mobile & Flying Robotics Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+
+#include "voronoi_buffers.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <limits>
+#include <thread>  // NOLINT
+
+namespace costmap_2d
+{
+double VoronoiBuffer::distance(double wx, double wy) const
+{
+  double grad_x, grad_y;
+  return distance(wx, wy, grad_x, grad_y);
+}
+
+double VoronoiBuffer::distance(double wx, double wy, double& grad_x, double& grad_y) const
+{
+  grad_x = grad_y = 0.0;
+  const int size_x = static_cast<int>(voronoi.getSizeX());
+  const int size_y = static_cast<int>(voronoi.getSizeY());
+  if (size_x < 4 || size_y < 4)
+  {
+    return std::numeric_limits<double>::infinity();
+  }
+
+  // the four cell centres around the point, the border cells of the diagram hold no distances
+  const double fx = std::min(std::max((wx - origin_x) / resolution - 0.5, 1.0), size_x - 2.0);
+  const double fy = std::min(std::max((wy - origin_y) / resolution - 0.5, 1.0), size_y - 2.0);
+  const int x0 = std::min(static_cast<int>(fx), size_x - 3);
+  const int y0 = std::min(static_cast<int>(fy), size_y - 3);
+  const double tx = fx - x0, ty = fy - y0;
+
+  const double d00 = voronoi.getDistance(x0, y0);
+  const double d10 = voronoi.getDistance(x0 + 1, y0);
+  const double d01 = voronoi.getDistance(x0, y0 + 1);
+  const double d11 = voronoi.getDistance(x0 + 1, y0 + 1);
+  if (!std::isfinite(d00) || !std::isfinite(d10) || !std::isfinite(d01) || !std::isfinite(d11))
+  {
+    return std::numeric_limits<double>::infinity();
+  }
+
+  // distances are kept in cells, the gradient is the same in cells and meters
+  grad_x = (d10 - d00) * (1.0 - ty) + (d11 - d01) * ty;
+  grad_y = (d01 - d00) * (1.0 - tx) + (d11 - d10) * tx;
+  const double d = (d00 * (1.0 - tx) + d10 * tx) * (1.0 - ty) + (d01 * (1.0 - tx) + d11 * tx) * ty;
+  return d * resolution;
+}
+
+VoronoiBuffers::VoronoiBuffers(bool with_skeleton) : with_skeleton_(with_skeleton)
+{
+}
+
+void VoronoiBuffers::reset(int size_x, int size_y)
+{
+  size_x_ = size_x;
+  size_y_ = size_y;
+  for (int i = 0; i < 2; i++)
+  {
+    slots_[i] = std::make_shared<BufferSlot>();
+    slots_[i]->buffer.voronoi.initializeEmpty(size_x, size_y);
+    lag_[i].clear();
+  }
+  target_.assign(size_x * size_y, 0);
+  back_ = 0;
+}
+
+void VoronoiBuffers::apply(const std::vector<CellChange>& changes, double resolution, double origin_x,
+                           double origin_y, int& min_x, int& min_y, int& max_x, int& max_y)
+{
+  // the back buffer was published before, it is written once the readers still holding it let go
+  const std::shared_ptr<BufferSlot> slot = slots_[back_];
+  while (!slot->released.load(std::memory_order_acquire))
+  {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  VoronoiBuffer* back = &slot->buffer;
+
+  // the changes this buffer missed while the other one was written, then the new ones. A cell may toggle several
+  // times within them, only its last state is handed to the diagram, which takes one change per cell and update
+  touched_.clear();
+  const std::vector<CellChange>& lag = lag_[back_];
+  for (const std::vector<CellChange>* batch : { &lag, &changes })
+  {
+    for (const CellChange& c : *batch)
+    {
+      if (!target_[c.index])
+      {
+        touched_.push_back(c.index);
+      }
+      target_[c.index] = c.occupied ? 2 : 1;
+    }
+  }
+  DynamicVoronoi& voronoi = back->voronoi;
+  for (const int index : touched_)
+  {
+    const int x = index % size_x_, y = index / size_x_;
+    const bool occupied = target_[index] == 2;
+    target_[index] = 0;
+    if (occupied && !voronoi.isOccupied(x, y))
+    {
+      voronoi.occupyCell(x, y);
+    }
+    else if (!occupied && voronoi.isOccupied(x, y))
+    {
+      voronoi.clearCell(x, y);
+    }
+  }
+  voronoi.update();
+
+  // re-trace the skeleton graph within the changed part of the diagram
+  if (with_skeleton_)
+  {
+    voronoi.prune();
+  }
+  voronoi.takeChangedArea(min_x, min_y, max_x, max_y);
+  if (with_skeleton_ && min_x <= max_x)
+  {
+    back->skeleton.update(voronoi, min_x, min_y, max_x, max_y);
+  }
+
+  // publish the buffer, the other one becomes the back buffer and owes the changes
+  back->version = ++version_;
+  back->resolution = resolution;
+  back->origin_x = origin_x;
+  back->origin_y = origin_y;
+  lag_[back_].clear();
+  lag_[1 - back_].insert(lag_[1 - back_].end(), changes.begin(), changes.end());
+  slot->released.store(false, std::memory_order_relaxed);
+  std::atomic_store(&front_, std::shared_ptr<const VoronoiBuffer>(back, [slot](const VoronoiBuffer*) {
+                      slot->released.store(true, std::memory_order_release);
+                    }));
+  back_ = 1 - back_;
+}
+
+std::shared_ptr<const VoronoiBuffer> VoronoiBuffers::front() const
+{
+  return std::atomic_load(&front_);
+}
+
+std::uint64_t VoronoiBuffers::version() const
+{
+  const std::shared_ptr<const VoronoiBuffer> buffer = std::atomic_load(&front_);
+  return buffer ? buffer->version : 0;
+}
+
+}  // namespace costmap_2d
@@ -31,6 +31,7 @@
 
 #include "voronoi_layer.h"
 
+#include <algorithm>
 #include <chrono>  // NOLINT
 
 #include "pluginlib/class_list_macros.h"
@@ -39,17 +40,33 @@ PLUGINLIB_EXPORT_CLASS(costmap_2d::VoronoiLayer, costmap_2d::Layer)
 
 namespace costmap_2d
 {
+VoronoiLayer::~VoronoiLayer()
+{
+  {
+    boost::unique_lock<boost::mutex> lock(queue_mutex_);
+    stop_ = true;
+  }
+  queue_cond_.notify_one();
+  if (worker_.joinable())
+  {
+    worker_.join();
+  }
+}
+
 void VoronoiLayer::onInitialize()
 {
   ros::NodeHandle nh("~/" + name_);
   current_ = true;
 
   voronoi_grid_pub_ = nh.advertise<nav_msgs::OccupancyGrid>("voronoi_grid", 1);
+  nh.param("publish_frequency", publish_frequency_, 1.0);
 
   dsrv_ = std::make_unique<dynamic_reconfigure::Server<costmap_2d::GenericPluginConfig>>(nh);
   dynamic_reconfigure::Server<costmap_2d::GenericPluginConfig>::CallbackType cb =
       boost::bind(&VoronoiLayer::reconfigureCB, this, _1, _2);
   dsrv_->setCallback(cb);
+
+  worker_ = boost::thread(&VoronoiLayer::workerLoop, this);
 }
 
 void VoronoiLayer::reconfigureCB(const costmap_2d::GenericPluginConfig& config, uint32_t level)
@@ -57,14 +74,14 @@ void VoronoiLayer::reconfigureCB(const costmap_2d::GenericPluginConfig& config,
   enabled_ = config.enabled;
 }
 
-const DynamicVoronoi& VoronoiLayer::getVoronoi() const
+std::shared_ptr<const VoronoiBuffer> VoronoiLayer::getVoronoiBuffer() const
 {
-  return voronoi_;
+  return buffers_.front();
 }
 
-boost::mutex& VoronoiLayer::getMutex()
+std::uint64_t VoronoiLayer::getVersion() const
 {
-  return mutex_;
+  return buffers_.version();
 }
 
 void VoronoiLayer::updateBounds(double robot_x, double robot_y, double robot_yaw, double* min_x, double* min_y,
@@ -74,6 +91,8 @@ void VoronoiLayer::updateBounds(double robot_x, double robot_y, double robot_yaw
   {
     return;
   }
+
+  // no costs of its own, updateCosts() follows the bounds of the layers it reads
 }
 
 void VoronoiLayer::outlineMap(unsigned char* costarr, int nx, int ny, unsigned char value)
@@ -104,92 +123,212 @@ void VoronoiLayer::updateCosts(costmap_2d::Costmap2D& master_grid, int min_i, in
 {
   if (!enabled_)
   {
+    // changes made while disabled are not tracked
+    full_update_ = true;
     return;
   }
 
-  boost::unique_lock<boost::mutex> lock(mutex_);
-
   unsigned int size_x = master_grid.getSizeInCellsX();
   unsigned int size_y = master_grid.getSizeInCellsY();
   outlineMap(master_grid.getCharMap(), size_x, size_y, costmap_2d::LETHAL_OBSTACLE);
 
+  // a new size starts the worker over with empty diagrams
+  bool reset = false;
   if (last_size_x_ != size_x || last_size_y_ != size_y)
   {
-    voronoi_.initializeEmpty(size_x, size_y);
+    occupied_.assign(size_x * size_y, 0);
 
     last_size_x_ = size_x;
     last_size_y_ = size_y;
+    full_update_ = true;
+    reset = true;
+  }
+
+  // a rolling window shifts the cells of the master grid
+  if (last_origin_x_ != master_grid.getOriginX() || last_origin_y_ != master_grid.getOriginY())
+  {
+    last_origin_x_ = master_grid.getOriginX();
+    last_origin_y_ = master_grid.getOriginY();
+    full_update_ = true;
+  }
+
+  // cells outside the bounds kept their cost since the last cycle, only the dirty rectangle is diffed
+  if (full_update_)
+  {
+    min_i = 0;
+    min_j = 0;
+    max_i = size_x;
+    max_j = size_y;
+    full_update_ = false;
   }
+  min_i = std::max(min_i, 0);
+  min_j = std::max(min_j, 0);
+  max_i = std::min(max_i, static_cast<int>(size_x));
+  max_j = std::min(max_j, static_cast<int>(size_y));
+
+  // start timing
+  const auto start_timestamp = std::chrono::system_clock::now();
 
-  std::vector<IntPoint> new_free_cells, new_occupied_cells;
-  for (unsigned int j = 0; j < size_y; ++j)
+  const unsigned char* costs = master_grid.getCharMap();
+  changes_.clear();
+  for (int j = min_j; j < max_j; ++j)
   {
-    for (unsigned int i = 0; i < size_x; ++i)
+    const int row = j * size_x;
+    for (int i = min_i; i < max_i; ++i)
     {
-      if (voronoi_.isOccupied(i, j) && master_grid.getCost(i, j) == costmap_2d::FREE_SPACE)
+      const unsigned char cost = costs[row + i];
+      unsigned char& occupied = occupied_[row + i];
+      if (occupied && cost == costmap_2d::FREE_SPACE)
       {
-        new_free_cells.push_back(IntPoint(i, j));
+        occupied = 0;
+        changes_.push_back({ row + i, false });
       }
-
-      if (!voronoi_.isOccupied(i, j) && master_grid.getCost(i, j) == costmap_2d::LETHAL_OBSTACLE)
-      // if (!voronoi_.isOccupied(i, j) && master_grid.getCost(i, j) >= 128)
+      else if (!occupied && cost == costmap_2d::LETHAL_OBSTACLE)
       {
-        new_occupied_cells.push_back(IntPoint(i, j));
+        occupied = 1;
+        changes_.push_back({ row + i, true });
       }
     }
   }
 
-  for (size_t i = 0; i < new_free_cells.size(); ++i)
+  // hand the changes over, the diagram is computed by the worker
+  if (reset || !changes_.empty())
   {
-    voronoi_.clearCell(new_free_cells[i].x, new_free_cells[i].y);
+    {
+      boost::unique_lock<boost::mutex> lock(queue_mutex_);
+      if (reset)
+      {
+        queued_.clear();
+        queued_reset_ = true;
+        queued_size_x_ = size_x;
+        queued_size_y_ = size_y;
+      }
+      queued_.insert(queued_.end(), changes_.begin(), changes_.end());
+      queued_resolution_ = master_grid.getResolution();
+      queued_origin_x_ = master_grid.getOriginX();
+      queued_origin_y_ = master_grid.getOriginY();
+    }
+    queue_cond_.notify_one();
   }
 
-  for (size_t i = 0; i < new_occupied_cells.size(); ++i)
+  // end timing
+  const auto end_timestamp = std::chrono::system_clock::now();
+  const std::chrono::duration<double> diff = end_timestamp - start_timestamp;
+  ROS_DEBUG("Runtime=%.3fms, %d cells changed in [%d, %d) x [%d, %d).", diff.count() * 1e3,
+            static_cast<int>(changes_.size()), min_i, max_i, min_j, max_j);
+}
+
+void VoronoiLayer::workerLoop()
+{
+  std::vector<CellChange> changes;
+  while (true)
   {
-    voronoi_.occupyCell(new_occupied_cells[i].x, new_occupied_cells[i].y);
-  }
+    bool reset;
+    int size_x, size_y;
+    double resolution, origin_x, origin_y;
+    {
+      boost::unique_lock<boost::mutex> lock(queue_mutex_);
 
-  // start timing
-  const auto start_timestamp = std::chrono::system_clock::now();
+      // woken up by new changes, or at the publication rate to serve new subscribers
+      if (!stop_ && queued_.empty() && !queued_reset_)
+      {
+        const double period = publish_frequency_ > 0.0 ? 1.0 / publish_frequency_ : 1.0;
+        queue_cond_.timed_wait(lock, boost::posix_time::microseconds(static_cast<int64_t>(period * 1e6)));
+      }
+      if (stop_)
+      {
+        return;
+      }
 
-  voronoi_.update();
-  voronoi_.prune();
+      changes.swap(queued_);
+      queued_.clear();
+      reset = queued_reset_;
+      queued_reset_ = false;
+      size_x = queued_size_x_;
+      size_y = queued_size_y_;
+      resolution = queued_resolution_;
+      origin_x = queued_origin_x_;
+      origin_y = queued_origin_y_;
+    }
 
-  // end timing
-  const auto end_timestamp = std::chrono::system_clock::now();
-  const std::chrono::duration<double> diff = end_timestamp - start_timestamp;
-  ROS_DEBUG("Runtime=%.3fms.", diff.count() * 1e3);
+    // fresh buffers, the old ones are released by the last reader holding them
+    if (reset)
+    {
+      buffers_.reset(size_x, size_y);
+    }
 
-  publishVoronoiGrid(master_grid);
+    if (!changes.empty() || reset)
+    {
+      // start timing
+      const auto start_timestamp = std::chrono::system_clock::now();
+
+      int min_x, min_y, max_x, max_y;
+      buffers_.apply(changes, resolution, origin_x, origin_y, min_x, min_y, max_x, max_y);
+      if (min_x <= max_x)
+      {
+        pending_min_x_ = std::min(pending_min_x_, min_x);
+        pending_min_y_ = std::min(pending_min_y_, min_y);
+        pending_max_x_ = std::max(pending_max_x_, max_x);
+        pending_max_y_ = std::max(pending_max_y_, max_y);
+      }
+
+      // end timing
+      const auto end_timestamp = std::chrono::system_clock::now();
+      const std::chrono::duration<double> diff = end_timestamp - start_timestamp;
+      const std::shared_ptr<const VoronoiBuffer> front = buffers_.front();
+      ROS_DEBUG("Voronoi version %lu: %d cells changed, runtime=%.3fms, skeleton: %d nodes, %d edges.",
+                static_cast<unsigned long>(front->version), static_cast<int>(changes.size()), diff.count() * 1e3,
+                front->skeleton.numNodes(), front->skeleton.numEdges());
+    }
+
+    // the area changed since the last publication is sent once the period has passed, or to a new subscriber
+    const std::shared_ptr<const VoronoiBuffer> front = buffers_.front();
+    const unsigned int subscribers = voronoi_grid_pub_.getNumSubscribers();
+    last_subscribers_ = std::min(last_subscribers_, subscribers);
+    const bool due = publish_frequency_ > 0.0 &&
+                     (ros::WallTime::now() - last_publish_time_).toSec() >= 1.0 / publish_frequency_;
+    if (front && due && (pending_min_x_ <= pending_max_x_ || subscribers > last_subscribers_) && subscribers > 0)
+    {
+      publishVoronoiGrid(*front, pending_min_x_, pending_min_y_, pending_max_x_, pending_max_y_);
+      last_publish_time_ = ros::WallTime::now();
+      last_subscribers_ = subscribers;
+      pending_min_x_ = pending_min_y_ = INT_MAX;
+      pending_max_x_ = pending_max_y_ = INT_MIN;
+    }
+  }
 }
 
-void VoronoiLayer::publishVoronoiGrid(const costmap_2d::Costmap2D& master_grid)
+void VoronoiLayer::publishVoronoiGrid(const VoronoiBuffer& buffer, int min_x, int min_y, int max_x, int max_y)
 {
-  unsigned int nx = master_grid.getSizeInCellsX();
-  unsigned int ny = master_grid.getSizeInCellsY();
+  const DynamicVoronoi& voronoi = buffer.voronoi;
+  unsigned int nx = voronoi.getSizeX();
+  unsigned int ny = voronoi.getSizeY();
+
+  // Publish Whole Grid, refreshed within the changed area
+  nav_msgs::OccupancyGrid& grid = voronoi_grid_;
+  grid.info.resolution = buffer.resolution;
+  grid.info.origin.position.x = buffer.origin_x;
+  grid.info.origin.position.y = buffer.origin_y;
+  if (grid.info.width != nx || grid.info.height != ny)
+  {
+    grid.info.width = nx;
+    grid.info.height = ny;
+    grid.data.assign(nx * ny, 0);
+    min_x = min_y = 0;
+    max_x = nx - 1;
+    max_y = ny - 1;
+  }
 
-  double resolution = master_grid.getResolution();
-  nav_msgs::OccupancyGrid grid;
-  // Publish Whole Grid
   grid.header.frame_id = "map";
   grid.header.stamp = ros::Time::now();
-  grid.info.resolution = resolution;
-
-  grid.info.width = nx;
-  grid.info.height = ny;
-
-  grid.info.origin.position.x = master_grid.getOriginX();
-  grid.info.origin.position.y = master_grid.getOriginY();
   grid.info.origin.position.z = 0.0;
   grid.info.origin.orientation.w = 1.0;
 
-  grid.data.resize(nx * ny);
-
-  for (unsigned int x = 0; x < nx; x++)
+  for (int y = min_y; y <= max_y; y++)
   {
-    for (unsigned int y = 0; y < ny; y++)
+    for (int x = min_x; x <= max_x; x++)
     {
-      if (voronoi_.isVoronoi(x, y))
+      if (voronoi.isVoronoi(x, y))
       {
         grid.data[x + y * nx] = 128;
       }
@@ -0,0 +1,412 @@
+/******************************************************************************
+ * Copyright (c) 2023, NKU Mobile & Flying Robotics Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 'AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *****************************************************************************/
+
+#include "voronoi_skeleton.h"
+
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+
+namespace costmap_2d
+{
+namespace
+{
+const int dx8[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+const int dy8[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+
+//! appends cell c to a polyline of 8-connected cells ending in k0, k1, a corner k1 between two neighbours is cut
+void extend(int c, int size_x, int& k0, int& k1, double& length)
+{
+  auto step = [size_x](int a, int b) { return (a % size_x != b % size_x && a / size_x != b / size_x) ? M_SQRT2 : 1.0; };
+  if (k0 != -1 && std::abs(k0 % size_x - c % size_x) <= 1 && std::abs(k0 / size_x - c / size_x) <= 1)
+  {
+    length += step(k0, c) - step(k0, k1);
+  }
+  else
+  {
+    length += step(k1, c);
+    k0 = k1;
+  }
+  k1 = c;
+}
+}  // namespace
+
+void VoronoiSkeleton::update(const DynamicVoronoi& voronoi)
+{
+  update(voronoi, 0, 0, static_cast<int>(voronoi.getSizeX()) - 1, static_cast<int>(voronoi.getSizeY()) - 1);
+}
+
+void VoronoiSkeleton::update(const DynamicVoronoi& voronoi, int min_x, int min_y, int max_x, int max_y)
+{
+  voronoi_ = &voronoi;
+  const int size_x = static_cast<int>(voronoi.getSizeX());
+  const int size_y = static_cast<int>(voronoi.getSizeY());
+  if (size_x != size_x_ || size_y != size_y_)
+  {
+    min_x = min_y = 0;
+    max_x = size_x - 1;
+    max_y = size_y - 1;
+    size_x_ = size_x;
+    size_y_ = size_y;
+    member_.assign(size_x_ * size_y_, 0);
+    owner_.assign(size_x_ * size_y_, -1);
+    mark_.assign(size_x_ * size_y_, 0);
+    nodes_.clear();
+    edges_.clear();
+    free_nodes_.clear();
+    free_edges_.clear();
+    num_nodes_ = num_edges_ = 0;
+  }
+
+  if (++epoch_ == 0)
+  {
+    std::fill(mark_.begin(), mark_.end(), 0);
+    epoch_ = 1;
+  }
+  candidates_.clear();
+  seeds_.clear();
+  refresh_.clear();
+
+  // cells which joined or left the diagram, and their neighbours whose degree changed with them
+  min_x = std::max(min_x, 0);
+  min_y = std::max(min_y, 0);
+  max_x = std::min(max_x, size_x_ - 1);
+  max_y = std::min(max_y, size_y_ - 1);
+  for (int y = min_y; y <= max_y; y++)
+  {
+    for (int x = min_x; x <= max_x; x++)
+    {
+      const int c = x + y * size_x_;
+      const unsigned char v = voronoi.isVoronoi(x, y) ? 1 : 0;
+      if (v == member_[c])
+      {
+        // a cell staying in the diagram may still have moved closer to or away from an obstacle
+        if (v && owner_[c] >= 0)
+          refresh_.push_back(owner_[c]);
+        else if (v && owner_[c] <= -2)
+          refresh_.insert(refresh_.end(), nodes_[-owner_[c] - 2].edges.begin(), nodes_[-owner_[c] - 2].edges.end());
+        continue;
+      }
+      member_[c] = v;
+      addCandidate(c);
+      for (int k = 0; k < 8; k++)
+      {
+        const int nx = x + dx8[k], ny = y + dy8[k];
+        if (nx >= 0 && nx < size_x_ && ny >= 0 && ny < size_y_)
+          addCandidate(nx + ny * size_x_);
+      }
+    }
+  }
+
+  // drop the nodes and edges touching a candidate, the cells of dropped edges become candidates as well
+  for (size_t i = 0; i < candidates_.size(); i++)
+  {
+    const int owner = owner_[candidates_[i]];
+    if (owner >= 0)
+      removeEdge(owner);
+    else if (owner <= -2)
+      removeNode(-owner - 2);
+  }
+
+  // junctions and end points among the candidates
+  bool in[8];
+  for (const int c : candidates_)
+    if (member_[c] && owner_[c] == -1 && !chain(c, in))
+      seeds_.push_back(addNode(c));
+
+  // trace the chains leaving every node which got or lost edges, tracing may end chains at new nodes
+  size_t traced = 0;
+  for (; traced < seeds_.size(); traced++)
+    if (nodes_[seeds_[traced]].alive)
+      traceFrom(seeds_[traced]);
+
+  // cells left are loops without any junction, one of their cells becomes a node
+  for (size_t i = 0; i < candidates_.size(); i++)
+  {
+    const int c = candidates_[i];
+    if (member_[c] && owner_[c] == -1)
+    {
+      seeds_.push_back(addNode(c));
+      for (; traced < seeds_.size(); traced++)
+        if (nodes_[seeds_[traced]].alive)
+          traceFrom(seeds_[traced]);
+    }
+  }
+
+  // edges kept through the box, the ones traced above are refreshed once more at no harm
+  std::sort(refresh_.begin(), refresh_.end());
+  refresh_.erase(std::unique(refresh_.begin(), refresh_.end()), refresh_.end());
+  for (const int e : refresh_)
+    if (edges_[e].alive)
+      refreshClearance(e);
+
+  last_update_cells_ = static_cast<int>(candidates_.size());
+  voronoi_ = nullptr;
+}
+
+int VoronoiSkeleton::nodeAt(int x, int y) const
+{
+  const int owner = owner_[x + y * size_x_];
+  return owner <= -2 ? -owner - 2 : -1;
+}
+
+int VoronoiSkeleton::edgeAt(int x, int y) const
+{
+  const int owner = owner_[x + y * size_x_];
+  return owner >= 0 ? owner : -1;
+}
+
+int VoronoiSkeleton::numNodes() const
+{
+  return num_nodes_;
+}
+
+int VoronoiSkeleton::numEdges() const
+{
+  return num_edges_;
+}
+
+void VoronoiSkeleton::addCandidate(int c)
+{
+  if (mark_[c] == epoch_)
+    return;
+  mark_[c] = epoch_;
+  candidates_.push_back(c);
+}
+
+void VoronoiSkeleton::removeEdge(int e)
+{
+  Edge& edge = edges_[e];
+  for (const int c : edge.cells)
+  {
+    owner_[c] = -1;
+    addCandidate(c);
+  }
+
+  // the end nodes stay, their remaining chains are traced again
+  for (const int n : { edge.from, edge.to })
+  {
+    std::vector<int>& incident = nodes_[n].edges;
+    incident.erase(std::remove(incident.begin(), incident.end(), e), incident.end());
+    seeds_.push_back(n);
+  }
+
+  edge.cells.clear();
+  edge.alive = false;
+  free_edges_.push_back(e);
+  num_edges_--;
+}
+
+void VoronoiSkeleton::removeNode(int n)
+{
+  while (!nodes_[n].edges.empty())
+    removeEdge(nodes_[n].edges.back());
+
+  owner_[nodes_[n].x + nodes_[n].y * size_x_] = -1;
+  nodes_[n].alive = false;
+  free_nodes_.push_back(n);
+  num_nodes_--;
+}
+
+int VoronoiSkeleton::addNode(int c)
+{
+  int n;
+  if (!free_nodes_.empty())
+  {
+    n = free_nodes_.back();
+    free_nodes_.pop_back();
+  }
+  else
+  {
+    n = static_cast<int>(nodes_.size());
+    nodes_.emplace_back();
+  }
+
+  Node& node = nodes_[n];
+  node.x = c % size_x_;
+  node.y = c / size_x_;
+  node.edges.clear();
+  node.alive = true;
+  owner_[c] = -(n + 2);
+  num_nodes_++;
+  return n;
+}
+
+void VoronoiSkeleton::traceFrom(int n)
+{
+  const int start = nodes_[n].x + nodes_[n].y * size_x_;
+
+  // orthogonal neighbours first, a diagonal one is usually reached through them
+  for (const int k : { 0, 2, 4, 6, 1, 3, 5, 7 })
+  {
+    const int x = nodes_[n].x + dx8[k], y = nodes_[n].y + dy8[k];
+    if (x < 0 || x >= size_x_ || y < 0 || y >= size_y_ || !member_[x + y * size_x_])
+      continue;
+
+    // a chain already traced from its other end, or from this node in the other direction
+    int cur = x + y * size_x_;
+    if (owner_[cur] >= 0 && (edges_[owner_[cur]].from == n || edges_[owner_[cur]].to == n))
+      continue;
+
+    // a chain passing by the node is split there, its parts are traced again from their ends
+    if (owner_[cur] >= 0)
+    {
+      removeEdge(owner_[cur]);
+      seeds_.push_back(addNode(cur));
+    }
+
+    // two adjacent nodes are joined by an edge without cells, once
+    if (owner_[cur] <= -2)
+    {
+      const int m = -owner_[cur] - 2;
+      if (m == n)
+        continue;
+      bool joined = false;
+      for (const int e : nodes_[n].edges)
+        joined = joined || (edges_[e].cells.empty() && (edges_[e].from == m || edges_[e].to == m));
+      if (joined)
+        continue;
+    }
+
+    int e;
+    if (!free_edges_.empty())
+    {
+      e = free_edges_.back();
+      free_edges_.pop_back();
+    }
+    else
+    {
+      e = static_cast<int>(edges_.size());
+      edges_.emplace_back();
+    }
+
+    std::vector<int> cells;
+    double length = 0.0;
+    int k0 = -1, k1 = start;
+    extend(cur, size_x_, k0, k1, length);
+    float clearance = std::min(voronoi_->getDistance(nodes_[n].x, nodes_[n].y), voronoi_->getDistance(x, y));
+    int prev = start;
+
+    // walk along chain cells until a node
+    while (owner_[cur] > -2)
+    {
+      owner_[cur] = e;
+      cells.push_back(cur);
+
+      const int next = forward(cur, prev);
+
+      // a cell which turned out to be no chain cell ends the edge as a new node
+      if (next == -1 || owner_[next] >= 0)
+      {
+        cells.pop_back();
+        owner_[cur] = -1;
+        seeds_.push_back(addNode(cur));
+        break;
+      }
+
+      extend(next, size_x_, k0, k1, length);
+      prev = cur;
+      cur = next;
+      clearance = std::min(clearance, voronoi_->getDistance(cur % size_x_, cur / size_x_));
+    }
+
+    Edge& edge = edges_[e];
+    edge.from = n;
+    edge.to = -owner_[cur] - 2;
+    edge.cells = std::move(cells);
+    edge.length = length;
+    edge.clearance = clearance;
+    edge.alive = true;
+    num_edges_++;
+
+    nodes_[n].edges.push_back(e);
+    if (edge.to != n)
+      nodes_[edge.to].edges.push_back(e);
+  }
+}
+
+void VoronoiSkeleton::refreshClearance(int e)
+{
+  Edge& edge = edges_[e];
+  float clearance = std::min(voronoi_->getDistance(nodes_[edge.from].x, nodes_[edge.from].y),
+                             voronoi_->getDistance(nodes_[edge.to].x, nodes_[edge.to].y));
+  for (const int c : edge.cells)
+    clearance = std::min(clearance, voronoi_->getDistance(c % size_x_, c / size_x_));
+  edge.clearance = clearance;
+}
+
+bool VoronoiSkeleton::chain(int c, bool* in) const
+{
+  const int x = c % size_x_, y = c / size_x_;
+  int count = 0;
+  for (int k = 0; k < 8; k++)
+  {
+    const int nx = x + dx8[k], ny = y + dy8[k];
+    in[k] = nx >= 0 && nx < size_x_ && ny >= 0 && ny < size_y_ && member_[nx + ny * size_x_];
+    count += in[k] ? 1 : 0;
+  }
+
+  // two runs of diagram cells around the ring, one branch each, a run of two cells is a staircase step
+  int runs = 0;
+  for (int k = 0; k < 8; k++)
+    runs += (!in[k] && in[(k + 1) % 8]) ? 1 : 0;
+  return runs == 2 && count <= 3;
+}
+
+int VoronoiSkeleton::forward(int c, int prev) const
+{
+  bool in[8];
+  if (!chain(c, in))
+    return -1;
+
+  const int x = c % size_x_, y = c / size_x_;
+  int p = -1;
+  for (int k = 0; k < 8; k++)
+    if (x + dx8[k] + (y + dy8[k]) * size_x_ == prev)
+      p = k;
+  if (p == -1)
+    return -1;
+
+  // the run holding the previous cell, the other run leads on
+  bool back[8] = { false };
+  for (int k = p; in[k] && !back[k]; k = (k + 1) % 8)
+    back[k] = true;
+  for (int k = p; in[k] && (k == p || !back[k]); k = (k + 7) % 8)
+    back[k] = true;
+
+  int dir = -1;
+  for (int k = 0; k < 8; k++)
+    if (in[k] && !back[k] && (dir == -1 || (dir % 2 == 1 && k % 2 == 0)))
+      dir = k;
+  return dir == -1 ? -1 : x + dx8[dir] + (y + dy8[dir]) * size_x_;
+}
+
+}  // namespace costmap_2d